@@ -0,0 +1,1103 @@
+//
+// SlicerSnake
+// bench.cpp
+// Benchmarks of the simulation hot paths
+//
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib> // strtod
+#include <cstring> // strcmp, strstr
+#include <list>
+#include <string>
+#include <vector>
+
+#include <fcntl.h> // open
+#include <sys/socket.h>
+#include <unistd.h> // close, getpid
+
+#include "bitboard.h"
+#include "board.h"
+#include "classic_batch.h"
+#include "display.h"
+#include "display_ansi.h"
+#include "display_delta.h"
+#include "display_headless.h"
+#include "display_threaded.h"
+#include "food_field.h"
+#include "game.h"
+#include "game_server.h"
+#include "mcts.h"
+#include "net.h"
+#include "pathfinder.h"
+#include "random.h"
+#include "snake.h"
+
+
+
+namespace
+{
+
+using ssnake::coordType;
+using ssnake::Vec2;
+
+struct BenchResult
+{
+    std::string name;
+    unsigned long long operations;
+    double nsPerOp;
+};
+
+
+
+struct BenchOptions
+{
+    // Minimum time spent on every benchmark
+    double minSeconds = 0.25;
+    // Only benchmarks whose name contains this are run
+    const char* filter = nullptr;
+    const char* outputPath = nullptr;
+    const char* baselinePath = nullptr;
+    // Slowdown over the baseline that counts as a regression (fraction)
+    double threshold = 0.10;
+};
+
+BenchOptions options;
+
+const std::uint64_t benchSeed = 12345;
+
+const ssnake::SnakeTextureList textures = {ssnake::TEXTURE_SNAKE_HEAD, ssnake::TEXTURE_SNAKE, ssnake::TEXTURE_SNAKE};
+
+
+
+// Runs batch until minSeconds have passed, batch returns how many operations it did
+template <typename Batch>
+void measure(std::vector<BenchResult>& results, const std::string& name, Batch batch)
+{
+    if (options.filter != nullptr && std::strstr(name.c_str(), options.filter) == nullptr)
+    {
+        return;
+    }
+
+    // Warm up caches and the branch predictor
+    batch();
+
+    unsigned long long operations = 0;
+    double seconds = 0.0;
+    std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    do
+    {
+        operations += batch();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+    } while (seconds < options.minSeconds);
+
+    BenchResult result = {name, operations, seconds * 1e9 / operations};
+    results.push_back(result);
+
+    std::fprintf(stderr, "%-48s %12.1f ns/op\n", name.c_str(), result.nsPerOp);
+}
+
+
+
+std::string boardName(coordType size_x, coordType size_y)
+{
+    return std::to_string(size_x) + "x" + std::to_string(size_y);
+}
+
+
+
+ssnake::Direction_t directionBetween(const Vec2& from, const Vec2& to)
+{
+    if (to.x > from.x)
+    {
+        return ssnake::RIGHT;
+    }
+    if (to.x < from.x)
+    {
+        return ssnake::LEFT;
+    }
+    if (to.y < from.y)
+    {
+        return ssnake::UP;
+    }
+    return ssnake::DOWN;
+}
+
+
+
+// Returns a cycle through every cell inside of the border of a board, so snakes following it never die
+// At least one of the inside dimensions must be even
+std::vector<Vec2> makeCycle(coordType size_x, coordType size_y)
+{
+    coordType w = size_x - 2;
+    coordType h = size_y - 2;
+    bool transpose = (h % 2) != 0;
+    if (transpose)
+    {
+        coordType t = w;
+        w = h;
+        h = t;
+    }
+
+    // Along the top row, snake back and forth through the other columns, and return up the first column
+    std::vector<Vec2> cycle;
+    for (coordType x = 0; x < w; ++x)
+    {
+        cycle.push_back({x, 0});
+    }
+    for (coordType y = 1; y < h; ++y)
+    {
+        for (coordType i = 0; i < w - 1; ++i)
+        {
+            coordType x = (y % 2 == 1) ? (w - 1 - i) : (i + 1);
+            cycle.push_back({x, y});
+        }
+    }
+    for (coordType y = h - 1; y > 0; --y)
+    {
+        cycle.push_back({0, y});
+    }
+
+    for (std::size_t i = 0; i < cycle.size(); ++i)
+    {
+        if (transpose)
+        {
+            coordType t = cycle[i].x;
+            cycle[i].x = cycle[i].y;
+            cycle[i].y = t;
+        }
+        ++cycle[i].x;
+        ++cycle[i].y;
+    }
+
+    return cycle;
+}
+
+
+
+// Snakes evenly spread along a board cycle, that move forever without touching
+class CycleScenario
+{
+
+public:
+
+    CycleScenario(coordType size_x, coordType size_y, std::size_t snakeCount, std::size_t length)
+        : board(size_x, size_y), cycle(makeCycle(size_x, size_y))
+    {
+        std::size_t spacing = cycle.size() / snakeCount;
+        for (std::size_t s = 0; s < snakeCount; ++s)
+        {
+            std::vector<Vec2> body;
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                body.push_back(cycle[s * spacing + i]);
+            }
+
+            std::size_t head = s * spacing + length - 1;
+            ssnake::Direction_t direction = directionBetween(cycle[head], cycle[(head + 1) % cycle.size()]);
+            snakes.emplace_back(&display, &board, textures, body, direction);
+            heads.push_back(head);
+        }
+    }
+
+    // Points every snake along the cycle, needs to be done before every move
+    void steer()
+    {
+        std::vector<std::size_t>::iterator head = heads.begin();
+        for (std::list<ssnake::Snake>::iterator it = snakes.begin(); it != snakes.end(); ++it, ++head)
+        {
+            std::size_t next = (*head + 1) % cycle.size();
+            it->setDirection(directionBetween(cycle[*head], cycle[next]));
+            *head = next;
+        }
+    }
+
+    ssnake::HeadlessDisplay display;
+    ssnake::Board board;
+    std::vector<Vec2> cycle;
+    std::list<ssnake::Snake> snakes;
+    std::vector<std::size_t> heads;
+};
+
+
+
+void benchSnakeMoves(std::vector<BenchResult>& results)
+{
+    const coordType size = 130;
+    const std::size_t lengths[] = {4, 256, 8192};
+
+    for (std::size_t length : lengths)
+    {
+        std::string suffix = "/length=" + std::to_string(length) + "/board=" + boardName(size, size);
+
+        CycleScenario moveOnly(size, size, 1, length);
+        measure(results, "snake_move" + suffix, [&]() {
+            ssnake::Snake& snake = moveOnly.snakes.front();
+            for (int i = 0; i < 1000; ++i)
+            {
+                moveOnly.steer();
+                snake.move();
+            }
+            return 1000;
+        });
+
+        CycleScenario slice(size, size, 1, length);
+        measure(results, "snake_move_slice" + suffix, [&]() {
+            ssnake::Snake& snake = slice.snakes.front();
+            for (int i = 0; i < 1000; ++i)
+            {
+                slice.steer();
+                snake.move();
+                snake.checkSlice();
+            }
+            return 1000;
+        });
+
+        CycleScenario collision(size, size, 1, length);
+        measure(results, "snake_move_collision" + suffix, [&]() {
+            ssnake::Snake& snake = collision.snakes.front();
+            for (int i = 0; i < 1000; ++i)
+            {
+                collision.steer();
+                snake.move();
+                snake.checkCollision();
+            }
+            return 1000;
+        });
+    }
+}
+
+
+
+void benchManySnakes(std::vector<BenchResult>& results)
+{
+    const coordType size = 130;
+    const std::size_t snakeCounts[] = {1, 16, 256};
+
+    for (std::size_t snakeCount : snakeCounts)
+    {
+        CycleScenario scenario(size, size, snakeCount, 16);
+        std::string name = "snakes_tick/snakes=" + std::to_string(snakeCount) + "/length=16/board=" + boardName(size, size);
+        measure(results, name, [&]() {
+            for (int i = 0; i < 100; ++i)
+            {
+                scenario.steer();
+                for (std::list<ssnake::Snake>::iterator it = scenario.snakes.begin(); it != scenario.snakes.end(); ++it)
+                {
+                    it->move();
+                    it->checkSlice();
+                    it->checkCollision();
+                }
+            }
+            return 100;
+        });
+    }
+}
+
+
+
+void benchFloodFill(std::vector<BenchResult>& results)
+{
+    const coordType sizes[] = {26, 66, 130};
+
+    for (coordType size : sizes)
+    {
+        // One snake along half of the cycle leaves a winding corridor, which is the slowest kind of area to fill
+        std::size_t length = makeCycle(size, size).size() / 2;
+        CycleScenario scenario(size, size, 1, length);
+        const ssnake::BitBoard& bits = scenario.board.getBitBoard();
+        Vec2 start = scenario.cycle[length + 1];
+
+        std::string name = "flood_fill/winding/board=" + boardName(size, size);
+        measure(results, name, [&]() {
+            std::size_t total = 0;
+            for (int i = 0; i < 100; ++i)
+            {
+                total += bits.countReachable(start);
+            }
+            return total > 0 ? 100 : 0;
+        });
+
+        // A trap check only needs to find as many cells as the snake is long
+        name = "flood_fill/trap_check/board=" + boardName(size, size);
+        ssnake::Board open(size, size);
+        Vec2 center = {size / 2, size / 2};
+        measure(results, name, [&]() {
+            std::size_t total = 0;
+            for (int i = 0; i < 1000; ++i)
+            {
+                total += open.getBitBoard().countReachable(center, 64);
+            }
+            return total > 0 ? 1000 : 0;
+        });
+    }
+}
+
+
+
+void benchAi(std::vector<BenchResult>& results)
+{
+    const coordType size = 66;
+    const std::size_t foodCounts[] = {1, 64, 1024};
+
+    for (std::size_t foodCount : foodCounts)
+    {
+        ssnake::HeadlessDisplay display;
+        ssnake::Board board(size, size);
+        ssnake::Snake snake(&display, &board, textures, {size / 2, size / 2}, 3);
+
+        ssnake::Random rng(benchSeed);
+        std::vector<Vec2> foodList;
+        for (std::size_t i = 0; i < foodCount; ++i)
+        {
+            Vec2 food = {static_cast<coordType>(rng.below(size - 2) + 1), static_cast<coordType>(rng.below(size - 2) + 1)};
+            foodList.push_back(food);
+        }
+
+        std::string name = "ai_direction/food=" + std::to_string(foodCount) + "/board=" + boardName(size, size);
+        measure(results, name, [&]() {
+            for (int i = 0; i < 1000; ++i)
+            {
+                snake.ai_getDirection(foodList, rng);
+            }
+            return 1000;
+        });
+
+        // The pathfinder finds food through the board, so it has to be placed there
+        std::vector<Vec2> placedFood;
+        for (std::size_t i = 0; i < foodList.size(); ++i)
+        {
+            if (board.isEmpty(foodList[i]))
+            {
+                board.setFood(foodList[i], static_cast<unsigned int>(i));
+                placedFood.push_back(foodList[i]);
+            }
+        }
+
+        ssnake::Pathfinder pathfinder;
+        name = "ai_pathfind/food=" + std::to_string(foodCount) + "/board=" + boardName(size, size);
+        measure(results, name, [&]() {
+            for (int i = 0; i < 1000; ++i)
+            {
+                snake.ai_findPath(pathfinder);
+            }
+            return 1000;
+        });
+
+        ssnake::FoodField field;
+        name = "food_field_rebuild/food=" + std::to_string(foodCount) + "/board=" + boardName(size, size);
+        measure(results, name, [&]() {
+            for (int i = 0; i < 100; ++i)
+            {
+                field.invalidate();
+                field.update(board, foodList);
+            }
+            return 100;
+        });
+
+        name = "ai_follow_field/food=" + std::to_string(foodCount) + "/board=" + boardName(size, size);
+        measure(results, name, [&]() {
+            for (int i = 0; i < 1000; ++i)
+            {
+                snake.ai_followField(field);
+            }
+            return 1000;
+        });
+
+        // Food eaten and put back in the same cell, so every round clears the cells closest to it and fills them again,
+        // then updated like a snake steering would
+        std::size_t eaten = 0;
+        name = "food_field_eat/food=" + std::to_string(foodCount) + "/board=" + boardName(size, size);
+        measure(results, name, [&]() {
+            for (int i = 0; i < 100; ++i)
+            {
+                const Vec2& food = placedFood[eaten++ % placedFood.size()];
+                field.removeFood(food);
+                field.addFood(food);
+                field.update(board, foodList);
+            }
+            return 100;
+        });
+    }
+}
+
+
+
+void benchSpawnFood(std::vector<BenchResult>& results)
+{
+    const coordType sizes[] = {27, 130};
+
+    for (coordType size : sizes)
+    {
+        ssnake::HeadlessDisplay display(size, size + 2);
+        ssnake::SnakeGame game(&display);
+        std::uint64_t seed = benchSeed;
+
+        // Fill the whole board with food, so most spawns happen on a crowded board
+        std::string name = "spawn_food_until_full/board=" + boardName(display.getSize_x(), display.getSize_y());
+        measure(results, name, [&]() {
+            game.newGame(ssnake::GM_CLASSIC, seed++);
+            int spawned = 0;
+            while (game.spawnFood())
+            {
+                ++spawned;
+            }
+            return spawned;
+        });
+    }
+}
+
+
+
+void benchGameSteps(std::vector<BenchResult>& results)
+{
+    const coordType sizes[] = {27, 66, 258};
+    const ssnake::Game_t modes[] = {ssnake::GM_CLASSIC, ssnake::GM_SLICER, ssnake::GM_ARENA};
+    const char* modeNames[] = {"slicer", "classic", "arena"};
+
+    for (ssnake::Game_t mode : modes)
+    {
+        for (coordType size : sizes)
+        {
+            ssnake::HeadlessDisplay display(size, size + 3);
+            ssnake::SnakeGame game(&display);
+            std::uint64_t seed = benchSeed;
+            game.newGame(mode, seed);
+
+            std::vector<ssnake::PlayerAction> actions(1);
+            actions[0].autopilot = true;
+
+            std::string name = std::string("game_step/mode=") + modeNames[mode]
+                               + "/board=" + boardName(display.getSize_x(), display.getSize_y());
+            measure(results, name, [&]() {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    if (!game.isAlive())
+                    {
+                        game.newGame(mode, ++seed);
+                    }
+                    game.step(actions);
+                }
+                return 1000;
+            });
+        }
+    }
+}
+
+
+
+// Arenas too large for a dense board, where the cells are kept in tiles (see Board)
+void benchSparseArena(std::vector<BenchResult>& results)
+{
+    const coordType size = 10000;
+    const std::size_t snakeCounts[] = {20, 200};
+
+    for (std::size_t snakeCount : snakeCounts)
+    {
+        ssnake::HeadlessDisplay display(size, size + 3);
+        ssnake::SnakeGame game(&display);
+        game.setArenaSnakeCount(snakeCount);
+        std::uint64_t seed = benchSeed;
+        game.newGame(ssnake::GM_ARENA, seed);
+
+        std::vector<ssnake::PlayerAction> actions(1);
+        actions[0].autopilot = true;
+
+        std::string name = "game_step/mode=arena/snakes=" + std::to_string(snakeCount)
+                           + "/board=" + boardName(display.getSize_x(), display.getSize_y());
+        measure(results, name, [&]() {
+            for (int i = 0; i < 100; ++i)
+            {
+                if (!game.isAlive())
+                {
+                    game.newGame(ssnake::GM_ARENA, ++seed);
+                }
+                game.step(actions);
+            }
+            return 100;
+        });
+    }
+}
+
+
+
+void benchClassicBatch(std::vector<BenchResult>& results)
+{
+    const coordType sizes[] = {27, 66};
+    const ssnake::SimdLevel_t levels[] = {ssnake::SIMD_NONE, ssnake::SIMD_AVX2, ssnake::SIMD_AVX512};
+    const char* levelNames[] = {"none", "avx2", "avx512"};
+    const std::size_t gameCount = 1024;
+
+    for (coordType size : sizes)
+    {
+        ssnake::HeadlessDisplay display(size, size + 3);
+        coordType size_x = display.getSize_x();
+        coordType size_y = display.getSize_y();
+
+        for (ssnake::SimdLevel_t level : levels)
+        {
+            if (level > ssnake::ClassicBatch::getBestSimdLevel())
+            {
+                continue;
+            }
+
+            ssnake::ClassicBatch batch(gameCount, size_x, size_y);
+            batch.setSimdLevel(level);
+            std::uint64_t seed = benchSeed;
+            for (std::size_t game = 0; game < gameCount; ++game)
+            {
+                batch.newGame(game, ++seed);
+            }
+
+            std::vector<ssnake::PlayerAction> actions(gameCount);
+            std::vector<ssnake::StepResult> stepResults;
+            ssnake::Random rng(benchSeed);
+
+            // Turns away from walls, and sometimes towards the food, which is about as cheap as a player can be
+            const ssnake::DirectionalKey_t keys[4] = {ssnake::RIGHT_KEY, ssnake::LEFT_KEY, ssnake::UP_KEY, ssnake::DOWN_KEY};
+            auto steer = [&](std::size_t game) {
+                Vec2 head = batch.getHead(game);
+                ssnake::Direction_t direction = batch.getDirection(game);
+                Vec2 food;
+                bool turn = rng.below(8) == 0;
+                if (direction == ssnake::RIGHT || direction == ssnake::LEFT)
+                {
+                    turn = turn || head.x <= 1 || head.x >= size_x - 2;
+                    bool down = (turn && batch.getFood(game, food)) ? food.y > head.y : head.y < size_y / 2;
+                    actions[game].direction = turn ? keys[down ? ssnake::DOWN : ssnake::UP] : ssnake::NONE;
+                }
+                else
+                {
+                    turn = turn || head.y <= 1 || head.y >= size_y - 2;
+                    bool right = (turn && batch.getFood(game, food)) ? food.x > head.x : head.x < size_x / 2;
+                    actions[game].direction = turn ? keys[right ? ssnake::RIGHT : ssnake::LEFT] : ssnake::NONE;
+                }
+            };
+
+            std::string name = std::string("classic_batch_step/simd=") + levelNames[level]
+                               + "/board=" + boardName(size_x, size_y);
+            measure(results, name, [&]() {
+                for (int i = 0; i < 16; ++i)
+                {
+                    for (std::size_t game = 0; game < gameCount; ++game)
+                    {
+                        if (!batch.isAlive(game))
+                        {
+                            batch.newGame(game, ++seed);
+                        }
+                        steer(game);
+                    }
+                    batch.step(actions, stepResults);
+                }
+                return 16 * gameCount;
+            });
+        }
+    }
+}
+
+
+
+void benchSnapshots(std::vector<BenchResult>& results)
+{
+    const coordType sizes[] = {27, 66};
+    const ssnake::Game_t modes[] = {ssnake::GM_SLICER, ssnake::GM_ARENA};
+    const char* modeNames[] = {"slicer", "classic", "arena"};
+
+    for (ssnake::Game_t mode : modes)
+    {
+        for (coordType size : sizes)
+        {
+            ssnake::HeadlessDisplay display(size, size + 3);
+            ssnake::SnakeGame game(&display);
+            game.newGame(mode, benchSeed);
+
+            // A few steps in, so the snakes have moved away from where they started
+            std::vector<ssnake::PlayerAction> actions(1);
+            actions[0].autopilot = true;
+            for (int i = 0; i < 20 && game.isAlive(); ++i)
+            {
+                game.step(actions);
+            }
+
+            ssnake::GameSnapshot snapshot;
+            game.snapshot(snapshot);
+
+            std::string suffix = std::string("/mode=") + modeNames[mode]
+                                 + "/board=" + boardName(display.getSize_x(), display.getSize_y());
+            measure(results, "game_snapshot" + suffix, [&]() {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    game.snapshot(snapshot);
+                }
+                return 1000;
+            });
+            measure(results, "game_restore" + suffix, [&]() {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    game.restore(snapshot);
+                }
+                return 1000;
+            });
+        }
+    }
+}
+
+
+
+// Arena steps drawn into a DeltaDisplay with the frame ended after each, and keyframes of the board it ends up with
+void benchDeltaFrames(std::vector<BenchResult>& results)
+{
+    const coordType sizes[] = {66, 258};
+
+    for (coordType size : sizes)
+    {
+        ssnake::DeltaDisplay display(size, size + 3, nullptr);
+        ssnake::SnakeGame game(&display);
+        std::uint64_t seed = benchSeed;
+        game.newGame(ssnake::GM_ARENA, seed);
+
+        std::vector<ssnake::PlayerAction> actions(1);
+        actions[0].autopilot = true;
+        std::vector<std::uint8_t> frame;
+
+        std::string suffix = "/board=" + boardName(display.getSize_x(), display.getSize_y());
+        measure(results, "delta_frame/mode=arena" + suffix, [&]() {
+            for (int i = 0; i < 1000; ++i)
+            {
+                if (!game.isAlive())
+                {
+                    game.newGame(ssnake::GM_ARENA, ++seed);
+                }
+                game.step(actions);
+                frame.clear();
+                display.endFrame(frame);
+            }
+            return 1000;
+        });
+
+        measure(results, "delta_keyframe" + suffix, [&]() {
+            for (int i = 0; i < 10; ++i)
+            {
+                frame.clear();
+                display.writeKeyframe(frame);
+            }
+            return 10;
+        });
+    }
+}
+
+
+
+// Arena steps drawn by an AnsiDisplay to /dev/null as if it were a terminal big enough for the board.
+// Only the time is measured, the bytes it writes per step are printed to compare with a curses terminal.
+void benchAnsiFrames(std::vector<BenchResult>& results)
+{
+    const coordType size = 66;
+
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0)
+    {
+        std::fprintf(stderr, "Skipping ANSI benchmarks: can't open /dev/null\n");
+        return;
+    }
+
+    {
+        ssnake::AnsiDisplay display(size, size + 3, {size * 2 + 4, size + 6}, fd);
+        ssnake::SnakeGame game(&display);
+        std::uint64_t seed = benchSeed;
+        game.newGame(ssnake::GM_ARENA, seed);
+        display.update();
+
+        std::vector<ssnake::PlayerAction> actions(1);
+        actions[0].autopilot = true;
+
+        std::uint64_t steps = 0;
+        std::uint64_t startBytes = display.getBytesWritten();
+        measure(results, "ansi_frame/mode=arena/board=" + boardName(display.getSize_x(), display.getSize_y()), [&]() {
+            for (int i = 0; i < 1000; ++i)
+            {
+                if (!game.isAlive())
+                {
+                    game.newGame(ssnake::GM_ARENA, ++seed);
+                }
+                game.step(actions);
+                display.update();
+            }
+            steps += 1000;
+            return 1000;
+        });
+
+        // Left out when the benchmark was filtered out
+        if (steps > 0)
+        {
+            std::fprintf(stderr, "ansi_frame: %.0f bytes per step\n",
+                         static_cast<double>(display.getBytesWritten() - startBytes) / static_cast<double>(steps));
+        }
+    }
+
+    close(fd);
+}
+
+
+
+// The same arena steps handed to a ThreadedDisplay in front of the AnsiDisplay, at the frame rate of the interactive game.
+// Only the game's side is timed, which is what a step costs now that drawing happens on the render thread.
+void benchThreadedFrames(std::vector<BenchResult>& results)
+{
+    const coordType size = 66;
+
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0)
+    {
+        std::fprintf(stderr, "Skipping threaded display benchmarks: can't open /dev/null\n");
+        return;
+    }
+
+    {
+        ssnake::AnsiDisplay screen(size, size + 3, {size * 2 + 4, size + 6}, fd);
+        ssnake::ThreadedDisplay display(&screen, 60.0);
+        ssnake::SnakeGame game(&display);
+        std::uint64_t seed = benchSeed;
+        game.newGame(ssnake::GM_ARENA, seed);
+        display.update();
+
+        std::vector<ssnake::PlayerAction> actions(1);
+        actions[0].autopilot = true;
+
+        measure(results, "threaded_frame/mode=arena/board=" + boardName(display.getSize_x(), display.getSize_y()), [&]() {
+            for (int i = 0; i < 1000; ++i)
+            {
+                if (!game.isAlive())
+                {
+                    game.newGame(ssnake::GM_ARENA, ++seed);
+                }
+                game.step(actions);
+                display.update();
+            }
+            return 1000;
+        });
+    }
+
+    close(fd);
+}
+
+
+
+// A multiplayer server stepping with clients connected over a Unix socket, from waiting for them to having sent the step.
+// The clients are drained after every step like a fast network would, which is counted in the time too.
+void benchServerSteps(std::vector<BenchResult>& results)
+{
+    const coordType size = 66;
+    const std::size_t clientCounts[] = {16, 256};
+
+    for (std::size_t clientCount : clientCounts)
+    {
+        ssnake::ServerConfig config;
+        config.address = "unix:/tmp/ssnake-bench-" + std::to_string(getpid()) + ".sock";
+        config.size_x = size;
+        config.size_y = size + 3;
+        config.seed = benchSeed;
+
+        ssnake::GameServer server(config);
+        std::string error;
+        if (!server.open(error))
+        {
+            std::fprintf(stderr, "Skipping server benchmarks: %s\n", error.c_str());
+            return;
+        }
+
+        std::vector<int> clients(clientCount, -1);
+        for (std::size_t i = 0; i < clientCount; ++i)
+        {
+            if (!ssnake::connectSocket(config.address, clients[i], error))
+            {
+                std::fprintf(stderr, "Skipping server benchmarks: %s\n", error.c_str());
+                clientCount = i;
+                break;
+            }
+        }
+        while (server.getClientCount() < clientCount)
+        {
+            server.serveUntil(std::chrono::steady_clock::now());
+        }
+
+        std::vector<std::uint8_t> buffer(64 * 1024);
+        unsigned long step = 0;
+        std::string name = "server_step/clients=" + std::to_string(clientCount) + "/board=" + boardName(size - 1, size);
+        measure(results, name, [&]() {
+            for (int i = 0; i < 100; ++i)
+            {
+                // Players that died ask to come back now and then, so that there are always some around
+                if (++step % 50 == 0)
+                {
+                    const std::uint8_t spawn = ssnake::MSG_SPAWN;
+                    for (std::size_t client = 0; client < clientCount; ++client)
+                    {
+                        send(clients[client], &spawn, 1, MSG_NOSIGNAL);
+                    }
+                }
+
+                server.serveUntil(std::chrono::steady_clock::now());
+                server.step();
+
+                for (std::size_t client = 0; client < clientCount; ++client)
+                {
+                    while (recv(clients[client], buffer.data(), buffer.size(), MSG_DONTWAIT) > 0)
+                    {
+                    }
+                }
+            }
+            return 100;
+        });
+
+        for (std::size_t i = 0; i < clientCount; ++i)
+        {
+            close(clients[i]);
+        }
+    }
+}
+
+
+
+void benchTreeSearch(std::vector<BenchResult>& results)
+{
+    const std::size_t rolloutCounts[] = {64, 256};
+
+    for (std::size_t rollouts : rolloutCounts)
+    {
+        ssnake::HeadlessDisplay display;
+        ssnake::SnakeGame game(&display);
+        game.newGame(ssnake::GM_SLICER, benchSeed);
+
+        std::vector<ssnake::PlayerAction> actions(1);
+        actions[0].autopilot = true;
+        for (int i = 0; i < 20 && game.isAlive(); ++i)
+        {
+            game.step(actions);
+        }
+
+        ssnake::GameSnapshot snapshot;
+        game.snapshot(snapshot);
+
+        // One thread, so that the time doesn't depend on how many cores the machine has
+        ssnake::MctsConfig config;
+        config.rollouts = rollouts;
+        ssnake::MctsPlanner planner(config, display.getSize_x(), display.getSize_y());
+
+        // The computer snake is at the front of the snake list
+        std::string name = "mcts_search/rollouts=" + std::to_string(rollouts) + "/mode=slicer";
+        measure(results, name, [&]() {
+            ssnake::Direction_t direction;
+            for (int i = 0; i < 10; ++i)
+            {
+                planner.search(snapshot, 0, std::chrono::steady_clock::time_point::max(), direction);
+            }
+            return 10;
+        });
+    }
+}
+
+
+
+void writeJson(std::FILE* file, const std::vector<BenchResult>& results)
+{
+    std::fprintf(file, "{\n  \"seed\": %llu,\n  \"benchmarks\": [\n", static_cast<unsigned long long>(benchSeed));
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        std::fprintf(file, "    {\"name\": \"%s\", \"operations\": %llu, \"ns_per_op\": %.3f}%s\n",
+                     results[i].name.c_str(), results[i].operations, results[i].nsPerOp,
+                     (i + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+}
+
+
+
+// Reads the name and ns_per_op of every benchmark in a file written by writeJson
+bool readJson(const char* path, std::vector<BenchResult>& results)
+{
+    std::FILE* file = std::fopen(path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::string text;
+    char buffer[4096];
+    std::size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        text.append(buffer, count);
+    }
+    std::fclose(file);
+
+    const std::string nameKey = "\"name\": \"";
+    const std::string timeKey = "\"ns_per_op\": ";
+    std::size_t pos = 0;
+    while ((pos = text.find(nameKey, pos)) != std::string::npos)
+    {
+        pos += nameKey.size();
+        std::size_t nameEnd = text.find('"', pos);
+        std::size_t timePos = text.find(timeKey, pos);
+        if (nameEnd == std::string::npos || timePos == std::string::npos)
+        {
+            return false;
+        }
+
+        BenchResult result;
+        result.name = text.substr(pos, nameEnd - pos);
+        result.operations = 0;
+        result.nsPerOp = std::strtod(text.c_str() + timePos + timeKey.size(), nullptr);
+        results.push_back(result);
+
+        pos = timePos;
+    }
+
+    return true;
+}
+
+
+
+// Prints how every benchmark changed from the baseline, returns the number of regressions
+int compareToBaseline(const std::vector<BenchResult>& results, const std::vector<BenchResult>& baseline)
+{
+    int regressions = 0;
+
+    std::fprintf(stderr, "\n%-48s %12s %12s %8s\n", "compared to baseline", "baseline", "current", "change");
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult* old = nullptr;
+        for (std::size_t j = 0; j < baseline.size(); ++j)
+        {
+            if (baseline[j].name == results[i].name)
+            {
+                old = &baseline[j];
+                break;
+            }
+        }
+        if (old == nullptr || old->nsPerOp <= 0.0)
+        {
+            std::fprintf(stderr, "%-48s %12s %12.1f %8s\n", results[i].name.c_str(), "-", results[i].nsPerOp, "new");
+            continue;
+        }
+
+        double change = results[i].nsPerOp / old->nsPerOp - 1.0;
+        bool regressed = change > options.threshold;
+        regressions += regressed ? 1 : 0;
+
+        std::fprintf(stderr, "%-48s %12.1f %12.1f %+7.1f%%%s\n", results[i].name.c_str(),
+                     old->nsPerOp, results[i].nsPerOp, change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+
+    return regressions;
+}
+
+
+
+bool parseOptions(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const char* arg = argv[i];
+        const char* value = argv[i + 1];
+
+        if (std::strcmp(arg, "--min-time") == 0)
+        {
+            options.minSeconds = std::strtod(value, nullptr);
+        }
+        else if (std::strcmp(arg, "--filter") == 0)
+        {
+            options.filter = value;
+        }
+        else if (std::strcmp(arg, "--output") == 0)
+        {
+            options.outputPath = value;
+        }
+        else if (std::strcmp(arg, "--baseline") == 0)
+        {
+            options.baselinePath = value;
+        }
+        else if (std::strcmp(arg, "--threshold") == 0)
+        {
+            options.threshold = std::strtod(value, nullptr) / 100.0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return (argc % 2) == 1;
+}
+
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    if (!parseOptions(argc, argv))
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [options]\n"
+                     "  --min-time S      seconds spent on each benchmark (default 0.25)\n"
+                     "  --filter TEXT     only run benchmarks with TEXT in their name\n"
+                     "  --output FILE     write the JSON results to FILE instead of stdout\n"
+                     "  --baseline FILE   compare against JSON results saved from an earlier run\n"
+                     "  --threshold P     percent slowdown that counts as a regression (default 10)\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+    benchSnakeMoves(results);
+    benchManySnakes(results);
+    benchAi(results);
+    benchFloodFill(results);
+    benchSpawnFood(results);
+    benchGameSteps(results);
+    benchSparseArena(results);
+    benchClassicBatch(results);
+    benchSnapshots(results);
+    benchDeltaFrames(results);
+    benchAnsiFrames(results);
+    benchThreadedFrames(results);
+    benchServerSteps(results);
+    benchTreeSearch(results);
+
+    std::FILE* output = stdout;
+    if (options.outputPath != nullptr)
+    {
+        output = std::fopen(options.outputPath, "w");
+        if (output == nullptr)
+        {
+            std::fprintf(stderr, "Could not write %s\n", options.outputPath);
+            return 1;
+        }
+    }
+    writeJson(output, results);
+    if (output != stdout)
+    {
+        std::fclose(output);
+    }
+
+    if (options.baselinePath != nullptr)
+    {
+        std::vector<BenchResult> baseline;
+        if (!readJson(options.baselinePath, baseline))
+        {
+            std::fprintf(stderr, "Could not read baseline %s\n", options.baselinePath);
+            return 1;
+        }
+
+        // Regressions give a distinct exit code so scripts can catch them
+        if (compareToBaseline(results, baseline) > 0)
+        {
+            return 2;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+
+#include "batch.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "display_headless.h"
+#include "game.h"
+#include "replay.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// Games waiting to be played by one worker.
+// The owner takes games from the back, other workers steal from the front when they run out.
+struct WorkQueue
+{
+    std::mutex lock;
+    std::deque<std::size_t> games;
+};
+
+
+
+bool takeOwnGame(WorkQueue& queue, std::size_t& gameIndex)
+{
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.games.empty())
+    {
+        return false;
+    }
+
+    gameIndex = queue.games.back();
+    queue.games.pop_back();
+    return true;
+}
+
+
+
+bool stealGame(std::vector<WorkQueue>& queues, std::size_t thief, std::size_t& gameIndex)
+{
+    for (std::size_t i = 1; i < queues.size(); ++i)
+    {
+        WorkQueue& victim = queues[(thief + i) % queues.size()];
+
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.games.empty())
+        {
+            gameIndex = victim.games.front();
+            victim.games.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+void playGame(SnakeGame& game,
+              const BatchConfig& config,
+              std::uint64_t seed,
+              const PlayerController& controller,
+              GameResult& result)
+{
+    std::vector<PlayerAction> actions(1);
+
+    game.newGame(config.gameType, seed);
+    while (game.isAlive() && (config.maxSteps == 0 || game.getStepCount() < config.maxSteps))
+    {
+        actions[0] = PlayerAction();
+        controller(game, actions[0]);
+        game.step(actions);
+    }
+
+    result.seed = seed;
+    result.finalLength = game.getPlayerLength();
+    result.maxLength = game.getMaxLength();
+    result.steps = game.getStepCount();
+    result.cause = game.getDeathCause();
+}
+
+
+
+void runWorker(std::vector<WorkQueue>& queues,
+               std::size_t worker,
+               const BatchConfig& config,
+               const PlayerController& controller,
+               std::vector<GameResult>& results)
+{
+    // Declared before the game, so the game can end its last replay before the file is closed
+    ReplayWriter writer;
+
+    HeadlessDisplay display(config.size_x, config.size_y);
+    SnakeGame game(&display);
+    game.setArenaSnakeCount(config.arenaSnakes);
+    game.setAiMode(config.aiMode);
+
+    MctsConfig mctsConfig;
+    mctsConfig.rollouts = config.mctsRollouts;
+    game.setMctsConfig(mctsConfig);
+
+    if (!config.recordPath.empty() && writer.open((config.recordPath + "." + std::to_string(worker)).c_str()))
+    {
+        game.setReplayWriter(&writer);
+    }
+
+    // No games are added while running, so once every queue is empty the worker is done
+    std::size_t gameIndex;
+    while (takeOwnGame(queues[worker], gameIndex) || stealGame(queues, worker, gameIndex))
+    {
+        playGame(game, config, config.firstSeed + gameIndex, controller, results[gameIndex]);
+    }
+}
+
+}
+
+
+
+BatchRunner::BatchRunner(const BatchConfig& batchConfig)
+{
+    config = batchConfig;
+}
+
+
+
+std::vector<GameResult> BatchRunner::run(const PlayerController& controller) const
+{
+    std::vector<GameResult> results(config.gameCount);
+
+    std::size_t threadCount = config.threadCount;
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+    if (threadCount > config.gameCount)
+    {
+        threadCount = config.gameCount;
+    }
+    if (threadCount == 0)
+    {
+        return results;
+    }
+
+    // Each worker starts with a contiguous share of the games
+    std::vector<WorkQueue> queues(threadCount);
+    for (std::size_t i = 0; i < config.gameCount; ++i)
+    {
+        queues[i * threadCount / config.gameCount].games.push_back(i);
+    }
+
+    std::vector<std::thread> workers;
+    for (std::size_t worker = 1; worker < threadCount; ++worker)
+    {
+        workers.emplace_back(runWorker, std::ref(queues), worker, std::cref(config), std::cref(controller), std::ref(results));
+    }
+    runWorker(queues, 0, config, controller, results);
+
+    for (std::size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i].join();
+    }
+
+    return results;
+}
+
+
+
+std::vector<GameResult> BatchRunner::run() const
+{
+    return run([](const SnakeGame&, PlayerAction& action) { action.autopilot = true; });
+}
+
+
+
+BatchSummary BatchRunner::summarize(const std::vector<GameResult>& results)
+{
+    BatchSummary summary;
+    summary.games = results.size();
+    if (results.empty())
+    {
+        return summary;
+    }
+
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        summary.meanFinalLength += results[i].finalLength;
+        summary.meanMaxLength += results[i].maxLength;
+        summary.meanSteps += results[i].steps;
+        if (results[i].maxLength > summary.longestLength)
+        {
+            summary.longestLength = results[i].maxLength;
+        }
+        ++summary.causeCounts[results[i].cause];
+    }
+
+    summary.meanFinalLength /= results.size();
+    summary.meanMaxLength /= results.size();
+    summary.meanSteps /= results.size();
+
+    return summary;
+}
+
+}
@@ -0,0 +1,120 @@
+
+// batch.h
+// Runs many headless games in parallel
+//
+
+#ifndef SLICERSNAKE_BATCH_H
+#define SLICERSNAKE_BATCH_H
+
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "display.h"
+#include "game.h"
+
+
+namespace ssnake
+{
+
+struct BatchConfig
+{
+    Game_t gameType = GM_SLICER;
+    std::size_t gameCount = 1;
+
+    // Game i is played with seed firstSeed + i
+    std::uint64_t firstSeed = 0;
+
+    // 0 uses every hardware thread
+    unsigned int threadCount = 0;
+
+    // Games still running after this many steps are stopped, 0 for no limit
+    unsigned long maxSteps = 100000;
+
+    // Display size of every game (units of "snake chunks", same as the interactive game)
+    coordType size_x = 27;
+    coordType size_y = 30;
+
+    // Computer snakes in arena games, 0 lets the game pick from the board size
+    std::size_t arenaSnakes = 0;
+
+    // AI of the computer snakes and of the player's snake
+    AiMode_t aiMode = AI_SIMPLE;
+
+    // Playouts per move of AI_MCTS, searched on the worker's own thread since the workers already use every core
+    std::size_t mctsRollouts = 256;
+
+    // If set, every worker records its games to the replay file recordPath.N, where N is the worker number
+    std::string recordPath;
+};
+
+
+
+struct GameResult
+{
+    std::uint64_t seed = 0;
+    std::size_t finalLength = 0;
+    std::size_t maxLength = 0;
+    unsigned long steps = 0;
+
+    // DEATH_NONE if the game was stopped by maxSteps
+    DeathCause_t cause = DEATH_NONE;
+};
+
+
+
+struct BatchSummary
+{
+    std::size_t games = 0;
+    double meanFinalLength = 0.0;
+    double meanMaxLength = 0.0;
+    double meanSteps = 0.0;
+    std::size_t longestLength = 0;
+
+    // Number of games that ended for each DeathCause_t
+    std::size_t causeCounts[DEATH_QUIT + 1] = {};
+};
+
+
+
+// Chooses the player's action for the next step of game
+// Called concurrently from every worker thread, each with its own game
+typedef std::function<void(const SnakeGame& game, PlayerAction& action)> PlayerController;
+
+
+
+class BatchRunner
+{
+
+public:
+
+    explicit BatchRunner(const BatchConfig& batchConfig);
+
+    // PreConditions:
+    //   controller is safe to call from several threads at once
+    // PostConditions:
+    //   Every game of the batch is played to the end across the worker threads
+    //   Returns the result of each game, in seed order
+    std::vector<GameResult> run(const PlayerController& controller) const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Every game of the batch is played with the game's AI steering the player
+    std::vector<GameResult> run() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns totals and averages of results
+    static BatchSummary summarize(const std::vector<GameResult>& results);
+
+
+private:
+
+    BatchConfig config;
+};
+
+}
+
+#endif
@@ -0,0 +1,243 @@
+
+#include "bitboard.h"
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+unsigned int countBits(std::uint64_t word)
+{
+#ifdef __GNUC__
+    return static_cast<unsigned int>(__builtin_popcountll(word));
+#else
+    unsigned int count = 0;
+    for (; word != 0; word &= word - 1)
+    {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+
+
+// Spreads the cells of reached along the runs of open cells they are in, both ways.
+// Each pass doubles the distance covered, so a run as long as the whole word takes 6 of them.
+std::uint64_t fillRuns(std::uint64_t reached, std::uint64_t open)
+{
+    std::uint64_t up = reached;
+    std::uint64_t upOpen = open;
+    std::uint64_t down = reached;
+    std::uint64_t downOpen = open;
+    for (int shift = 1; shift < 64; shift *= 2)
+    {
+        up |= upOpen & (up << shift);
+        upOpen &= upOpen << shift;
+        down |= downOpen & (down >> shift);
+        downOpen &= downOpen >> shift;
+    }
+
+    return up | down;
+}
+
+}
+
+
+
+std::size_t BitBoard::countReachable(const Vec2& pos, std::size_t enough) const
+{
+    if (isBlocked(pos))
+    {
+        return 0;
+    }
+
+    reach.assign(blocked.size(), 0);
+    reach[wordIndex(pos)] |= std::uint64_t(1) << (pos.x % 64);
+
+    // Sweeping down and then up reaches any cells that don't need a path that goes back the other way,
+    // so twisty areas take a few sweeps, and open ones only one
+    std::size_t count = 1;
+    bool grew = true;
+    while (grew)
+    {
+        grew = false;
+        for (coordType y = pos.y; y < size.y - 1; ++y)
+        {
+            std::size_t added = growRow(y);
+            count += added;
+            grew = grew || added > 0;
+            if (count >= enough)
+            {
+                return count;
+            }
+        }
+        for (coordType y = size.y - 2; y > 0; --y)
+        {
+            std::size_t added = growRow(y);
+            count += added;
+            grew = grew || added > 0;
+            if (count >= enough)
+            {
+                return count;
+            }
+        }
+    }
+
+    return count;
+}
+
+
+
+unsigned int BitBoard::getOpenSteps(const Vec2& pos) const
+{
+    assert(pos.x > 0 && pos.y > 0 && pos.x < size.x - 1 && pos.y < size.y - 1);
+
+    // The cells left and right of a column at either end of a word are in the word next to it
+    std::size_t i = wordIndex(pos);
+    unsigned int bit = static_cast<unsigned int>(pos.x % 64);
+    std::uint64_t right = ((bit == 63) ? blocked[i + 1] : (blocked[i] >> (bit + 1))) & 1;
+    std::uint64_t left = ((bit == 0) ? (blocked[i - 1] >> 63) : (blocked[i] >> (bit - 1))) & 1;
+    std::uint64_t up = (blocked[i - rowWords] >> bit) & 1;
+    std::uint64_t down = (blocked[i + rowWords] >> bit) & 1;
+
+    std::uint64_t closed = right | (left << 1) | (up << 2) | (down << 3);
+    return static_cast<unsigned int>(~closed & 0xF);
+}
+
+
+
+std::size_t BitBoard::growRow(coordType y) const
+{
+    std::size_t begin = static_cast<std::size_t>(y) * rowWords;
+    std::size_t end = begin + rowWords;
+
+    std::size_t added = 0;
+    bool carried = true;
+    while (carried)
+    {
+        carried = false;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            std::uint64_t open = ~blocked[i];
+            std::uint64_t reached = reach[i] | ((reach[i - rowWords] | reach[i + rowWords]) & open);
+
+            // Runs of open cells that go on into the next word are continued there
+            if (i > begin)
+            {
+                reached |= (reach[i - 1] >> 63) & open;
+            }
+            if (i + 1 < end)
+            {
+                reached |= (reach[i + 1] << 63) & open;
+            }
+
+            reached = fillRuns(reached, open);
+            if (reached != reach[i])
+            {
+                // A word that grew at either end can let the word next to it grow
+                if (rowWords > 1 && (((reached ^ reach[i]) & 0x8000000000000001ull) != 0))
+                {
+                    carried = true;
+                }
+                added += countBits(reached ^ reach[i]);
+                reach[i] = reached;
+            }
+        }
+    }
+
+    return added;
+}
+
+
+
+bool BitBoard::isBlocked(const Vec2& pos) const
+{
+    return ((blocked[wordIndex(pos)] >> (pos.x % 64)) & 1) != 0;
+}
+
+
+
+bool BitBoard::isFood(const Vec2& pos) const
+{
+    return ((food[wordIndex(pos)] >> (pos.x % 64)) & 1) != 0;
+}
+
+
+
+void BitBoard::resize(coordType size_x, coordType size_y)
+{
+    assert(size_x >= 3 && size_y >= 3);
+
+    size.x = size_x;
+    size.y = size_y;
+    rowWords = (static_cast<std::size_t>(size_x) + 63) / 64;
+
+    blocked.assign(rowWords * size_y, 0);
+    food.assign(rowWords * size_y, 0);
+    reach.clear();
+
+    for (coordType y = 0; y < size_y; ++y)
+    {
+        for (std::size_t w = 0; w < rowWords; ++w)
+        {
+            // Columns past the board are blocked
+            std::size_t firstColumn = w * 64;
+            if (firstColumn + 64 > static_cast<std::size_t>(size_x))
+            {
+                std::size_t columns = static_cast<std::size_t>(size_x) - firstColumn;
+                blocked[y * rowWords + w] = ~std::uint64_t(0) << columns;
+            }
+        }
+
+        if (y == 0 || y == size_y - 1)
+        {
+            for (std::size_t w = 0; w < rowWords; ++w)
+            {
+                blocked[y * rowWords + w] = ~std::uint64_t(0);
+            }
+        }
+        else
+        {
+            setBlocked({0, y}, true);
+            setBlocked({size_x - 1, y}, true);
+        }
+    }
+}
+
+
+
+void BitBoard::setBlocked(const Vec2& pos, bool isBlocked)
+{
+    std::uint64_t bit = std::uint64_t(1) << (pos.x % 64);
+    std::uint64_t& word = blocked[wordIndex(pos)];
+    word = isBlocked ? (word | bit) : (word & ~bit);
+}
+
+
+
+void BitBoard::setFood(const Vec2& pos, bool isFood)
+{
+    std::uint64_t bit = std::uint64_t(1) << (pos.x % 64);
+    std::uint64_t& word = food[wordIndex(pos)];
+    word = isFood ? (word | bit) : (word & ~bit);
+}
+
+
+
+std::size_t BitBoard::wordIndex(const Vec2& pos) const
+{
+    assert(pos.x >= 0 && pos.y >= 0 && pos.x < size.x && pos.y < size.y);
+
+    return static_cast<std::size_t>(pos.y) * rowWords + static_cast<std::size_t>(pos.x) / 64;
+}
+
+}
@@ -0,0 +1,84 @@
+
+// bitboard.h
+// One bit per cell copies of the board, for checks that look at many cells at once
+//
+
+#ifndef SLICERSNAKE_BITBOARD_H
+#define SLICERSNAKE_BITBOARD_H
+
+
+#include <cstdint>
+#include <vector>
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+// Blocked cells (the border and every snake) and food cells, as rows of 64 bit words with bit x%64
+// of word x/64 for column x. Any board fits, but the default board has one word per row, so that
+// a row of cells is looked at with a single instruction.
+// Kept up to date by Board, so it is never behind the cells.
+class BitBoard
+{
+
+public:
+
+    // PreConditions:
+    //   size_x and size_y are at least 3
+    // PostConditions:
+    //   Every cell is open except for the border, there is no food
+    void resize(coordType size_x, coordType size_y);
+
+    // PreConditions:
+    //   pos is on the board
+    // PostConditions:
+    //   The cell at pos is marked blocked or open, and food or not food
+    void setBlocked(const Vec2& pos, bool blocked);
+    void setFood(const Vec2& pos, bool food);
+
+    // PreConditions:
+    //   pos is on the board
+    // PostConditions:
+    //   Returns true if the cell at pos is blocked, or has food
+    bool isBlocked(const Vec2& pos) const;
+    bool isFood(const Vec2& pos) const;
+
+    // PreConditions:
+    //   pos is inside of the border
+    // PostConditions:
+    //   Returns the open cells next to pos as bit d for each Direction_t d (right, left, up, down)
+    unsigned int getOpenSteps(const Vec2& pos) const;
+
+    // PreConditions:
+    //   pos is on the board
+    // PostConditions:
+    //   Returns the number of open cells that can be reached from pos without going through a blocked cell,
+    //   counting pos itself, or 0 if pos is blocked.
+    //   Stops early once at least enough cells were reached, and returns a number that is at least enough
+    std::size_t countReachable(const Vec2& pos, std::size_t enough = static_cast<std::size_t>(-1)) const;
+
+
+private:
+
+    std::size_t wordIndex(const Vec2& pos) const;
+
+    // Spreads reach into the open cells of row y that are next to reach in the rows above, below and in row y,
+    // returns the number of cells added
+    std::size_t growRow(coordType y) const;
+
+    Vec2 size = {0, 0};
+    std::size_t rowWords = 0;
+
+    // Cells of the board past the last column are blocked, so that nothing spreads into them
+    std::vector<std::uint64_t> blocked;
+    std::vector<std::uint64_t> food;
+
+    // Cells reached by countReachable, only kept to not allocate on every call
+    mutable std::vector<std::uint64_t> reach;
+};
+
+}
+
+#endif
@@ -0,0 +1,581 @@
+
+#include "board.h"
+
+#include <algorithm> // copy_n, fill_n
+#include <vector>
+#include <cassert>
+#include <memory>
+
+#include "bitboard.h"
+#include "display.h"
+#include "random.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// What getCell returns for the cells of tiles that aren't allocated
+const BoardCell emptyCell = {OWNER_EMPTY, 0};
+
+}
+
+
+
+const std::uint32_t Board::notFree;
+const std::size_t Board::denseCellLimit;
+const int Board::tileShift;
+const coordType Board::tileSize;
+const std::size_t Board::maxSpareTiles;
+
+
+
+Board::Board(const coordType size_x, const coordType size_y)
+{
+    size.x = size_x;
+    size.y = size_y;
+
+    reset();
+}
+
+
+
+int Board::addSnake(Snake* snake)
+{
+    if (!unusedIds.empty())
+    {
+        int id = unusedIds.back();
+        unusedIds.pop_back();
+        snakes[id] = snake;
+        return id;
+    }
+
+    snakes.push_back(snake);
+    return static_cast<int>(snakes.size() - 1);
+}
+
+
+
+Board::Tile* Board::allocateTile(std::size_t t)
+{
+    assert(tiles[t] == nullptr);
+
+    if (spareTiles.empty())
+    {
+        tiles[t].reset(new Tile);
+    }
+    else
+    {
+        tiles[t] = std::move(spareTiles.back());
+        spareTiles.pop_back();
+    }
+
+    Tile* tile = tiles[t].get();
+    std::fill_n(tile->cells, tileSize * tileSize, emptyCell);
+    tile->used = 0;
+    return tile;
+}
+
+
+
+void Board::attachSnake(int id, Snake* snake)
+{
+    assert(id >= 0 && static_cast<std::size_t>(id) < snakes.size());
+
+    snakes[id] = snake;
+}
+
+
+
+void Board::clearFood(const Vec2& pos)
+{
+    if (getCell(pos).owner == OWNER_FOOD)
+    {
+        setCell(pos, OWNER_EMPTY, 0);
+    }
+}
+
+
+
+void Board::clearSnake(const Vec2& pos, int owner, unsigned int segment)
+{
+    const BoardCell& cell = getCell(pos);
+    if (cell.owner == owner && cell.segment == segment)
+    {
+        setCell(pos, OWNER_EMPTY, 0);
+    }
+}
+
+
+
+bool Board::contains(const Vec2& pos) const
+{
+    return pos.x >= 0 && pos.y >= 0 && pos.x < size.x && pos.y < size.y;
+}
+
+
+
+std::size_t Board::countReachable(const Vec2& pos, std::size_t enough) const
+{
+    if (!sparse)
+    {
+        return bits.countReachable(pos, enough);
+    }
+
+    if (!isOpen(pos))
+    {
+        return 0;
+    }
+
+    // Breadth first, since only the cells close to pos are ever looked at on a board this large
+    const Vec2 offsets[4] = {{1, 0}, {-1, 0}, {0, -1}, {0, 1}};
+    searchQueue.clear();
+    searchSeen.clear();
+    searchQueue.push_back(pos);
+    searchSeen.insert(index(pos));
+    for (std::size_t front = 0; front < searchQueue.size() && searchQueue.size() < enough; ++front)
+    {
+        Vec2 cell = searchQueue[front];
+        for (int d = 0; d < 4; ++d)
+        {
+            Vec2 next = {cell.x + offsets[d].x, cell.y + offsets[d].y};
+            if (isOpen(next) && searchSeen.insert(index(next)).second)
+            {
+                searchQueue.push_back(next);
+            }
+        }
+    }
+
+    return searchQueue.size();
+}
+
+
+
+const BoardCell& Board::getCell(const Vec2& pos) const
+{
+    if (!sparse)
+    {
+        return cells[index(pos)];
+    }
+
+    const Tile* tile = tiles[tileIndex(pos)].get();
+    return (tile != nullptr) ? tile->cells[tileCellIndex(pos)] : emptyCell;
+}
+
+
+
+const std::vector<BoardCell>& Board::getCells() const
+{
+    assert(!sparse);
+
+    return cells;
+}
+
+
+
+const BitBoard& Board::getBitBoard() const
+{
+    assert(!sparse);
+
+    return bits;
+}
+
+
+
+std::size_t Board::getFreeCount() const
+{
+    if (!sparse)
+    {
+        return freeCells.size();
+    }
+
+    return static_cast<std::size_t>(size.x - 2) * (size.y - 2) - occupied;
+}
+
+
+
+unsigned int Board::getOpenSteps(const Vec2& pos) const
+{
+    if (!sparse)
+    {
+        return bits.getOpenSteps(pos);
+    }
+
+    assert(pos.x > 0 && pos.y > 0 && pos.x < size.x - 1 && pos.y < size.y - 1);
+
+    const Vec2 offsets[4] = {{1, 0}, {-1, 0}, {0, -1}, {0, 1}};
+    unsigned int openSteps = 0;
+    for (int d = 0; d < 4; ++d)
+    {
+        if (isOpen({pos.x + offsets[d].x, pos.y + offsets[d].y}))
+        {
+            openSteps |= 1u << d;
+        }
+    }
+    return openSteps;
+}
+
+
+
+coordType Board::getSize_x() const
+{
+    return size.x;
+}
+
+
+
+coordType Board::getSize_y() const
+{
+    return size.y;
+}
+
+
+
+Snake* Board::getSnake(int id) const
+{
+    if (id < 0 || static_cast<std::size_t>(id) >= snakes.size())
+    {
+        return nullptr;
+    }
+
+    return snakes[id];
+}
+
+
+
+std::size_t Board::index(const Vec2& pos) const
+{
+    assert(contains(pos));
+
+    return static_cast<std::size_t>(pos.y) * size.x + pos.x;
+}
+
+
+
+bool Board::isBorder(const Vec2& pos) const
+{
+    return pos.x == 0 || pos.y == 0 || pos.x == size.x - 1 || pos.y == size.y - 1;
+}
+
+
+
+bool Board::isEmpty(const Vec2& pos) const
+{
+    return getCell(pos).owner == OWNER_EMPTY;
+}
+
+
+
+bool Board::isOpen(const Vec2& pos) const
+{
+    return contains(pos) && !isBorder(pos) && getCell(pos).owner < 0;
+}
+
+
+
+bool Board::isSparse() const
+{
+    return sparse;
+}
+
+
+
+bool Board::isSparseSize(coordType size_x, coordType size_y)
+{
+    return static_cast<std::size_t>(size_x) * size_y > denseCellLimit;
+}
+
+
+
+void Board::loadState(const BoardState& state)
+{
+    assert(state.cells.size() == cells.size());
+    assert(state.tileIds.empty() || state.tileIds.back() < tiles.size());
+
+    // Assigning keeps the storage of the vectors, so this is just copying
+    cells = state.cells;
+    freeCells = state.freeCells;
+    freeSlots = state.freeSlots;
+    unusedIds = state.unusedIds;
+    bits = state.bits;
+    snakes.assign(state.snakeIdCount, nullptr);
+
+    // Tiles that are in both stay where they are, so that restoring a sparse board doesn't allocate
+    const std::size_t tileArea = static_cast<std::size_t>(tileSize) * tileSize;
+    std::size_t next = 0;
+    for (std::size_t t = 0; t < tiles.size(); ++t)
+    {
+        if (next < state.tileIds.size() && state.tileIds[next] == t)
+        {
+            Tile* tile = (tiles[t] != nullptr) ? tiles[t].get() : allocateTile(t);
+            std::copy_n(state.tileCells.begin() + next * tileArea, tileArea, tile->cells);
+            tile->used = state.tileUsed[next];
+            ++next;
+        }
+        else if (tiles[t] != nullptr)
+        {
+            releaseTile(t);
+        }
+    }
+    occupied = state.occupied;
+}
+
+
+
+bool Board::pickFreeCell(Random& rng, Vec2& pos) const
+{
+    if (getFreeCount() == 0)
+    {
+        return false;
+    }
+
+    if (!sparse)
+    {
+        std::size_t cellIndex = freeCells[rng.below(static_cast<std::uint32_t>(freeCells.size()))];
+        pos.x = static_cast<coordType>(cellIndex % size.x);
+        pos.y = static_cast<coordType>(cellIndex / size.x);
+        return true;
+    }
+
+    // Sparse boards are mostly empty, so this takes a try or two
+    do
+    {
+        pos.x = 1 + static_cast<coordType>(rng.below(static_cast<std::uint32_t>(size.x - 2)));
+        pos.y = 1 + static_cast<coordType>(rng.below(static_cast<std::uint32_t>(size.y - 2)));
+    }
+    while (!isEmpty(pos));
+
+    return true;
+}
+
+
+
+void Board::releaseTile(std::size_t t)
+{
+    assert(tiles[t] != nullptr);
+
+    if (spareTiles.size() < maxSpareTiles)
+    {
+        spareTiles.push_back(std::move(tiles[t]));
+    }
+    else
+    {
+        tiles[t].reset();
+    }
+}
+
+
+
+void Board::removeSnake(int id)
+{
+    assert(getSnake(id) != nullptr);
+
+    snakes[id] = nullptr;
+    unusedIds.push_back(id);
+}
+
+
+
+void Board::reset()
+{
+    snakes.clear();
+    unusedIds.clear();
+
+    sparse = isSparseSize(size.x, size.y);
+    if (sparse)
+    {
+        tileCount.x = (size.x + tileSize - 1) >> tileShift;
+        tileCount.y = (size.y + tileSize - 1) >> tileShift;
+        tiles.resize(static_cast<std::size_t>(tileCount.x) * tileCount.y);
+        for (std::size_t t = 0; t < tiles.size(); ++t)
+        {
+            if (tiles[t] != nullptr)
+            {
+                releaseTile(t);
+            }
+        }
+        occupied = 0;
+        return;
+    }
+
+    tileCount.x = 0;
+    tileCount.y = 0;
+    occupied = 0;
+
+    cells.assign(static_cast<std::size_t>(size.x) * size.y, emptyCell);
+
+    // Border cells are never free, since nothing can be placed on them
+    freeSlots.assign(cells.size(), notFree);
+    freeCells.clear();
+    for (coordType y = 1; y < size.y - 1; ++y)
+    {
+        for (coordType x = 1; x < size.x - 1; ++x)
+        {
+            std::size_t cellIndex = index({x, y});
+            freeSlots[cellIndex] = static_cast<std::uint32_t>(freeCells.size());
+            freeCells.push_back(static_cast<std::uint32_t>(cellIndex));
+        }
+    }
+
+    bits.resize(size.x, size.y);
+}
+
+
+
+void Board::saveState(BoardState& state) const
+{
+    state.cells = cells;
+    state.freeCells = freeCells;
+    state.freeSlots = freeSlots;
+    state.unusedIds = unusedIds;
+    state.snakeIdCount = snakes.size();
+    state.bits = bits;
+
+    const std::size_t tileArea = static_cast<std::size_t>(tileSize) * tileSize;
+    state.tileIds.clear();
+    state.tileUsed.clear();
+    state.tileCells.clear();
+    for (std::size_t t = 0; t < tiles.size(); ++t)
+    {
+        if (tiles[t] != nullptr)
+        {
+            state.tileIds.push_back(static_cast<std::uint32_t>(t));
+            state.tileUsed.push_back(tiles[t]->used);
+            state.tileCells.insert(state.tileCells.end(), tiles[t]->cells, tiles[t]->cells + tileArea);
+        }
+    }
+    state.occupied = occupied;
+}
+
+
+
+void Board::setCell(const Vec2& pos, int owner, unsigned int segment)
+{
+    if (sparse)
+    {
+        setTileCell(pos, owner, segment);
+        return;
+    }
+
+    std::size_t cellIndex = index(pos);
+    BoardCell& cell = cells[cellIndex];
+    bool wasEmpty = cell.owner == OWNER_EMPTY;
+    bool isEmpty = owner == OWNER_EMPTY;
+
+    // Food is never on the border, and a snake that leaves the border leaves it blocked
+    if (owner >= 0 || cell.owner >= 0)
+    {
+        bits.setBlocked(pos, owner >= 0 || isBorder(pos));
+    }
+    if (owner == OWNER_FOOD || cell.owner == OWNER_FOOD)
+    {
+        bits.setFood(pos, owner == OWNER_FOOD);
+    }
+
+    cell.owner = owner;
+    cell.segment = segment;
+
+    if (wasEmpty == isEmpty)
+    {
+        return;
+    }
+
+    std::uint32_t slot = freeSlots[cellIndex];
+    if (isEmpty)
+    {
+        // Border cells are never added to the index
+        if (slot == notFree && !isBorder(pos))
+        {
+            freeSlots[cellIndex] = static_cast<std::uint32_t>(freeCells.size());
+            freeCells.push_back(static_cast<std::uint32_t>(cellIndex));
+        }
+    }
+    else if (slot != notFree)
+    {
+        // Swap with the last free cell so that removal is constant time
+        std::uint32_t last = freeCells.back();
+        freeCells[slot] = last;
+        freeSlots[last] = slot;
+        freeCells.pop_back();
+        freeSlots[cellIndex] = notFree;
+    }
+}
+
+
+
+void Board::setFood(const Vec2& pos, unsigned int foodIndex)
+{
+    setCell(pos, OWNER_FOOD, foodIndex);
+}
+
+
+
+void Board::setSnake(const Vec2& pos, int owner, unsigned int segment)
+{
+    setCell(pos, owner, segment);
+}
+
+
+
+void Board::setTileCell(const Vec2& pos, int owner, unsigned int segment)
+{
+    std::size_t t = tileIndex(pos);
+    Tile* tile = tiles[t].get();
+    bool isEmpty = owner == OWNER_EMPTY;
+    if (tile == nullptr)
+    {
+        // Emptying a cell of a tile that isn't there is already done
+        if (isEmpty)
+        {
+            return;
+        }
+        tile = allocateTile(t);
+    }
+
+    BoardCell& cell = tile->cells[tileCellIndex(pos)];
+    bool wasEmpty = cell.owner == OWNER_EMPTY;
+    cell.owner = owner;
+    cell.segment = segment;
+
+    if (wasEmpty == isEmpty)
+    {
+        return;
+    }
+
+    // Border cells are never free, so they don't count as occupied either
+    std::size_t interior = isBorder(pos) ? 0 : 1;
+    if (isEmpty)
+    {
+        --tile->used;
+        occupied -= interior;
+        if (tile->used == 0)
+        {
+            releaseTile(t);
+        }
+    }
+    else
+    {
+        ++tile->used;
+        occupied += interior;
+    }
+}
+
+
+
+std::size_t Board::tileCellIndex(const Vec2& pos)
+{
+    return static_cast<std::size_t>(pos.y & (tileSize - 1)) * tileSize + (pos.x & (tileSize - 1));
+}
+
+
+
+std::size_t Board::tileIndex(const Vec2& pos) const
+{
+    assert(contains(pos));
+
+    return static_cast<std::size_t>(pos.y >> tileShift) * tileCount.x + (pos.x >> tileShift);
+}
+
+}
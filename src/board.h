@@ -0,0 +1,290 @@
+
+// board.h
+// Occupancy grid of the game area
+//
+
+#ifndef SLICERSNAKE_BOARD_H
+#define SLICERSNAKE_BOARD_H
+
+
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "bitboard.h"
+#include "display.h"
+#include "random.h"
+
+
+namespace ssnake
+{
+
+class Snake;
+
+
+
+// Special owners for cells that are not owned by a snake
+enum CellOwner_t
+{
+    OWNER_EMPTY = -1, OWNER_FOOD = -2
+};
+
+
+
+// A cell is either empty, food, or owned by a snake.
+// Segments of a snake are numbered in the order they were added, so that the distance between
+// a segment and the snake's tail segment gives its position in the body.
+// For food, segment holds the index of the food in the game's food list.
+struct BoardCell
+{
+    int owner;
+    unsigned int segment;
+};
+
+
+
+// Copy of everything on a board except the addresses of its snakes, see Board::saveState
+struct BoardState
+{
+    std::vector<BoardCell> cells;
+    std::vector<std::uint32_t> freeCells;
+    std::vector<std::uint32_t> freeSlots;
+    std::vector<int> unusedIds;
+    std::size_t snakeIdCount = 0;
+    BitBoard bits;
+
+    // Tiles of a sparse board, in the order of their index, with their cells one tile after the other
+    std::vector<std::uint32_t> tileIds;
+    std::vector<std::uint32_t> tileUsed;
+    std::vector<BoardCell> tileCells;
+    std::size_t occupied = 0;
+};
+
+
+
+// Boards of up to denseCellLimit cells keep every cell in one grid, with an index of the free cells
+// and a BitBoard for the AI.
+// Larger boards are sparse: their cells are kept in square tiles that are only allocated once something
+// is placed on them, and released again when they empty, so that a huge arena with a few snakes only
+// takes memory for the area they cover. Free cells are found by trying random cells instead of an index.
+class Board
+{
+
+public:
+
+    // PreConditions:
+    //   size_x and size_y are the size of the game area, including the border
+    // PostConditions:
+    //   An empty board of the given size is created
+    Board(const coordType size_x, const coordType size_y);
+
+    // PreConditions:
+    //   No snakes are registered with the board
+    // PostConditions:
+    //   The board is the same as a newly created board of its size, so games on it play out the same
+    void reset();
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the size of the board (units of "snake chunks")
+    coordType getSize_x() const;
+    coordType getSize_y() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if pos is inside of the board (the border is inside of the board)
+    bool contains(const Vec2& pos) const;
+
+    // PreConditions:
+    //   pos is contained in the board
+    // PostConditions:
+    //   Returns the contents of the cell at pos
+    const BoardCell& getCell(const Vec2& pos) const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if the board keeps its cells in tiles, see the class comment
+    bool isSparse() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if a board of size_x by size_y (including the border) would be sparse
+    static bool isSparseSize(coordType size_x, coordType size_y);
+
+    // PreConditions:
+    //   The board is not sparse
+    // PostConditions:
+    //   Returns every cell of the board in row-major order, for searches that walk the whole board
+    const std::vector<BoardCell>& getCells() const;
+
+    // PreConditions:
+    //   The board is not sparse
+    // PostConditions:
+    //   Returns the board as bits, with every snake and the border blocked, for checks over many cells
+    const BitBoard& getBitBoard() const;
+
+    // PreConditions:
+    //   pos is inside of the border
+    // PostConditions:
+    //   Returns the cells next to pos that are not a snake or the border, as bit d for each Direction_t d
+    unsigned int getOpenSteps(const Vec2& pos) const;
+
+    // PreConditions:
+    //   pos is contained in the board
+    // PostConditions:
+    //   Returns the number of cells that can be reached from pos without going through a snake or the border,
+    //   counting pos itself, or 0 if pos is a snake or the border.
+    //   Stops early once at least enough cells were reached, and returns a number that is at least enough
+    std::size_t countReachable(const Vec2& pos, std::size_t enough) const;
+
+    // PreConditions:
+    //   pos is contained in the board
+    // PostConditions:
+    //   Returns true if nothing occupies the cell at pos
+    bool isEmpty(const Vec2& pos) const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of empty cells inside of the border
+    std::size_t getFreeCount() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true and sets pos to a random empty cell inside of the border, drawn from rng,
+    //   or returns false if there are none
+    bool pickFreeCell(Random& rng, Vec2& pos) const;
+
+    // PreConditions:
+    //   pos is contained in the board
+    // PostConditions:
+    //   The cell at pos is owned by the given snake segment, replacing anything that was there
+    void setSnake(const Vec2& pos, int owner, unsigned int segment);
+
+    // PreConditions:
+    //   pos is contained in the board
+    // PostConditions:
+    //   The cell at pos is emptied if it is still owned by the given snake segment
+    void clearSnake(const Vec2& pos, int owner, unsigned int segment);
+
+    // PreConditions:
+    //   pos is contained in the board
+    // PostConditions:
+    //   The cell at pos contains the food with index foodIndex, replacing anything that was there
+    void setFood(const Vec2& pos, unsigned int foodIndex);
+
+    // PreConditions:
+    //   pos is contained in the board
+    // PostConditions:
+    //   The cell at pos is emptied if it contains food
+    void clearFood(const Vec2& pos);
+
+    // PreConditions:
+    //   snake is not already registered
+    // PostConditions:
+    //   Returns a new owner id that maps to snake
+    int addSnake(Snake* snake);
+
+    // PreConditions:
+    //   id was returned by addSnake, and none of the board cells are owned by it anymore
+    // PostConditions:
+    //   id no longer maps to a snake, and may be reused by addSnake
+    void removeSnake(int id);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the snake that owns id, or nullptr if no snake owns it
+    Snake* getSnake(int id) const;
+
+    // PreConditions:
+    // PostConditions:
+    //   state holds a copy of the board, reusing the storage it already has
+    void saveState(BoardState& state) const;
+
+    // PreConditions:
+    //   state was saved from a board of the same size
+    // PostConditions:
+    //   The board is the same as when state was saved, but every id that was in use maps to nullptr
+    //   until its snake is attached again
+    void loadState(const BoardState& state);
+
+    // PreConditions:
+    //   id was in use when the state loaded with loadState was saved
+    // PostConditions:
+    //   id maps to snake
+    void attachSnake(int id, Snake* snake);
+
+
+private:
+
+    // Boards larger than this are sparse (a 2048x2048 board is still dense)
+    static const std::size_t denseCellLimit = std::size_t(1) << 22;
+
+    // Tiles are 32x32 cells, 8 KB
+    static const int tileShift = 5;
+    static const coordType tileSize = 1 << tileShift;
+
+    // Released tiles are kept for reuse up to this many, so a snake going back and forth over
+    // the edge of a tile doesn't allocate every time
+    static const std::size_t maxSpareTiles = 16;
+
+    struct Tile
+    {
+        BoardCell cells[tileSize * tileSize];
+        // Cells that are not empty
+        std::uint32_t used;
+    };
+
+    std::size_t index(const Vec2& pos) const;
+    std::size_t tileIndex(const Vec2& pos) const;
+    static std::size_t tileCellIndex(const Vec2& pos);
+
+    bool isBorder(const Vec2& pos) const;
+
+    // Not a snake or the border
+    bool isOpen(const Vec2& pos) const;
+
+    // Changes the contents of a cell, keeping the free cell index and the bits up to date
+    void setCell(const Vec2& pos, int owner, unsigned int segment);
+    void setTileCell(const Vec2& pos, int owner, unsigned int segment);
+
+    // Puts an empty tile at index t of the tiles, and returns it
+    Tile* allocateTile(std::size_t t);
+    // Takes the tile at index t out of the tiles
+    void releaseTile(std::size_t t);
+
+    Vec2 size;
+    bool sparse;
+
+    // Cells in row-major order, empty if the board is sparse
+    std::vector<BoardCell> cells;
+
+    // Tiles of a sparse board in row-major order, nullptr where nothing is placed.
+    // occupied counts the cells inside of the border that are not empty.
+    Vec2 tileCount;
+    std::vector<std::unique_ptr<Tile>> tiles;
+    std::vector<std::unique_ptr<Tile>> spareTiles;
+    std::size_t occupied;
+
+    // Cells seen by countReachable on a sparse board, only kept to not allocate on every call
+    mutable std::vector<Vec2> searchQueue;
+    mutable std::unordered_set<std::uint64_t> searchSeen;
+
+    // Indexes of the empty cells inside of the border of a dense board, in no particular order.
+    // freeSlots holds the position of each cell in freeCells, or notFree for occupied and border cells.
+    // 32 bits is plenty for any board that fits in memory, and keeps the index and snapshots small.
+    static const std::uint32_t notFree = static_cast<std::uint32_t>(-1);
+    std::vector<std::uint32_t> freeCells;
+    std::vector<std::uint32_t> freeSlots;
+
+    // Empty if the board is sparse
+    BitBoard bits;
+
+    // Owner ids index into snakes, unused ids are nullptr
+    std::vector<Snake*> snakes;
+    std::vector<int> unusedIds;
+};
+
+}
+
+#endif
@@ -0,0 +1,781 @@
+
+#include "classic_batch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "display.h"
+#include "game.h"
+#include "random.h"
+#include "snake.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SSNAKE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// Games are stepped a few vectors at a time, so that their values are still in cache for the scalar part
+const std::size_t chunkLanes = 64;
+
+// Lanes are padded to whole vectors of the widest SIMD level
+const std::size_t maxVectorLanes = 16;
+
+// Where the snake starts, the same as in SnakeGame::initClassicGame
+const Vec2 startingPos = {4, 3};
+const std::int32_t startingLength = 3;
+
+// ClassicBatch::LaneCell is two 32 bit words, starting with lastVisit
+const std::size_t laneCellWords = 2;
+
+
+
+// The values of ClassicBatch that moving the heads reads and writes, and the board they are on
+struct HeadLanes
+{
+    const std::int32_t* alive;
+    const std::int32_t* direction;
+    std::int32_t* head_x;
+    std::int32_t* head_y;
+    std::int32_t* headCell;
+    const std::int32_t* length;
+    std::uint32_t* headSegment;
+    std::uint32_t* tailSegment;
+    const std::int32_t* foodCell;
+    // lastVisit of the first cell of the first game, the next cell's is laneCellWords further
+    const std::uint32_t* lastVisit;
+    std::int32_t* events;
+
+    std::int32_t size_x;
+    std::int32_t size_y;
+    std::int32_t cellCount;
+
+    std::int32_t eventWall;
+    std::int32_t eventSelf;
+    std::int32_t eventFood;
+    std::int32_t eventGrow;
+};
+
+
+
+// Direction of a snake going in the first direction after the key is pressed, the same as Snake::setDirection.
+// Classic snakes are never shorter than 3, so they can never turn around.
+const Direction_t turns[4][NONE + 1] =
+{
+    // RIGHT_KEY, LEFT_KEY, UP_KEY, DOWN_KEY, NONE
+    {RIGHT, RIGHT, UP, DOWN, RIGHT},
+    {LEFT, LEFT, UP, DOWN, LEFT},
+    {RIGHT, LEFT, UP, UP, UP},
+    {RIGHT, LEFT, DOWN, DOWN, DOWN}
+};
+
+
+
+// Asks for the cache line of address to be loaded, without waiting for it
+inline void prefetch(const void* address)
+{
+#ifdef __GNUC__
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+
+
+// Steps of each Direction_t
+const std::int32_t stepX[4] = {1, -1, 0, 0};
+const std::int32_t stepY[4] = {0, 0, -1, 1};
+
+
+
+void moveHeadsScalar(const HeadLanes& lanes, std::size_t begin, std::size_t end)
+{
+    const std::int32_t stepCell[4] = {1, -1, -lanes.size_x, lanes.size_x};
+
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        if (lanes.alive[i] == 0)
+        {
+            lanes.events[i] = 0;
+            continue;
+        }
+
+        std::int32_t d = lanes.direction[i];
+        std::int32_t x = lanes.head_x[i] + stepX[d];
+        std::int32_t y = lanes.head_y[i] + stepY[d];
+        std::int32_t cell = lanes.headCell[i] + stepCell[d];
+
+        // The tail stays put on the step after eating
+        std::uint32_t bodySize = lanes.headSegment[i] - lanes.tailSegment[i] + 1;
+        bool grow = static_cast<std::uint32_t>(lanes.length[i]) > bodySize;
+        std::uint32_t tail = lanes.tailSegment[i] + (grow ? 0 : 1);
+
+        std::int32_t event = 0;
+        if (x <= 0 || y <= 0 || x >= lanes.size_x - 1 || y >= lanes.size_y - 1)
+        {
+            event |= lanes.eventWall;
+        }
+        if (lanes.lastVisit[(i * lanes.cellCount + cell) * laneCellWords] > tail)
+        {
+            event |= lanes.eventSelf;
+        }
+        if (cell == lanes.foodCell[i])
+        {
+            event |= lanes.eventFood;
+        }
+        if (grow)
+        {
+            event |= lanes.eventGrow;
+        }
+
+        lanes.head_x[i] = x;
+        lanes.head_y[i] = y;
+        lanes.headCell[i] = cell;
+        lanes.headSegment[i] += 1;
+        lanes.tailSegment[i] = tail;
+        lanes.events[i] = event;
+    }
+}
+
+
+
+#ifdef SSNAKE_X86_SIMD
+
+// Same as moveHeadsScalar, 8 games at a time.
+// begin and end are multiples of 8.
+__attribute__((target("avx2")))
+void moveHeadsAvx2(const HeadLanes& lanes, std::size_t begin, std::size_t end)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i signBit = _mm256_set1_epi32(INT32_MIN);
+    const __m256i maxX = _mm256_set1_epi32(lanes.size_x - 2);
+    const __m256i maxY = _mm256_set1_epi32(lanes.size_y - 2);
+
+    // Indexed by direction
+    const __m256i stepXs = _mm256_setr_epi32(1, -1, 0, 0, 0, 0, 0, 0);
+    const __m256i stepYs = _mm256_setr_epi32(0, 0, -1, 1, 0, 0, 0, 0);
+    const __m256i stepCells = _mm256_setr_epi32(1, -1, -lanes.size_x, lanes.size_x, 0, 0, 0, 0);
+
+    const __m256i eventWall = _mm256_set1_epi32(lanes.eventWall);
+    const __m256i eventSelf = _mm256_set1_epi32(lanes.eventSelf);
+    const __m256i eventFood = _mm256_set1_epi32(lanes.eventFood);
+    const __m256i eventGrow = _mm256_set1_epi32(lanes.eventGrow);
+
+    // Offset of the cells of each lane
+    const __m256i laneCells = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                 _mm256_set1_epi32(lanes.cellCount));
+
+    for (std::size_t i = begin; i < end; i += 8)
+    {
+        __m256i alive = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.alive + i));
+        if (_mm256_testz_si256(alive, alive))
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.events + i), _mm256_setzero_si256());
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.direction + i));
+        __m256i oldX = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.head_x + i));
+        __m256i oldY = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.head_y + i));
+        __m256i oldCell = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.headCell + i));
+        __m256i x = _mm256_add_epi32(oldX, _mm256_permutevar8x32_epi32(stepXs, d));
+        __m256i y = _mm256_add_epi32(oldY, _mm256_permutevar8x32_epi32(stepYs, d));
+        __m256i cell = _mm256_add_epi32(oldCell, _mm256_permutevar8x32_epi32(stepCells, d));
+
+        __m256i headSegment = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.headSegment + i));
+        __m256i tailSegment = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.tailSegment + i));
+        __m256i length = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.length + i));
+        __m256i bodySize = _mm256_sub_epi32(_mm256_add_epi32(headSegment, one), tailSegment);
+        __m256i grow = _mm256_cmpgt_epi32(length, bodySize);
+        // grow is -1 where the tail stays put
+        __m256i tail = _mm256_add_epi32(_mm256_add_epi32(tailSegment, one), grow);
+
+        __m256i wall = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(one, x), _mm256_cmpgt_epi32(x, maxX)),
+                                       _mm256_or_si256(_mm256_cmpgt_epi32(one, y), _mm256_cmpgt_epi32(y, maxY)));
+
+        __m256i visitIndex = _mm256_add_epi32(_mm256_add_epi32(_mm256_set1_epi32(static_cast<std::int32_t>(i) * lanes.cellCount),
+                                                               laneCells),
+                                              cell);
+        __m256i visit = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(lanes.lastVisit),
+                                                    visitIndex, alive, 8);
+        // Segment numbers are unsigned, and there is no unsigned compare
+        __m256i self = _mm256_cmpgt_epi32(_mm256_xor_si256(visit, signBit), _mm256_xor_si256(tail, signBit));
+
+        __m256i foodCell = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.foodCell + i));
+        __m256i food = _mm256_cmpeq_epi32(cell, foodCell);
+
+        __m256i event = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(wall, eventWall), _mm256_and_si256(self, eventSelf)),
+                                        _mm256_or_si256(_mm256_and_si256(food, eventFood), _mm256_and_si256(grow, eventGrow)));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.events + i), _mm256_and_si256(event, alive));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.head_x + i), _mm256_blendv_epi8(oldX, x, alive));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.head_y + i), _mm256_blendv_epi8(oldY, y, alive));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.headCell + i), _mm256_blendv_epi8(oldCell, cell, alive));
+        // alive is -1 in the lanes that move
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.headSegment + i), _mm256_sub_epi32(headSegment, alive));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.tailSegment + i), _mm256_blendv_epi8(tailSegment, tail, alive));
+    }
+}
+
+
+
+// Same as moveHeadsScalar, 16 games at a time.
+// begin and end are multiples of 16.
+__attribute__((target("avx512f")))
+void moveHeadsAvx512(const HeadLanes& lanes, std::size_t begin, std::size_t end)
+{
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i maxX = _mm512_set1_epi32(lanes.size_x - 2);
+    const __m512i maxY = _mm512_set1_epi32(lanes.size_y - 2);
+
+    // Indexed by direction
+    const __m512i stepXs = _mm512_setr_epi32(1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m512i stepYs = _mm512_setr_epi32(0, 0, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m512i stepCells = _mm512_setr_epi32(1, -1, -lanes.size_x, lanes.size_x, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    const __m512i eventWall = _mm512_set1_epi32(lanes.eventWall);
+    const __m512i eventSelf = _mm512_set1_epi32(lanes.eventSelf);
+    const __m512i eventFood = _mm512_set1_epi32(lanes.eventFood);
+    const __m512i eventGrow = _mm512_set1_epi32(lanes.eventGrow);
+
+    // Offset of the cells of each lane
+    const __m512i laneCells = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+                                                 _mm512_set1_epi32(lanes.cellCount));
+
+    for (std::size_t i = begin; i < end; i += 16)
+    {
+        __m512i aliveValues = _mm512_loadu_si512(lanes.alive + i);
+        __mmask16 alive = _mm512_test_epi32_mask(aliveValues, aliveValues);
+        if (alive == 0)
+        {
+            _mm512_storeu_si512(lanes.events + i, _mm512_setzero_si512());
+            continue;
+        }
+
+        __m512i d = _mm512_loadu_si512(lanes.direction + i);
+        __m512i x = _mm512_add_epi32(_mm512_loadu_si512(lanes.head_x + i), _mm512_maskz_permutexvar_epi32(alive, d, stepXs));
+        __m512i y = _mm512_add_epi32(_mm512_loadu_si512(lanes.head_y + i), _mm512_maskz_permutexvar_epi32(alive, d, stepYs));
+        __m512i cell = _mm512_add_epi32(_mm512_loadu_si512(lanes.headCell + i), _mm512_maskz_permutexvar_epi32(alive, d, stepCells));
+
+        __m512i headSegment = _mm512_loadu_si512(lanes.headSegment + i);
+        __m512i tailSegment = _mm512_loadu_si512(lanes.tailSegment + i);
+        __m512i length = _mm512_loadu_si512(lanes.length + i);
+        __m512i bodySize = _mm512_sub_epi32(_mm512_add_epi32(headSegment, one), tailSegment);
+        // The tail stays put on the step after eating
+        __mmask16 grow = _mm512_cmpgt_epi32_mask(length, bodySize);
+        __m512i tail = _mm512_mask_add_epi32(tailSegment, static_cast<__mmask16>(~grow), tailSegment, one);
+
+        __mmask16 wall = _mm512_cmplt_epi32_mask(x, one) | _mm512_cmpgt_epi32_mask(x, maxX)
+                         | _mm512_cmplt_epi32_mask(y, one) | _mm512_cmpgt_epi32_mask(y, maxY);
+
+        __m512i visitIndex = _mm512_add_epi32(_mm512_add_epi32(_mm512_set1_epi32(static_cast<std::int32_t>(i) * lanes.cellCount),
+                                                               laneCells),
+                                              cell);
+        __m512i visit = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), alive, visitIndex, lanes.lastVisit, 8);
+        __mmask16 self = _mm512_cmpgt_epu32_mask(visit, tail);
+
+        __mmask16 food = _mm512_cmpeq_epi32_mask(cell, _mm512_loadu_si512(lanes.foodCell + i));
+
+        __m512i event = _mm512_or_si512(_mm512_or_si512(_mm512_maskz_mov_epi32(wall, eventWall), _mm512_maskz_mov_epi32(self, eventSelf)),
+                                        _mm512_or_si512(_mm512_maskz_mov_epi32(food, eventFood), _mm512_maskz_mov_epi32(grow, eventGrow)));
+
+        _mm512_storeu_si512(lanes.events + i, _mm512_maskz_mov_epi32(alive, event));
+        _mm512_mask_storeu_epi32(lanes.head_x + i, alive, x);
+        _mm512_mask_storeu_epi32(lanes.head_y + i, alive, y);
+        _mm512_mask_storeu_epi32(lanes.headCell + i, alive, cell);
+        _mm512_mask_storeu_epi32(lanes.headSegment + i, alive, _mm512_add_epi32(headSegment, one));
+        _mm512_mask_storeu_epi32(lanes.tailSegment + i, alive, tail);
+    }
+}
+
+#endif
+
+}
+
+
+
+const std::uint16_t ClassicBatch::notFree;
+const std::int32_t ClassicBatch::EVENT_WALL;
+const std::int32_t ClassicBatch::EVENT_SELF;
+const std::int32_t ClassicBatch::EVENT_FOOD;
+const std::int32_t ClassicBatch::EVENT_GROW;
+
+
+
+ClassicBatch::ClassicBatch(std::size_t gameCount, coordType size_x, coordType size_y)
+{
+    assert(size_x >= 7 && size_y >= 5);
+
+    this->gameCount = gameCount;
+    this->size_x = size_x;
+    this->size_y = size_y;
+    laneCount = (gameCount + maxVectorLanes - 1) / maxVectorLanes * maxVectorLanes;
+    cellCount = static_cast<std::uint32_t>(size_x) * static_cast<std::uint32_t>(size_y);
+
+    assert(cellCount < notFree);
+    // The vector part finds cells with 32 bit indexes
+    assert(static_cast<double>(laneCount) * cellCount < 2147483648.0);
+    static_assert(sizeof(LaneCell) == laneCellWords * sizeof(std::uint32_t), "lastVisit is gathered as every other word");
+
+    // The snake never covers more than every cell
+    historyMask = 1;
+    while (historyMask < cellCount)
+    {
+        historyMask <<= 1;
+    }
+    historyMask -= 1;
+
+    borderCells.assign(cellCount, 0);
+    for (coordType y = 0; y < size_y; ++y)
+    {
+        for (coordType x = 0; x < size_x; ++x)
+        {
+            if (x == 0 || y == 0 || x == size_x - 1 || y == size_y - 1)
+            {
+                borderCells[static_cast<std::size_t>(y) * size_x + x] = 1;
+            }
+        }
+    }
+
+    alive.assign(laneCount, 0);
+    direction.assign(laneCount, RIGHT);
+    head_x.assign(laneCount, 0);
+    head_y.assign(laneCount, 0);
+    headCell.assign(laneCount, 0);
+    length.assign(laneCount, 0);
+    headSegment.assign(laneCount, 0);
+    tailSegment.assign(laneCount, 0);
+    foodCell.assign(laneCount, -1);
+    events.assign(laneCount, 0);
+
+    stepCount.assign(laneCount, 0);
+    maxLength.assign(laneCount, 0);
+    deathCause.assign(laneCount, DEATH_NONE);
+    rng.assign(laneCount, Random());
+
+    LaneCell emptyCell = {0, notFree, 0};
+    cells.assign(laneCount * cellCount, emptyCell);
+    freeCount.assign(laneCount, 0);
+
+    history.assign(laneCount * (static_cast<std::size_t>(historyMask) + 1), 0);
+
+    // The free cell index starts out in the same order as after Board::reset
+    startingCells.assign(cellCount, emptyCell);
+    startingFreeCount = 0;
+    for (coordType y = 1; y < size_y - 1; ++y)
+    {
+        for (coordType x = 1; x < size_x - 1; ++x)
+        {
+            std::uint16_t cell = static_cast<std::uint16_t>(y * size_x + x);
+            startingCells[cell].freeSlot = static_cast<std::uint16_t>(startingFreeCount);
+            startingCells[startingFreeCount].freeCell = cell;
+            ++startingFreeCount;
+        }
+    }
+
+    // Same starting snake as the Snake constructor makes, from the tail to the head
+    startingDirection = (startingPos.x < size_x / 2) ? RIGHT : LEFT;
+    int directionModifier = (startingDirection == RIGHT) ? -1 : 1;
+    for (std::int32_t i = startingLength - 1; i >= 0; --i)
+    {
+        std::uint32_t segment = static_cast<std::uint32_t>(startingLength - 1 - i);
+        std::uint32_t cell = static_cast<std::uint32_t>(startingPos.y * size_x + startingPos.x + directionModifier * i);
+        startingCells[cell].lastVisit = segment + 1;
+        removeFreeCell(startingCells.data(), startingFreeCount, cell);
+    }
+
+    for (std::size_t game = 0; game < gameCount; ++game)
+    {
+        newGame(game, game);
+    }
+
+    simdLevel = getBestSimdLevel();
+}
+
+
+
+void ClassicBatch::addFreeCell(LaneCell* gameCells, std::uint32_t& count, std::uint32_t cell)
+{
+    if (gameCells[cell].freeSlot != notFree || borderCells[cell])
+    {
+        return;
+    }
+
+    gameCells[cell].freeSlot = static_cast<std::uint16_t>(count);
+    gameCells[count].freeCell = static_cast<std::uint16_t>(cell);
+    ++count;
+}
+
+
+
+SimdLevel_t ClassicBatch::getBestSimdLevel()
+{
+#ifdef SSNAKE_X86_SIMD
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SIMD_AVX2;
+    }
+#endif
+
+    return SIMD_NONE;
+}
+
+
+
+DeathCause_t ClassicBatch::getDeathCause(std::size_t game) const
+{
+    assert(game < gameCount);
+
+    return deathCause[game];
+}
+
+
+
+Direction_t ClassicBatch::getDirection(std::size_t game) const
+{
+    assert(game < gameCount);
+
+    return static_cast<Direction_t>(direction[game]);
+}
+
+
+
+bool ClassicBatch::getFood(std::size_t game, Vec2& pos) const
+{
+    assert(game < gameCount);
+
+    if (foodCell[game] < 0)
+    {
+        return false;
+    }
+
+    pos.x = foodCell[game] % size_x;
+    pos.y = foodCell[game] / size_x;
+    return true;
+}
+
+
+
+std::size_t ClassicBatch::getGameCount() const
+{
+    return gameCount;
+}
+
+
+
+Vec2 ClassicBatch::getHead(std::size_t game) const
+{
+    assert(game < gameCount);
+
+    Vec2 pos = {head_x[game], head_y[game]};
+    return pos;
+}
+
+
+
+std::size_t ClassicBatch::getMaxLength(std::size_t game) const
+{
+    assert(game < gameCount);
+
+    return maxLength[game];
+}
+
+
+
+std::size_t ClassicBatch::getPlayerLength(std::size_t game) const
+{
+    assert(game < gameCount);
+
+    return static_cast<std::size_t>(length[game]);
+}
+
+
+
+SimdLevel_t ClassicBatch::getSimdLevel() const
+{
+    return simdLevel;
+}
+
+
+
+unsigned long ClassicBatch::getStepCount(std::size_t game) const
+{
+    assert(game < gameCount);
+
+    return stepCount[game];
+}
+
+
+
+bool ClassicBatch::isAlive(std::size_t game) const
+{
+    assert(game < gameCount);
+
+    return alive[game] != 0;
+}
+
+
+
+bool ClassicBatch::isSnake(std::size_t game, const Vec2& pos) const
+{
+    assert(game < gameCount);
+    assert(pos.x >= 0 && pos.y >= 0 && pos.x < size_x && pos.y < size_y);
+
+    std::size_t cell = static_cast<std::size_t>(pos.y) * size_x + pos.x;
+    std::uint32_t visit = cells[game * cellCount + cell].lastVisit;
+    return visit != 0 && visit - 1 >= tailSegment[game] && visit - 1 <= headSegment[game];
+}
+
+
+
+void ClassicBatch::moveHeads(std::size_t begin, std::size_t end)
+{
+    HeadLanes lanes;
+    lanes.alive = alive.data();
+    lanes.direction = direction.data();
+    lanes.head_x = head_x.data();
+    lanes.head_y = head_y.data();
+    lanes.headCell = headCell.data();
+    lanes.length = length.data();
+    lanes.headSegment = headSegment.data();
+    lanes.tailSegment = tailSegment.data();
+    lanes.foodCell = foodCell.data();
+    lanes.lastVisit = &cells.data()->lastVisit;
+    lanes.events = events.data();
+    lanes.size_x = size_x;
+    lanes.size_y = size_y;
+    lanes.cellCount = static_cast<std::int32_t>(cellCount);
+    lanes.eventWall = EVENT_WALL;
+    lanes.eventSelf = EVENT_SELF;
+    lanes.eventFood = EVENT_FOOD;
+    lanes.eventGrow = EVENT_GROW;
+
+    switch (simdLevel)
+    {
+#ifdef SSNAKE_X86_SIMD
+        case SIMD_AVX512:
+        moveHeadsAvx512(lanes, begin, end);
+        break;
+
+        case SIMD_AVX2:
+        moveHeadsAvx2(lanes, begin, end);
+        break;
+#endif
+
+        default:
+        moveHeadsScalar(lanes, begin, end);
+        break;
+    }
+}
+
+
+
+void ClassicBatch::newGame(std::size_t game, std::uint64_t seed)
+{
+    assert(game < gameCount);
+
+    rng[game].seed(seed);
+
+    std::copy(startingCells.begin(), startingCells.end(), cells.begin() + game * cellCount);
+    freeCount[game] = startingFreeCount;
+
+    std::uint16_t* headHistory = &history[game * (static_cast<std::size_t>(historyMask) + 1)];
+    int directionModifier = (startingDirection == RIGHT) ? -1 : 1;
+    for (std::int32_t i = startingLength - 1; i >= 0; --i)
+    {
+        std::int32_t segment = startingLength - 1 - i;
+        headHistory[segment] = static_cast<std::uint16_t>(startingPos.y * size_x + startingPos.x + directionModifier * i);
+    }
+
+    alive[game] = -1;
+    direction[game] = startingDirection;
+    head_x[game] = startingPos.x;
+    head_y[game] = startingPos.y;
+    headCell[game] = startingPos.y * size_x + startingPos.x;
+    length[game] = startingLength;
+    headSegment[game] = static_cast<std::uint32_t>(startingLength - 1);
+    tailSegment[game] = 0;
+    events[game] = 0;
+
+    stepCount[game] = 0;
+    maxLength[game] = static_cast<std::uint32_t>(startingLength);
+    deathCause[game] = DEATH_NONE;
+
+    spawnFood(game);
+}
+
+
+
+void ClassicBatch::removeFreeCell(LaneCell* gameCells, std::uint32_t& count, std::uint32_t cell)
+{
+    std::uint16_t slot = gameCells[cell].freeSlot;
+    if (slot == notFree)
+    {
+        return;
+    }
+
+    // Swap with the last free cell, like Board does
+    std::uint16_t last = gameCells[count - 1].freeCell;
+    gameCells[slot].freeCell = last;
+    gameCells[last].freeSlot = slot;
+    --count;
+    gameCells[cell].freeSlot = notFree;
+}
+
+
+
+void ClassicBatch::setSimdLevel(SimdLevel_t level)
+{
+    assert(level <= getBestSimdLevel());
+
+    simdLevel = level;
+}
+
+
+
+void ClassicBatch::spawnFood(std::size_t game)
+{
+    if (freeCount[game] == 0)
+    {
+        foodCell[game] = -1;
+        return;
+    }
+
+    LaneCell* gameCells = &cells[game * cellCount];
+    std::uint32_t cell = gameCells[rng[game].below(freeCount[game])].freeCell;
+    removeFreeCell(gameCells, freeCount[game], cell);
+    foodCell[game] = static_cast<std::int32_t>(cell);
+}
+
+
+
+void ClassicBatch::step(const std::vector<PlayerAction>& actions, std::vector<StepResult>& results)
+{
+    assert(actions.size() >= gameCount);
+
+    results.resize(gameCount);
+
+    for (std::size_t begin = 0; begin < laneCount; begin += chunkLanes)
+    {
+        std::size_t end = (begin + chunkLanes < laneCount) ? begin + chunkLanes : laneCount;
+        std::size_t gameEnd = (end < gameCount) ? end : gameCount;
+
+        // Directions are chosen the same way as SnakeGame::applyAction, but without branches on the keys,
+        // since players of many games at once press keys that are hard to predict
+        for (std::size_t game = begin; game < gameEnd; ++game)
+        {
+            if (alive[game] == 0)
+            {
+                continue;
+            }
+
+            const PlayerAction& action = actions[game];
+            assert(!action.autopilot);
+
+            if (action.quit)
+            {
+                deathCause[game] = DEATH_QUIT;
+            }
+
+            Direction_t oldDirection = static_cast<Direction_t>(direction[game]);
+            Direction_t newDirection = turns[oldDirection][action.direction];
+            if (newDirection == oldDirection)
+            {
+                newDirection = turns[oldDirection][action.prevDirection];
+            }
+            direction[game] = newDirection;
+        }
+
+        moveHeads(begin, end);
+
+        // The cells the tail leaves and the free cell slots the heads take are all over memory when there are
+        // many games, so they are fetched for the whole chunk before any game waits on them
+        for (std::size_t game = begin; game < gameEnd; ++game)
+        {
+            if (alive[game] == 0)
+            {
+                continue;
+            }
+
+            const LaneCell* gameCells = &cells[game * cellCount];
+            const std::uint16_t* headHistory = &history[game * (static_cast<std::size_t>(historyMask) + 1)];
+            prefetch(&gameCells[headHistory[(tailSegment[game] - 1) & historyMask]]);
+            std::uint16_t slot = gameCells[headCell[game]].freeSlot;
+            if (slot != notFree)
+            {
+                prefetch(&gameCells[slot]);
+                prefetch(&gameCells[freeCount[game] - 1]);
+            }
+        }
+
+        // The rest follows the order of Snake::move and SnakeGame::stepClassicGame,
+        // so that the free cell index changes the same way as the board's
+        for (std::size_t game = begin; game < gameEnd; ++game)
+        {
+            StepResult& result = results[game];
+            result = StepResult();
+            if (alive[game] == 0)
+            {
+                continue;
+            }
+
+            std::int32_t event = events[game];
+            LaneCell* gameCells = &cells[game * cellCount];
+            std::uint16_t* headHistory = &history[game * (static_cast<std::size_t>(historyMask) + 1)];
+            if ((event & EVENT_GROW) == 0)
+            {
+                addFreeCell(gameCells, freeCount[game], headHistory[(tailSegment[game] - 1) & historyMask]);
+            }
+
+            std::uint32_t cell = static_cast<std::uint32_t>(headCell[game]);
+            if ((event & (EVENT_SELF | EVENT_FOOD)) == 0)
+            {
+                removeFreeCell(gameCells, freeCount[game], cell);
+            }
+            gameCells[cell].lastVisit = headSegment[game] + 1;
+            headHistory[headSegment[game] & historyMask] = static_cast<std::uint16_t>(cell);
+
+            if (event & EVENT_FOOD)
+            {
+                ++length[game];
+                if (static_cast<std::uint32_t>(length[game]) > maxLength[game])
+                {
+                    maxLength[game] = static_cast<std::uint32_t>(length[game]);
+                }
+                ++result.foodEaten;
+
+                spawnFood(game);
+            }
+
+            // A player that quit during this step keeps that as the reason
+            if ((event & (EVENT_WALL | EVENT_SELF)) && deathCause[game] == DEATH_NONE)
+            {
+                deathCause[game] = (event & EVENT_WALL) ? DEATH_WALL : DEATH_SELF;
+            }
+            if (deathCause[game] != DEATH_NONE)
+            {
+                alive[game] = 0;
+            }
+
+            ++stepCount[game];
+
+            result.alive = alive[game] != 0;
+            result.playerLength = static_cast<std::size_t>(length[game]);
+        }
+    }
+}
+
+}
@@ -0,0 +1,200 @@
+
+// classic_batch.h
+// Many Classic games stepped together in lockstep, for training computer players
+//
+
+#ifndef SLICERSNAKE_CLASSIC_BATCH_H
+#define SLICERSNAKE_CLASSIC_BATCH_H
+
+
+#include <cstdint>
+#include <vector>
+
+#include "display.h"
+#include "game.h"
+#include "random.h"
+#include "snake.h"
+
+
+namespace ssnake
+{
+
+// Vector instructions used to step the games, from slowest to fastest
+enum SimdLevel_t
+{
+    SIMD_NONE, SIMD_AVX2, SIMD_AVX512
+};
+
+
+
+// Plays any number of independent Classic games of the same board size, one step of every game at a time.
+// Games are kept as arrays of each value across games instead of Snake objects, so the moves, wall,
+// body and food checks of 8 (AVX2) or 16 (AVX-512) games are done with one instruction each.
+// Only the free cell index that food spawns from is updated one game at a time, since its order has to be
+// the same as on a Board for the games to play out exactly like SnakeGame's Classic games.
+class ClassicBatch
+{
+
+public:
+
+    // PreConditions:
+    //   size_x is at least 7 and size_y at least 5, so that the starting snake fits on the board,
+    //   and the board has less than 65535 cells
+    // PostConditions:
+    //   gameCount games are set up on boards of size_x by size_y (board size, not display size),
+    //   each started with its index as the seed, and stepped with the fastest SIMD level of the cpu
+    ClassicBatch(std::size_t gameCount, coordType size_x, coordType size_y);
+
+    // PreConditions:
+    //   game is less than getGameCount()
+    // PostConditions:
+    //   game is started over, playing out the same as SnakeGame::newGame(GM_CLASSIC, seed) on a board of this size
+    void newGame(std::size_t game, std::uint64_t seed);
+
+    // PreConditions:
+    //   actions holds the action of every game in order, autopilot is not set in any of them
+    // PostConditions:
+    //   Every game that is not over is advanced by exactly one step, the same as SnakeGame::step
+    //   results holds the outcome of the step of every game, default results for games that were over
+    void step(const std::vector<PlayerAction>& actions, std::vector<StepResult>& results);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of games in the batch
+    std::size_t getGameCount() const;
+
+    // PreConditions:
+    //   game is less than getGameCount()
+    // PostConditions:
+    //   Returns the same as the SnakeGame method of the same name would for the game
+    bool isAlive(std::size_t game) const;
+    unsigned long getStepCount(std::size_t game) const;
+    std::size_t getPlayerLength(std::size_t game) const;
+    std::size_t getMaxLength(std::size_t game) const;
+    DeathCause_t getDeathCause(std::size_t game) const;
+
+    // PreConditions:
+    //   game is less than getGameCount()
+    // PostConditions:
+    //   Returns the position of the head of the snake of game
+    Vec2 getHead(std::size_t game) const;
+
+    // PreConditions:
+    //   game is less than getGameCount()
+    // PostConditions:
+    //   Returns the direction of the snake of game
+    Direction_t getDirection(std::size_t game) const;
+
+    // PreConditions:
+    //   game is less than getGameCount()
+    // PostConditions:
+    //   Returns true and sets pos to the food of game, or returns false if the board was too full for food
+    bool getFood(std::size_t game, Vec2& pos) const;
+
+    // PreConditions:
+    //   game is less than getGameCount(), pos is on the board
+    // PostConditions:
+    //   Returns true if the snake of game covers pos
+    bool isSnake(std::size_t game, const Vec2& pos) const;
+
+    // PreConditions:
+    //   level is supported by the cpu, see getBestSimdLevel
+    // PostConditions:
+    //   Steps are done with level from now on, which doesn't change how the games play out
+    void setSimdLevel(SimdLevel_t level);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the SIMD level steps are done with
+    SimdLevel_t getSimdLevel() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the fastest SIMD level that the cpu supports
+    static SimdLevel_t getBestSimdLevel();
+
+
+private:
+
+    // Slot of the cells that are not in the free cell index
+    static const std::uint16_t notFree = 0xFFFF;
+
+    // Bits of events, set by the vector part of a step for each game
+    static const std::int32_t EVENT_WALL = 1;
+    static const std::int32_t EVENT_SELF = 2;
+    static const std::int32_t EVENT_FOOD = 4;
+    static const std::int32_t EVENT_GROW = 8;
+
+    // Everything a game keeps about one cell, together so that a step touches as few cache lines as it can.
+    // lastVisit is 1 + the segment number the head had when it last went into the cell, or 0 if it never did.
+    // Since a snake only goes into cells it isn't covering, the cell is covered if that segment is not behind the tail.
+    // freeSlot is where the cell is in the free cell index, and freeCell is the cell in slot (index of this cell) of it.
+    struct LaneCell
+    {
+        std::uint32_t lastVisit;
+        std::uint16_t freeSlot;
+        std::uint16_t freeCell;
+    };
+
+    // Moves the heads of games [begin, end) and sets their events, with the current SIMD level
+    void moveHeads(std::size_t begin, std::size_t end);
+
+    // Same as Board::setCell making the cell free or taken, for the free cell index of game
+    void addFreeCell(LaneCell* gameCells, std::uint32_t& count, std::uint32_t cell);
+    void removeFreeCell(LaneCell* gameCells, std::uint32_t& count, std::uint32_t cell);
+
+    // Same as SnakeGame::spawnFood
+    void spawnFood(std::size_t game);
+
+    std::size_t gameCount;
+    // Number of games rounded up to whole AVX-512 vectors, the games past gameCount are never alive
+    std::size_t laneCount;
+
+    SimdLevel_t simdLevel = SIMD_NONE;
+
+    Direction_t startingDirection;
+
+    coordType size_x;
+    coordType size_y;
+    std::uint32_t cellCount;
+
+    // Ring of the cells the head went through, indexed by segment number & historyMask
+    std::uint32_t historyMask;
+
+    // True for the cells of the border, the same for every game
+    std::vector<std::uint8_t> borderCells;
+
+    // One value of every game (and lane), -1 for true in alive
+    std::vector<std::int32_t> alive;
+    std::vector<std::int32_t> direction;
+    std::vector<std::int32_t> head_x;
+    std::vector<std::int32_t> head_y;
+    std::vector<std::int32_t> headCell;
+    std::vector<std::int32_t> length;
+    // Segment numbers of the head and tail, numbered the same as on a Board
+    std::vector<std::uint32_t> headSegment;
+    std::vector<std::uint32_t> tailSegment;
+    // -1 if there is no food
+    std::vector<std::int32_t> foodCell;
+    std::vector<std::int32_t> events;
+
+    std::vector<std::uint32_t> stepCount;
+    std::vector<std::uint32_t> maxLength;
+    std::vector<DeathCause_t> deathCause;
+    std::vector<Random> rng;
+
+    // cellCount cells of each game
+    std::vector<LaneCell> cells;
+    std::vector<std::uint32_t> freeCount;
+
+    // Cells of a game that was just set up, before its food is spawned
+    std::vector<LaneCell> startingCells;
+    std::uint32_t startingFreeCount;
+
+    // historyMask + 1 values of each game
+    std::vector<std::uint16_t> history;
+};
+
+}
+
+#endif
@@ -1,184 +1,145 @@
-
-// display.h
-// Handles display messily using curses backend
-//
-
-#ifndef SLICERSNAKE_DISPLAY_H
-#define SLICERSNAKE_DISPLAY_H
-
-
-#include <cstdlib> // size_t, system (windows)
-
-#ifdef _WIN32
-    #include "curses.h" // pdcurses for windows
-#else
-    #include <ncurses.h> // ncurses for linux (and whatever else it happens to work on)
-#endif
-
-
-namespace ssnake
-{
-
-typedef int coordType;
-
-
-
-struct Vec2
-{
-    coordType x;
-    coordType y;
-};
-
-
-
-// Color names
-enum Color_t
-{
-    COLORS_GREEN = 1, COLORS_ALT_GREEN, COLORS_MAGENTA, COLORS_ALT_MAGENTA,
-    COLORS_YELLOW, COLORS_CYAN, COLORS_RED, COLORS_BLACK
-};
-
-
-
-// Texture names
-// TEXTURE_COUNT is a sentinel that indicates how many textures there are, and is not the name of a texture
-enum Texture_t
-{
-    TEXTURE_SNAKE = 1, TEXTURE_SNAKE_HEAD, TEXTURE_SS_SNAKE, TEXTURE_SS_SNAKE_HEAD,
-    TEXTURE_FOOD, TEXTURE_COLLISION, TEXTURE_BACKGROUND,
-    TEXTURE_COUNT
-};
-
-
-
-struct SnakeTextureList
-{
-    Texture_t head;
-    Texture_t body;
-    Texture_t tail;
-};
-
-
-
-class Display
-{
-
-public:
-
-    // PreConditions:
-    //   X and Y should be smaller than the actual window
-    //   X and Y should be big enough to not wrap the text
-    //   Y should be larger than x to allow for game messages
-    // PostConditions:
-    //   A Display is created with X and Y size (units of "snake chunks")
-    // Size might later be difficulty depdendant?
-    Display() : Display(27, 30) {};
-    Display(const coordType size_x, const coordType size_y);
-    ~Display();
-
-    // PreConditions:
-    // PostConditions:
-    //   The screen is reset to initial state
-    void clearScreen();
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns the size of the game window (inside the snake border) (units of "snake chunks")
-    coordType getSize_x() const;
-    coordType getSize_y() const;
-
-    // PreConditions:
-    //   texture is a valid texture name
-    // PostConditions:
-    //   Places a texture at the specified position in the display
-    void drawTexture(Texture_t texture, const Vec2& pos);
-
-    // PreConditions:
-    // PostConditions:
-    //   A snake head with headTexture texture is moved from oldPos to newPos
-    //   A snake body with bodyTexture texture is moved into oldPos
-    void moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures);
-
-    // PreConditions:
-    // PostConditions:
-    //   A snake body with bodyTexture texture is moved from oldPos into newPos
-    void moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures);
-
-    // PreConditions:
-    // PostConditions:
-    //   A snake tail with a texture as its texture is moved into newPos
-    //   A snake tail is moved out of oldPos
-    void moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures);
-
-    // PreConditions:
-    //   There is enough space on a line of the display to fit message
-    // PostConditions:
-    //   Displays a centered line of text on the specified line of the message screen (in snake area)
-    void printTextLine(unsigned int lineNumber, const char* message);
-
-    // PreConditions:
-    //   There is enough space between length labels to fit message
-    // PostConditions:
-    //   Displays a small one-line text message outside of the snake area (bottom center of screen)
-    void printGameMessage(const char* message);
-    void clearGameMessage();
-
-    // PreConditions:
-    // PostConditions:
-    //   Updates display if necessary
-    void update();
-
-    // PreConditions:
-    // PostConditions:
-    //   Updates the length counter with newLength
-    void updateLengthCounter(std::size_t newLength);
-
-    // PreConditions:
-    // PostConditions:
-    //   Updates the max length counter with maxLength
-    void updateMaxLengthCounter(std::size_t maxLength);
-
-
-private:
-    // curses back-end
-
-    // Initialize curses back-end
-    static void initCurses();
-
-    // Resizes console if necessary and creates the snakeWin and gameWin windows.
-    // If the windows already exist, reset them to the initial static text and border.
-    void initScreen(coordType size_x, coordType size_y);
-
-    // Initialize textures and curses color definitions
-    void setTextures();
-
-    // global size of application window
-    Vec2 ScreenSize;
-
-    // Bordered window that contains the snakes
-    WINDOW* snakeWin = nullptr;
-    // Textbox located under the window
-    WINDOW* gameWin = nullptr;
-    // Window for outputing text, for menu or instructions (same as snakeWin for now)
-    WINDOW* messageWin = nullptr;
-
-    // A window is modified if it called curses functions directly and needs curses to therefore update that window
-    bool snakeWinModified = true;
-    bool gameWinModified = true;
-    bool messageWinModified = true;
-
-    // List of loaded textures (chtypes in curses)
-    chtype** gameTextures = nullptr;
-
-    // Size of empty space from game content and window edges
-    const unsigned int windowPadding = 1;
-    // Amount of vertical space alloted for Game Text
-    const unsigned int gameTextLines = 1;
-
-    const char* lengthLabel = "Length: ";
-    const char* maxLengthLabel = "Max Length: ";
-};
-
-}
-
-#endif
+
+// display.h
+// Rendering interface used by the game, implemented by the display back-ends
+//
+
+#ifndef SLICERSNAKE_DISPLAY_H
+#define SLICERSNAKE_DISPLAY_H
+
+
+#include <cstdlib> // size_t
+
+
+namespace ssnake
+{
+
+typedef int coordType;
+
+
+
+struct Vec2
+{
+    coordType x;
+    coordType y;
+};
+
+
+
+// Color names
+enum Color_t
+{
+    COLORS_GREEN = 1, COLORS_ALT_GREEN, COLORS_MAGENTA, COLORS_ALT_MAGENTA,
+    COLORS_YELLOW, COLORS_CYAN, COLORS_RED, COLORS_BLACK
+};
+
+
+
+// Texture names
+// TEXTURE_COUNT is a sentinel that indicates how many textures there are, and is not the name of a texture
+enum Texture_t
+{
+    TEXTURE_SNAKE = 1, TEXTURE_SNAKE_HEAD, TEXTURE_SS_SNAKE, TEXTURE_SS_SNAKE_HEAD,
+    TEXTURE_FOOD, TEXTURE_COLLISION, TEXTURE_BACKGROUND,
+    TEXTURE_COUNT
+};
+
+
+
+struct SnakeTextureList
+{
+    Texture_t head;
+    Texture_t body;
+    Texture_t tail;
+};
+
+
+
+// Abstract display that the game draws to
+// Sizes given to back-ends are in units of "snake chunks" and describe the whole screen,
+// so that the same size gives the same game area with every back-end
+class Display
+{
+
+public:
+
+    virtual ~Display() {};
+
+    // PreConditions:
+    // PostConditions:
+    //   The screen is reset to initial state
+    virtual void clearScreen() = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the size of the game window (inside the snake border) (units of "snake chunks")
+    virtual coordType getSize_x() const = 0;
+    virtual coordType getSize_y() const = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the size of the part of the game window that is on the screen (units of "snake chunks"),
+    //   the same as getSize_x and getSize_y unless the game window is larger than the screen
+    //   Lines of printTextLine are lines of this part
+    virtual coordType getViewSize_x() const = 0;
+    virtual coordType getViewSize_y() const = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   The part of the game window on the screen is scrolled so that pos is in it, away from its edges when possible
+    virtual void keepInView(const Vec2& pos) = 0;
+
+    // PreConditions:
+    //   texture is a valid texture name
+    // PostConditions:
+    //   Places a texture at the specified position in the display
+    virtual void drawTexture(Texture_t texture, const Vec2& pos) = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   A snake head with headTexture texture is moved from oldPos to newPos
+    //   A snake body with bodyTexture texture is moved into oldPos
+    virtual void moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   A snake body with bodyTexture texture is moved from oldPos into newPos
+    virtual void moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   A snake tail with a texture as its texture is moved into newPos
+    //   A snake tail is moved out of oldPos
+    virtual void moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) = 0;
+
+    // PreConditions:
+    //   There is enough space on a line of the display to fit message
+    // PostConditions:
+    //   Displays a centered line of text on the specified line of the message screen (in snake area)
+    virtual void printTextLine(unsigned int lineNumber, const char* message) = 0;
+
+    // PreConditions:
+    //   There is enough space between length labels to fit message
+    // PostConditions:
+    //   Displays a small one-line text message outside of the snake area (bottom center of screen)
+    virtual void printGameMessage(const char* message) = 0;
+    virtual void clearGameMessage() = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   Updates display if necessary
+    virtual void update() = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   Updates the length counter with newLength
+    virtual void updateLengthCounter(std::size_t newLength) = 0;
+
+    // PreConditions:
+    // PostConditions:
+    //   Updates the max length counter with maxLength
+    virtual void updateMaxLengthCounter(std::size_t maxLength) = 0;
+};
+
+}
+
+#endif
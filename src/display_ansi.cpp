@@ -0,0 +1,681 @@
+
+#include "display_ansi.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio> // snprintf
+#include <cstring> // strlen
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef _WIN32
+    #include "curses.h" // pdcurses for windows
+#else
+    #include <ncurses.h> // ncurses for linux (and whatever else it happens to work on)
+#endif
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// SGR foreground codes, indexed by Color_t with 0 for the terminal's own color.
+// The alternate colors are the bright ones, which is what CursesDisplay makes them where it can.
+const int colorCodes[COLORS_BLACK + 1] = {39, 32, 92, 35, 95, 33, 36, 31, 30};
+
+// Selecting G1 as line drawing up front lets the border switch to it with a single shift out byte
+const char terminalSetup[] = "\x1b)0\x0f\x1b[0m\x1b[H\x1b[2J";
+const char terminalReset[] = "\x1b[0m\x0f\x1b[H\x1b[2J";
+
+const char shiftOut = '\x0e';
+const char shiftIn = '\x0f';
+
+
+
+void appendNumber(std::string& out, int value)
+{
+    char digits[12];
+    int count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0)
+    {
+        out.push_back(digits[--count]);
+    }
+}
+
+}
+
+
+
+const std::uint8_t AnsiDisplay::lineDrawing;
+
+
+
+AnsiDisplay::AnsiDisplay(const coordType size_x, const coordType size_y)
+{
+    // Curses sets the terminal up for PlayerInput and clears it once, then is left alone
+    initscr();
+    leaveok(stdscr, TRUE);
+    refresh();
+    curs_set(0);
+    ownsTerminal = true;
+
+    fd = STDOUT_FILENO;
+    frame = terminalSetup;
+    initScreen(size_x, size_y, Vec2{getmaxx(stdscr), getmaxy(stdscr)});
+}
+
+
+
+AnsiDisplay::AnsiDisplay(const coordType size_x, const coordType size_y, const Vec2& screenSize, int fd)
+{
+    this->fd = fd;
+    frame = terminalSetup;
+    initScreen(size_x, size_y, screenSize);
+}
+
+
+
+AnsiDisplay::~AnsiDisplay()
+{
+    frame += terminalReset;
+    writeFrame();
+
+    if (ownsTerminal)
+    {
+        endwin();
+    }
+}
+
+
+
+std::size_t AnsiDisplay::cellIndex(const Vec2& pos) const
+{
+    return static_cast<std::size_t>(pos.y) * cellColumns + pos.x;
+}
+
+
+
+void AnsiDisplay::clearGameMessage()
+{
+    std::size_t lengthLabelSize = std::strlen(lengthLabel) + windowPadding + 3;
+    std::size_t maxLengthLabelSize = std::strlen(maxLengthLabel) + windowPadding + 3;
+    int endPos = screenSize.x - static_cast<int>(maxLengthLabelSize) - 1;
+
+    std::string spaces(static_cast<std::size_t>((endPos > static_cast<int>(lengthLabelSize)) ? endPos - lengthLabelSize : 0), ' ');
+    putGameText(static_cast<int>(lengthLabelSize), spaces.c_str(), spaces.size());
+}
+
+
+
+void AnsiDisplay::clearScreen()
+{
+    cellTextures.assign(cellTextures.size(), TEXTURE_BACKGROUND);
+    messageText.assign(messageText.size(), Glyph{0, 0});
+    viewOrigin = Vec2{0, 0};
+
+    std::string spaces(static_cast<std::size_t>(screenSize.x), ' ');
+    putGameText(0, spaces.c_str(), spaces.size());
+    showView();
+
+    // Clear screen immediately
+    update();
+}
+
+
+
+void AnsiDisplay::drawTexture(Texture_t texture, const Vec2& pos)
+{
+    if (pos.x < 0 || pos.x >= cellColumns || pos.y < 0 || pos.y >= areaSize.y)
+    {
+        return;
+    }
+
+    cellTextures[cellIndex(pos)] = texture;
+    showCell(pos);
+}
+
+
+
+AnsiDisplay::Glyph AnsiDisplay::getAreaGlyph(int row, int column) const
+{
+    Texture_t texture = cellTextures[cellIndex(Vec2{column / 2, row})];
+    if (texture != TEXTURE_BACKGROUND)
+    {
+        return textureGlyphs[texture][column % 2];
+    }
+
+    // The border is drawn on the outer columns of the game window, where cells drawn over it hide it
+    bool top = row == 0;
+    bool bottom = row == areaSize.y - 1;
+    bool left = column == 0;
+    bool right = column == areaSize.x - 1;
+    if (top || bottom)
+    {
+        char corner = top ? (left ? 'l' : 'k') : (left ? 'm' : 'j');
+        return Glyph{(left || right) ? corner : 'q', static_cast<std::uint8_t>(COLORS_CYAN | lineDrawing)};
+    }
+    if (left || right)
+    {
+        return Glyph{'x', static_cast<std::uint8_t>(COLORS_CYAN | lineDrawing)};
+    }
+
+    return Glyph{' ', 0};
+}
+
+
+
+std::uint64_t AnsiDisplay::getBytesWritten() const
+{
+    return bytesWritten;
+}
+
+
+
+coordType AnsiDisplay::getSize_x() const
+{
+    return cellColumns;
+}
+
+
+
+coordType AnsiDisplay::getSize_y() const
+{
+    return areaSize.y;
+}
+
+
+
+AnsiDisplay::Glyph AnsiDisplay::getViewGlyph(int row, int column) const
+{
+    int textRow = row - 2;
+    int textColumn = column - 2;
+    if (textRow >= 0 && textRow < messageSize.y && textColumn >= 0 && textColumn < messageSize.x)
+    {
+        Glyph text = messageText[static_cast<std::size_t>(textRow) * messageSize.x + textColumn];
+        if (text.character != 0)
+        {
+            return text;
+        }
+    }
+
+    return getAreaGlyph(viewOrigin.y + row, viewOrigin.x * 2 + column);
+}
+
+
+
+coordType AnsiDisplay::getViewSize_x() const
+{
+    return viewSize.x;
+}
+
+
+
+coordType AnsiDisplay::getViewSize_y() const
+{
+    return viewSize.y;
+}
+
+
+
+void AnsiDisplay::encodeRow(int row)
+{
+    if (row >= terminalSize.y)
+    {
+        return;
+    }
+
+    int end = (rowDirtyEnd[row] < terminalSize.x) ? rowDirtyEnd[row] : terminalSize.x - 1;
+    std::size_t rowStart = static_cast<std::size_t>(row) * screenSize.x;
+    for (int column = rowDirtyBegin[row]; column <= end; ++column)
+    {
+        Glyph glyph = screen[rowStart + column];
+        if (glyph == shown[rowStart + column])
+        {
+            continue;
+        }
+        shown[rowStart + column] = glyph;
+
+        moveCursor(row, column);
+        // A space looks the same in any color
+        if (glyph.character != ' ')
+        {
+            setStyle(glyph.style);
+        }
+        frame.push_back(glyph.character);
+
+        // Past the last column the terminal wraps or doesn't, depending on the terminal
+        ++cursor.x;
+        if (cursor.x >= terminalSize.x)
+        {
+            cursor.y = -1;
+        }
+    }
+}
+
+
+
+void AnsiDisplay::initScreen(coordType size_x, coordType size_y, const Vec2& terminalSize)
+{
+    textureGlyphs[0][0] = textureGlyphs[0][1] = Glyph{'?', 0};
+    textureGlyphs[TEXTURE_SNAKE][0]         = Glyph{'(', COLORS_GREEN};
+    textureGlyphs[TEXTURE_SNAKE][1]         = Glyph{')', COLORS_GREEN};
+    textureGlyphs[TEXTURE_SNAKE_HEAD][0]    = Glyph{'<', COLORS_ALT_GREEN};
+    textureGlyphs[TEXTURE_SNAKE_HEAD][1]    = Glyph{'>', COLORS_ALT_GREEN};
+    textureGlyphs[TEXTURE_SS_SNAKE][0]      = Glyph{'(', COLORS_MAGENTA};
+    textureGlyphs[TEXTURE_SS_SNAKE][1]      = Glyph{')', COLORS_MAGENTA};
+    textureGlyphs[TEXTURE_SS_SNAKE_HEAD][0] = Glyph{'<', COLORS_ALT_MAGENTA};
+    textureGlyphs[TEXTURE_SS_SNAKE_HEAD][1] = Glyph{'>', COLORS_ALT_MAGENTA};
+    textureGlyphs[TEXTURE_FOOD][0]          = Glyph{'{', COLORS_YELLOW};
+    textureGlyphs[TEXTURE_FOOD][1]          = Glyph{'}', COLORS_YELLOW};
+    textureGlyphs[TEXTURE_COLLISION][0]     = Glyph{'*', COLORS_RED};
+    textureGlyphs[TEXTURE_COLLISION][1]     = Glyph{'*', COLORS_RED};
+    textureGlyphs[TEXTURE_BACKGROUND][0]    = Glyph{' ', 0};
+    textureGlyphs[TEXTURE_BACKGROUND][1]    = Glyph{' ', 0};
+
+    // Laid out the same as CursesDisplay, using as much of a smaller terminal as there is but no less than the minimum
+    this->terminalSize = terminalSize;
+    screenSize = Vec2{size_x * 2, size_y};
+    coordType terminalWidth = terminalSize.x - terminalSize.x % 2;
+    if (screenSize.x > terminalWidth)
+    {
+        screenSize.x = (terminalWidth > minScreenWidth) ? terminalWidth : minScreenWidth;
+    }
+    if (screenSize.y > terminalSize.y)
+    {
+        screenSize.y = (terminalSize.y > minScreenHeight) ? terminalSize.y : minScreenHeight;
+    }
+
+    areaSize.x = size_x * 2 - static_cast<coordType>(windowPadding * 2);
+    areaSize.y = size_y - static_cast<coordType>(gameTextLines + windowPadding * 2);
+    cellColumns = areaSize.x / 2;
+
+    viewSize.x = (screenSize.x - static_cast<coordType>(windowPadding * 2)) / 2;
+    viewSize.y = screenSize.y - static_cast<coordType>(gameTextLines + windowPadding * 2);
+    if (viewSize.x > cellColumns)
+    {
+        viewSize.x = cellColumns;
+    }
+    if (viewSize.y > areaSize.y)
+    {
+        viewSize.y = areaSize.y;
+    }
+    messageSize = Vec2{viewSize.x * 2 - 4, viewSize.y - 4};
+
+    cellTextures.assign(static_cast<std::size_t>(cellColumns) * areaSize.y, TEXTURE_BACKGROUND);
+    messageText.assign(static_cast<std::size_t>(messageSize.x) * messageSize.y, Glyph{0, 0});
+
+    // The terminal is cleared by terminalSetup
+    screen.assign(static_cast<std::size_t>(screenSize.x) * screenSize.y, Glyph{' ', 0});
+    shown = screen;
+    rowDirtyBegin.assign(screenSize.y, screenSize.x);
+    rowDirtyEnd.assign(screenSize.y, -1);
+    cursor = Vec2{0, 0};
+    cursorStyle = 0;
+
+    showView();
+    update();
+}
+
+
+
+void AnsiDisplay::keepInView(const Vec2& pos)
+{
+    // The view only moves once pos gets within a quarter of the view of its edge, and then only as far as it has to
+    Vec2 margin = {viewSize.x / 4, viewSize.y / 4};
+    Vec2 origin = viewOrigin;
+    if (pos.x < origin.x + margin.x)
+    {
+        origin.x = pos.x - margin.x;
+    }
+    else if (pos.x >= origin.x + viewSize.x - margin.x)
+    {
+        origin.x = pos.x + margin.x - viewSize.x + 1;
+    }
+    if (pos.y < origin.y + margin.y)
+    {
+        origin.y = pos.y - margin.y;
+    }
+    else if (pos.y >= origin.y + viewSize.y - margin.y)
+    {
+        origin.y = pos.y + margin.y - viewSize.y + 1;
+    }
+
+    // Never past the edges of the game window
+    if (origin.x > cellColumns - viewSize.x)
+    {
+        origin.x = cellColumns - viewSize.x;
+    }
+    if (origin.y > areaSize.y - viewSize.y)
+    {
+        origin.y = areaSize.y - viewSize.y;
+    }
+    if (origin.x < 0)
+    {
+        origin.x = 0;
+    }
+    if (origin.y < 0)
+    {
+        origin.y = 0;
+    }
+
+    if (origin.x != viewOrigin.x || origin.y != viewOrigin.y)
+    {
+        viewOrigin = origin;
+        showView();
+    }
+}
+
+
+
+void AnsiDisplay::moveCursor(int row, int column)
+{
+    if (cursor.y == row && cursor.x == column)
+    {
+        return;
+    }
+
+    if (cursor.y == row && column > cursor.x)
+    {
+        // Writing out the few columns in between again is shorter than a cursor move, if it takes no style changes
+        int gap = column - cursor.x;
+        std::size_t start = static_cast<std::size_t>(row) * screenSize.x + cursor.x;
+        bool sameStyle = gap <= 3;
+        for (int i = 0; i < gap && sameStyle; ++i)
+        {
+            sameStyle = shown[start + i].character == ' ' || shown[start + i].style == cursorStyle;
+        }
+        if (sameStyle)
+        {
+            for (int i = 0; i < gap; ++i)
+            {
+                frame.push_back(shown[start + i].character);
+            }
+        }
+        else
+        {
+            frame += "\x1b[";
+            appendNumber(frame, gap);
+            frame.push_back('C');
+        }
+        cursor.x = column;
+        return;
+    }
+
+    frame += "\x1b[";
+    appendNumber(frame, row + 1);
+    frame.push_back(';');
+    appendNumber(frame, column + 1);
+    frame.push_back('H');
+    cursor = Vec2{column, row};
+}
+
+
+
+void AnsiDisplay::moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    drawTexture(snakeTextures.body, oldPos);
+
+    drawTexture(snakeTextures.head, newPos);
+}
+
+
+
+void AnsiDisplay::moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    // unused, the same as in the curses implementation
+}
+
+
+
+void AnsiDisplay::moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    drawTexture(snakeTextures.tail, newPos);
+
+    // Don't overwrite anything else when clearing old tail, anything that looks like a tail counts like in curses
+    if (oldPos.x < 0 || oldPos.x >= cellColumns || oldPos.y < 0 || oldPos.y >= areaSize.y)
+    {
+        return;
+    }
+    if (textureGlyphs[cellTextures[cellIndex(oldPos)]][0].character == textureGlyphs[snakeTextures.tail][0].character)
+    {
+        drawTexture(TEXTURE_BACKGROUND, oldPos);
+    }
+}
+
+
+
+void AnsiDisplay::printGameMessage(const char* message)
+{
+    clearGameMessage();
+
+    int gameWidth = screenSize.x - static_cast<int>(windowPadding * 2);
+    std::size_t size = std::strlen(message);
+    std::size_t maxGameTextLength = 2 * ((gameWidth / 2) - (std::strlen(maxLengthLabel) + windowPadding + 2) - 1);
+    if (size > maxGameTextLength)
+    {
+        size = maxGameTextLength;
+    }
+
+    putGameText((gameWidth / 2) - static_cast<int>(size / 2), message, size);
+
+    // Game messages should be printed immediately
+    update();
+}
+
+
+
+void AnsiDisplay::printTextLine(unsigned int lineNumber, const char* message)
+{
+    int line = static_cast<int>(lineNumber);
+    if (line >= messageSize.y)
+    {
+        return;
+    }
+
+    Glyph* text = &messageText[static_cast<std::size_t>(line) * messageSize.x];
+    for (int i = 0; i < messageSize.x; ++i)
+    {
+        text[i] = Glyph{0, 0};
+    }
+
+    int size = static_cast<int>(std::strlen(message));
+    int start = (messageSize.x / 2) - (size / 2);
+    for (int i = 0; i < size && start + i < messageSize.x; ++i)
+    {
+        if (start + i >= 0)
+        {
+            text[start + i] = Glyph{message[i], COLORS_RED};
+        }
+    }
+
+    for (int i = 0; i < messageSize.x; ++i)
+    {
+        putGlyph(windowPadding + 2 + line, windowPadding + 2 + i, getViewGlyph(2 + line, 2 + i));
+    }
+}
+
+
+
+void AnsiDisplay::putGameText(int column, const char* text, std::size_t size)
+{
+    int row = screenSize.y - static_cast<int>(gameTextLines + windowPadding);
+    int gameWidth = screenSize.x - static_cast<int>(windowPadding * 2);
+    for (std::size_t i = 0; i < size && column + static_cast<int>(i) < gameWidth; ++i)
+    {
+        putGlyph(row, windowPadding + column + static_cast<int>(i), Glyph{text[i], COLORS_RED});
+    }
+}
+
+
+
+void AnsiDisplay::putGlyph(int row, int column, Glyph glyph)
+{
+    if (row < 0 || row >= screenSize.y || column < 0 || column >= screenSize.x)
+    {
+        return;
+    }
+
+    // Colors only show on characters, so every space is the same
+    if (glyph.character == ' ')
+    {
+        glyph.style = 0;
+    }
+
+    std::size_t index = static_cast<std::size_t>(row) * screenSize.x + column;
+    if (screen[index] == glyph)
+    {
+        return;
+    }
+    screen[index] = glyph;
+
+    if (rowDirtyBegin[row] > rowDirtyEnd[row])
+    {
+        dirtyRows.push_back(row);
+    }
+    if (column < rowDirtyBegin[row])
+    {
+        rowDirtyBegin[row] = column;
+    }
+    if (column > rowDirtyEnd[row])
+    {
+        rowDirtyEnd[row] = column;
+    }
+}
+
+
+
+void AnsiDisplay::setStyle(std::uint8_t style)
+{
+    if (style == cursorStyle)
+    {
+        return;
+    }
+
+    if ((style ^ cursorStyle) & lineDrawing)
+    {
+        frame.push_back((style & lineDrawing) ? shiftOut : shiftIn);
+    }
+    if ((style & ~lineDrawing) != (cursorStyle & ~lineDrawing))
+    {
+        frame += "\x1b[";
+        appendNumber(frame, colorCodes[style & ~lineDrawing]);
+        frame.push_back('m');
+    }
+
+    cursorStyle = style;
+}
+
+
+
+void AnsiDisplay::showCell(const Vec2& pos)
+{
+    int row = pos.y - viewOrigin.y;
+    int cellColumn = pos.x - viewOrigin.x;
+    if (row < 0 || row >= viewSize.y || cellColumn < 0 || cellColumn >= viewSize.x)
+    {
+        return;
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        int column = cellColumn * 2 + i;
+        putGlyph(windowPadding + row, windowPadding + column, getViewGlyph(row, column));
+    }
+}
+
+
+
+void AnsiDisplay::showView()
+{
+    for (int row = 0; row < viewSize.y; ++row)
+    {
+        for (int column = 0; column < viewSize.x * 2; ++column)
+        {
+            putGlyph(windowPadding + row, windowPadding + column, getViewGlyph(row, column));
+        }
+    }
+}
+
+
+
+void AnsiDisplay::update()
+{
+    for (std::size_t i = 0; i < dirtyRows.size(); ++i)
+    {
+        int row = dirtyRows[i];
+        encodeRow(row);
+
+        rowDirtyBegin[row] = screenSize.x;
+        rowDirtyEnd[row] = -1;
+    }
+    dirtyRows.clear();
+
+    if (!frame.empty())
+    {
+        writeFrame();
+    }
+}
+
+
+
+void AnsiDisplay::updateLengthCounter(std::size_t length)
+{
+    putGameText(windowPadding, lengthLabel, std::strlen(lengthLabel));
+
+    char number[24];
+    int size = std::snprintf(number, sizeof(number), "%-2u", static_cast<unsigned int>(length));
+    putGameText(static_cast<int>(std::strlen(lengthLabel) + windowPadding), number, static_cast<std::size_t>(size));
+}
+
+
+
+void AnsiDisplay::updateMaxLengthCounter(std::size_t maxLength)
+{
+    int gameWidth = screenSize.x - static_cast<int>(windowPadding * 2);
+    std::size_t labelSize = std::strlen(maxLengthLabel);
+    putGameText(gameWidth - static_cast<int>(labelSize + windowPadding + 2), maxLengthLabel, labelSize);
+
+    char number[24];
+    int size = std::snprintf(number, sizeof(number), "%-2u", static_cast<unsigned int>(maxLength));
+    putGameText(gameWidth - static_cast<int>(windowPadding + 2), number, static_cast<std::size_t>(size));
+}
+
+
+
+void AnsiDisplay::writeFrame()
+{
+    std::size_t written = 0;
+    while (written < frame.size())
+    {
+        ssize_t count = write(fd, frame.data() + written, frame.size() - written);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // The terminal went away, so where its cursor is doesn't matter anymore
+            cursor.y = -1;
+            break;
+        }
+        written += static_cast<std::size_t>(count);
+    }
+
+    bytesWritten += written;
+    frame.clear();
+}
+
+}
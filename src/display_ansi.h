@@ -0,0 +1,188 @@
+
+// display_ansi.h
+// Display that draws straight to an ANSI (VT100) terminal, keeping its own copy of the screen
+//
+
+#ifndef SLICERSNAKE_DISPLAY_ANSI_H
+#define SLICERSNAKE_DISPLAY_ANSI_H
+
+
+#include <cstdint>
+#include <cstdlib> // size_t
+#include <string>
+#include <vector>
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+// Shows the same screen as CursesDisplay without curses drawing any of it.
+// The screen is kept as a character and a style for every column, and update compares it with what the terminal
+// was last sent: only the characters that differ are written, moving the cursor only where writing what is in
+// between would be longer and changing colors only where the style changes, all in one write.
+// Curses is still started so that PlayerInput can read keys, but it is never asked to draw anything after that.
+class AnsiDisplay : public Display
+{
+
+public:
+
+    // PreConditions:
+    //   X and Y should be big enough to not wrap the text
+    //   Y should be larger than x to allow for game messages
+    // PostConditions:
+    //   A Display is created with X and Y size (units of "snake chunks") on the terminal
+    //   If that is larger than the terminal, only the part of the game window that fits the terminal is shown
+    AnsiDisplay(const coordType size_x, const coordType size_y);
+
+    // PreConditions:
+    //   X and Y as above, fd is open for writing
+    // PostConditions:
+    //   A Display is created with X and Y size that writes to fd as if it were a terminal of screenSize columns and rows,
+    //   without starting curses (for benchmarks, or to see what a terminal would be sent)
+    AnsiDisplay(const coordType size_x, const coordType size_y, const Vec2& screenSize, int fd);
+
+    // PreConditions:
+    // PostConditions:
+    //   The terminal is given back the way curses found it, if this display started curses
+    ~AnsiDisplay() override;
+
+    AnsiDisplay(const AnsiDisplay&) = delete;
+    AnsiDisplay& operator=(const AnsiDisplay&) = delete;
+
+    void clearScreen() override;
+
+    coordType getSize_x() const override;
+    coordType getSize_y() const override;
+
+    coordType getViewSize_x() const override;
+    coordType getViewSize_y() const override;
+
+    void keepInView(const Vec2& pos) override;
+
+    void drawTexture(Texture_t texture, const Vec2& pos) override;
+
+    void moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+    void moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+    void moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+
+    void printTextLine(unsigned int lineNumber, const char* message) override;
+
+    void printGameMessage(const char* message) override;
+    void clearGameMessage() override;
+
+    // PreConditions:
+    // PostConditions:
+    //   The characters of the screen that changed since the last update are written in one write
+    void update() override;
+
+    void updateLengthCounter(std::size_t newLength) override;
+    void updateMaxLengthCounter(std::size_t maxLength) override;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of bytes written to the terminal
+    std::uint64_t getBytesWritten() const;
+
+
+private:
+
+    // A column of the screen: a character and the Color_t it is drawn in, with lineDrawing set for the border
+    struct Glyph
+    {
+        char character;
+        std::uint8_t style;
+
+        bool operator==(const Glyph& other) const { return character == other.character && style == other.style; }
+        bool operator!=(const Glyph& other) const { return !(*this == other); }
+    };
+
+    // Sets up the screen for a game window of size_x by size_y chunks on a terminal of terminalSize
+    void initScreen(coordType size_x, coordType size_y, const Vec2& terminalSize);
+
+    // Index of the cell at pos in cellTextures
+    std::size_t cellIndex(const Vec2& pos) const;
+
+    // What is shown at a column of the game window (in columns, like a curses pad), with the border under the cells
+    Glyph getAreaGlyph(int row, int column) const;
+    // What is shown at a column of the view (from its top left), the text of printTextLine over the game window
+    Glyph getViewGlyph(int row, int column) const;
+
+    // Writes the cell at pos to the screen if it is in view
+    void showCell(const Vec2& pos);
+    // Writes every column of the view to the screen
+    void showView();
+
+    // Puts a glyph on the screen for the next update, doing nothing outside of it
+    void putGlyph(int row, int column, Glyph glyph);
+    // Puts text on the game text line from column, cut off at its end
+    void putGameText(int column, const char* text, std::size_t size);
+
+    // Adds the changed characters of a row to frame
+    void encodeRow(int row);
+    // Adds the shortest way to get the cursor to row and column to frame
+    void moveCursor(int row, int column);
+    // Adds the color and character set changes to get to style to frame
+    void setStyle(std::uint8_t style);
+    // Writes frame out, all of it
+    void writeFrame();
+
+    static const std::uint8_t lineDrawing = 0x10;
+
+    // Characters of the textures, by Texture_t
+    Glyph textureGlyphs[TEXTURE_COUNT][2];
+
+    int fd = -1;
+    // Curses was started by this display
+    bool ownsTerminal = false;
+
+    // Part of the terminal that is used, and the terminal; nothing past the terminal is written
+    Vec2 screenSize = {0, 0};
+    Vec2 terminalSize = {0, 0};
+
+    // Size of the game window in columns and rows, like a curses pad, and in cells
+    Vec2 areaSize = {0, 0};
+    coordType cellColumns = 0;
+
+    // Cells of the game window that are on the screen, and the first of them
+    Vec2 viewSize = {0, 0};
+    Vec2 viewOrigin = {0, 0};
+
+    // Texture of every cell of the game window
+    std::vector<Texture_t> cellTextures;
+
+    // Text of printTextLine, over the view inside of a margin of 2 columns, a character of 0 where there is none
+    Vec2 messageSize = {0, 0};
+    std::vector<Glyph> messageText;
+
+    // Every column of the screen as it should be, and as the terminal was last sent, in row-major order
+    std::vector<Glyph> screen;
+    std::vector<Glyph> shown;
+    // Range of columns put on each row since the last update, and the rows with any
+    std::vector<int> rowDirtyBegin;
+    std::vector<int> rowDirtyEnd;
+    std::vector<int> dirtyRows;
+
+    // Bytes of the next write, and where the terminal's cursor and style are after them (row -1 if not known)
+    std::string frame;
+    Vec2 cursor = {-1, -1};
+    std::uint8_t cursorStyle = 0;
+
+    std::uint64_t bytesWritten = 0;
+
+    // Size of empty space from game content and window edges
+    const unsigned int windowPadding = 1;
+    // Amount of vertical space alloted for Game Text
+    const unsigned int gameTextLines = 1;
+    // Smallest part of the terminal used, even in a smaller terminal, so that the menu and labels fit
+    const coordType minScreenWidth = 54;
+    const coordType minScreenHeight = 20;
+
+    const char* lengthLabel = "Length: ";
+    const char* maxLengthLabel = "Max Length: ";
+};
+
+}
+
+#endif
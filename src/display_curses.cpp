@@ -0,0 +1,635 @@
+
+#include "display_curses.h"
+
+#include <cstdlib> // size_t, system (windows)
+#include <cassert>
+#include <cstring> // strlen
+
+#ifdef _WIN32
+    #include "curses.h" // pdcurses for windows
+#else
+    #include <ncurses.h> // ncurses for linux (and whatever else it happens to work on)
+#endif
+
+
+namespace ssnake
+{
+
+CursesDisplay::CursesDisplay(const coordType size_x, const coordType size_y)
+{
+    initCurses();
+    setTextures();
+    initScreen(size_x * 2, size_y);
+
+#ifdef _WIN32
+    system("title SlicerSnake");
+#endif
+}
+
+
+
+CursesDisplay::~CursesDisplay()
+{
+    if (messageWin != nullptr)
+    {
+        delwin(messageWin);
+    }
+    if (snakeWin != nullptr)
+    {
+        delwin(snakeWin);
+    }
+    if (gameWin != nullptr)
+    {
+        delwin(gameWin);
+    }
+
+    clear();
+    refresh();
+
+    endwin();
+
+    if (gameTextures != nullptr)
+    {
+        if (gameTextures[0] != nullptr)
+        {
+            delete gameTextures[0];
+        }
+        delete gameTextures;
+    }
+}
+
+
+
+void CursesDisplay::clearGameMessage()
+{
+    std::size_t lengthLabelSize = std::strlen(lengthLabel) + windowPadding + 3;
+    std::size_t maxLengthLabelSize = std::strlen(maxLengthLabel) + windowPadding + 3;
+    unsigned int endPos = ScreenSize.x - maxLengthLabelSize - 1;
+
+    wmove(gameWin, 0, lengthLabelSize);
+    for (unsigned int i = lengthLabelSize; i < endPos; ++i)
+    {
+        waddch(gameWin, ' ');
+    }
+
+    gameWinModified = true;
+}
+
+
+
+void CursesDisplay::clearScreen()
+{
+    wclear(snakeWin);
+    wclear(gameWin);
+    wclear(messageWin);
+
+    wattron(snakeWin, COLOR_PAIR(COLORS_CYAN));
+    box(snakeWin, 0, 0);
+    wattroff(snakeWin, COLOR_PAIR(COLORS_CYAN));
+
+    resetCells();
+    scrollView(Vec2{0, 0});
+
+    snakeWinModified = true;
+    gameWinModified = true;
+    messageWinModified = true;
+
+    // Clear screen immediately
+    update();
+}
+
+
+
+void CursesDisplay::drawTexture(Texture_t texture, const Vec2& pos)
+{
+    if (pos.x < 0 || pos.x >= cellColumns || pos.y < 0 || pos.y >= getmaxy(snakeWin))
+    {
+        return;
+    }
+
+    // Only remembered here, updateCells writes the final texture of the step
+    std::size_t cell = cellIndex(pos);
+    cellTextures[cell] = texture;
+    if (!cellDirty[cell])
+    {
+        cellDirty[cell] = true;
+        dirtyCells.push_back(cell);
+    }
+}
+
+
+
+std::size_t CursesDisplay::cellIndex(const Vec2& pos) const
+{
+    return static_cast<std::size_t>(pos.y) * cellColumns + pos.x;
+}
+
+
+
+void CursesDisplay::resetCells()
+{
+    cellColumns = getmaxx(snakeWin) / 2;
+    std::size_t cellCount = static_cast<std::size_t>(cellColumns) * getmaxy(snakeWin);
+
+    cellTextures.assign(cellCount, TEXTURE_BACKGROUND);
+    shownTextures.assign(cellCount, TEXTURE_COUNT);
+    cellDirty.assign(cellCount, false);
+    cellHidden.assign(cellCount, false);
+    dirtyCells.clear();
+
+    rowDirtyBegin.assign(getmaxy(snakeWin), getmaxx(snakeWin));
+    rowDirtyEnd.assign(getmaxy(snakeWin), -1);
+    dirtyRows.clear();
+}
+
+
+
+void CursesDisplay::updateCells()
+{
+    for (std::size_t i = 0; i < dirtyCells.size(); ++i)
+    {
+        std::size_t cell = dirtyCells[i];
+        cellDirty[cell] = false;
+
+        // Cells nobody can see are left for scrollView
+        int row = static_cast<int>(cell / cellColumns);
+        int cellColumn = static_cast<int>(cell % cellColumns);
+        if (row < viewOrigin.y || row >= viewOrigin.y + viewSize.y ||
+            cellColumn < viewOrigin.x || cellColumn >= viewOrigin.x + viewSize.x)
+        {
+            cellHidden[cell] = true;
+            continue;
+        }
+        cellHidden[cell] = false;
+
+        // Drawn over with what was already there, like a head that was eaten back to body
+        if (cellTextures[cell] == shownTextures[cell])
+        {
+            continue;
+        }
+        shownTextures[cell] = cellTextures[cell];
+
+        int column = cellColumn * 2;
+        mvwaddchnstr(snakeWin, row, column, gameTextures[cellTextures[cell]], 2);
+
+        if (rowDirtyBegin[row] > rowDirtyEnd[row])
+        {
+            dirtyRows.push_back(row);
+        }
+        if (column < rowDirtyBegin[row])
+        {
+            rowDirtyBegin[row] = column;
+        }
+        if (column + 1 > rowDirtyEnd[row])
+        {
+            rowDirtyEnd[row] = column + 1;
+        }
+    }
+    dirtyCells.clear();
+
+    // The whole window is copied anyway
+    if (snakeWinModified)
+    {
+        dirtyRows.clear();
+        rowDirtyBegin.assign(rowDirtyBegin.size(), getmaxx(snakeWin));
+        rowDirtyEnd.assign(rowDirtyEnd.size(), -1);
+        return;
+    }
+
+    // Only cells in view were written, so every row is on the screen
+    int screenRow = static_cast<int>(windowPadding) - viewOrigin.y;
+    int screenColumn = static_cast<int>(windowPadding) - viewOrigin.x * 2;
+    for (std::size_t i = 0; i < dirtyRows.size(); ++i)
+    {
+        int row = dirtyRows[i];
+        pnoutrefresh(snakeWin, row, rowDirtyBegin[row],
+                     screenRow + row, screenColumn + rowDirtyBegin[row],
+                     screenRow + row, screenColumn + rowDirtyEnd[row]);
+
+        rowDirtyBegin[row] = getmaxx(snakeWin);
+        rowDirtyEnd[row] = -1;
+    }
+    dirtyRows.clear();
+}
+
+
+
+coordType CursesDisplay::getSize_x() const
+{
+    return getmaxx(snakeWin) / 2;
+}
+
+
+
+coordType CursesDisplay::getSize_y() const
+{
+    return getmaxy(snakeWin);
+}
+
+
+
+coordType CursesDisplay::getViewSize_x() const
+{
+    return viewSize.x;
+}
+
+
+
+coordType CursesDisplay::getViewSize_y() const
+{
+    return viewSize.y;
+}
+
+
+
+void CursesDisplay::initCurses()
+{
+    /*
+    if (curscr != NULL)
+    {
+        initscr();
+        refresh();
+    }
+    */
+    initscr();
+    start_color();
+    leaveok(stdscr, TRUE);
+    refresh();
+
+    curs_set(0);
+}
+
+
+
+void CursesDisplay::initScreen(coordType size_x, coordType size_y)
+{
+    // A game window larger than the terminal is scrolled through, using as much of the terminal as there is
+    // (in whole snake chunks), but no less than the minimum
+    ScreenSize.x = size_x;
+    ScreenSize.y = size_y;
+    coordType terminalWidth = getmaxx(stdscr) - getmaxx(stdscr) % 2;
+    if (ScreenSize.x > terminalWidth)
+    {
+        ScreenSize.x = (terminalWidth > minScreenWidth) ? terminalWidth : minScreenWidth;
+    }
+    if (ScreenSize.y > getmaxy(stdscr))
+    {
+        ScreenSize.y = (getmaxy(stdscr) > minScreenHeight) ? getmaxy(stdscr) : minScreenHeight;
+    }
+
+#ifdef _WIN32
+    // Ensure window is large enough for requested display size on windows
+    // Since window users generally want things to work more than to have control
+    if (ScreenSize.y > getmaxy(stdscr) || ScreenSize.x > getmaxx(stdscr))
+    {
+        int err = resize_term(ScreenSize.y, ScreenSize.x);
+        assert(err == OK);
+        refresh();
+    }
+#endif
+    if (ScreenSize.y > getmaxy(stdscr) || ScreenSize.x > getmaxx(stdscr))
+    {
+        // probably warning or exit here, but for now do nothing
+    }
+
+    if (snakeWin != nullptr)
+    {
+        wclear(snakeWin);
+    }
+    else
+    {
+        snakeWin = newpad(size_y - (gameTextLines + windowPadding * 2), size_x - (windowPadding * 2));
+    }
+
+    viewSize.x = (ScreenSize.x - windowPadding * 2) / 2;
+    viewSize.y = ScreenSize.y - (gameTextLines + windowPadding * 2);
+    if (viewSize.x > getmaxx(snakeWin) / 2)
+    {
+        viewSize.x = getmaxx(snakeWin) / 2;
+    }
+    if (viewSize.y > getmaxy(snakeWin))
+    {
+        viewSize.y = getmaxy(snakeWin);
+    }
+    if (gameWin != nullptr)
+    {
+        wclear(gameWin);
+    }
+    else
+    {
+        gameWin = newpad(gameTextLines, ScreenSize.x - (windowPadding * 2));
+    }
+    if (messageWin != nullptr)
+    {
+        wclear(messageWin);
+    }
+    else
+    {
+        // It doesn't matter anymore, but note that for pdcurses compatability, sub-windows/pads cannot be the same size as parent
+        messageWin = subpad(snakeWin, viewSize.y - 4, viewSize.x * 2 - 4, viewOrigin.y + 2, viewOrigin.x * 2 + 2);
+    }
+
+    // gameWin and messageWin always uses the same color for now
+    // But don't set always for messageWin because is a subPad
+    wattron(gameWin, COLOR_PAIR(COLORS_RED));
+
+    wattron(snakeWin, COLOR_PAIR(COLORS_CYAN));
+    box(snakeWin, 0, 0);
+    wattroff(snakeWin, COLOR_PAIR(COLORS_CYAN));
+
+    resetCells();
+
+    snakeWinModified = true;
+    gameWinModified = true;
+    messageWinModified = true;
+    update();
+
+    return;
+}
+
+
+
+void CursesDisplay::keepInView(const Vec2& pos)
+{
+    // The view only moves once pos gets within a quarter of the view of its edge, and then only as far as it has to
+    Vec2 margin = {viewSize.x / 4, viewSize.y / 4};
+    Vec2 origin = viewOrigin;
+    if (pos.x < origin.x + margin.x)
+    {
+        origin.x = pos.x - margin.x;
+    }
+    else if (pos.x >= origin.x + viewSize.x - margin.x)
+    {
+        origin.x = pos.x + margin.x - viewSize.x + 1;
+    }
+    if (pos.y < origin.y + margin.y)
+    {
+        origin.y = pos.y - margin.y;
+    }
+    else if (pos.y >= origin.y + viewSize.y - margin.y)
+    {
+        origin.y = pos.y + margin.y - viewSize.y + 1;
+    }
+
+    // Never past the edges of the game window
+    if (origin.x > cellColumns - viewSize.x)
+    {
+        origin.x = cellColumns - viewSize.x;
+    }
+    if (origin.y > getmaxy(snakeWin) - viewSize.y)
+    {
+        origin.y = getmaxy(snakeWin) - viewSize.y;
+    }
+    if (origin.x < 0)
+    {
+        origin.x = 0;
+    }
+    if (origin.y < 0)
+    {
+        origin.y = 0;
+    }
+
+    if (origin.x != viewOrigin.x || origin.y != viewOrigin.y)
+    {
+        scrollView(origin);
+    }
+}
+
+
+
+void CursesDisplay::moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    drawTexture(snakeTextures.body, oldPos);
+
+    drawTexture(snakeTextures.head, newPos);
+}
+
+
+
+void CursesDisplay::moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    // unused in curses implementation
+}
+
+
+
+void CursesDisplay::moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    drawTexture(snakeTextures.tail, newPos);
+
+    // Don't overwrite anything else when clearing old tail
+    if (oldPos.x < 0 || oldPos.x >= cellColumns || oldPos.y < 0 || oldPos.y >= getmaxy(snakeWin))
+    {
+        return;
+    }
+    if (gameTextures[cellTextures[cellIndex(oldPos)]][0] == gameTextures[snakeTextures.tail][0])
+    {
+        drawTexture(TEXTURE_BACKGROUND, oldPos);
+    }
+}
+
+
+
+void CursesDisplay::printTextLine(unsigned int lineNumber, const char* message)
+{
+    int lineNum = static_cast<int>(lineNumber);
+    if (lineNum > ScreenSize.y)
+    {
+        return;
+    }
+
+    std::size_t size = std::strlen(message);
+    int maxTextLength = getmaxx(messageWin);
+
+    for (int i = 0; i < maxTextLength; ++i)
+    {
+        chtype curChar = mvwinch(messageWin, lineNumber, i);
+        if ((curChar & A_COLOR) == COLOR_PAIR(COLORS_RED))
+        {
+            waddch(messageWin, ' ');
+        }
+    }
+    wattron(messageWin, COLOR_PAIR(COLORS_RED));
+    mvwaddnstr(messageWin, lineNum, (getmaxx(messageWin) / 2) - (size / 2), message, maxTextLength);
+    wattroff(messageWin, COLOR_PAIR(COLORS_RED));
+
+    // messageWin shares its characters with snakeWin, so the cells under the line are no longer known
+    int snakeRow = lineNum + getpary(messageWin);
+    if (snakeRow < getmaxy(snakeWin))
+    {
+        for (coordType x = 0; x < cellColumns; ++x)
+        {
+            shownTextures[cellIndex(Vec2{x, snakeRow})] = TEXTURE_COUNT;
+        }
+    }
+
+    messageWinModified = true;
+}
+
+
+
+void CursesDisplay::printGameMessage(const char* message)
+{
+    clearGameMessage();
+
+    std::size_t size = std::strlen(message);
+    std::size_t maxGameTextLength = 2 * ((getmaxx(gameWin) / 2) - (std::strlen(maxLengthLabel) + windowPadding + 2) - 1);
+    if (size > maxGameTextLength)
+    {
+        size = maxGameTextLength;
+    }
+
+    mvwaddnstr(gameWin, 0, (getmaxx(gameWin) / 2) - (size / 2), message, static_cast<int>(maxGameTextLength));
+
+    gameWinModified = true;
+    // Game messages should be printed immediately
+    update();
+}
+
+
+
+void CursesDisplay::scrollView(const Vec2& origin)
+{
+    viewOrigin = origin;
+
+    for (coordType y = viewOrigin.y; y < viewOrigin.y + viewSize.y; ++y)
+    {
+        for (coordType x = viewOrigin.x; x < viewOrigin.x + viewSize.x; ++x)
+        {
+            std::size_t cell = cellIndex(Vec2{x, y});
+            if (!cellHidden[cell])
+            {
+                continue;
+            }
+            cellHidden[cell] = false;
+
+            if (cellTextures[cell] != shownTextures[cell])
+            {
+                shownTextures[cell] = cellTextures[cell];
+                mvwaddchnstr(snakeWin, y, x * 2, gameTextures[cellTextures[cell]], 2);
+            }
+        }
+    }
+
+    // Text is printed on the part of snakeWin in view
+    if (messageWin != nullptr)
+    {
+        delwin(messageWin);
+    }
+    messageWin = subpad(snakeWin, viewSize.y - 4, viewSize.x * 2 - 4, viewOrigin.y + 2, viewOrigin.x * 2 + 2);
+
+    // The whole view is copied to the screen again
+    snakeWinModified = true;
+    messageWinModified = true;
+}
+
+
+
+void CursesDisplay::setTextures()
+{
+    init_pair(COLORS_GREEN, COLOR_GREEN, COLOR_BLACK);
+    init_pair(COLORS_MAGENTA, COLOR_MAGENTA, COLOR_BLACK);
+    init_pair(COLORS_YELLOW, COLOR_YELLOW, COLOR_BLACK);
+    init_pair(COLORS_CYAN, COLOR_CYAN, COLOR_BLACK);
+    init_pair(COLORS_RED, COLOR_RED, COLOR_BLACK);
+    init_pair(COLORS_BLACK, COLOR_BLACK, COLOR_BLACK);
+    if (can_change_color() && COLORS >= 256 && COLOR_PAIRS >= 16)
+    {
+        init_color(9, 40, 1000, 90);
+        init_color(10, 900, 70, 1000);
+
+        init_pair(COLORS_ALT_GREEN, 9, COLOR_BLACK);
+        init_pair(COLORS_ALT_MAGENTA, 10, COLOR_BLACK);
+    }
+    else
+    {
+        init_pair(COLORS_ALT_GREEN, COLOR_GREEN, COLOR_BLACK);
+        init_pair(COLORS_ALT_MAGENTA, COLOR_MAGENTA, COLOR_BLACK);
+    }
+
+    const chtype missingTexture = '?';
+
+    gameTextures = new chtype*[TEXTURE_COUNT];
+    gameTextures[0] = new chtype[TEXTURE_COUNT * 2];
+    for (int i = 1; i < TEXTURE_COUNT; ++i)
+    {
+        gameTextures[i] = *gameTextures + (2 * i);
+        gameTextures[i][1] = gameTextures[i][0] = missingTexture;
+    }
+
+    gameTextures[TEXTURE_SNAKE][0]         = '(' | COLOR_PAIR(COLORS_GREEN);
+    gameTextures[TEXTURE_SNAKE][1]         = ')' | COLOR_PAIR(COLORS_GREEN);
+    gameTextures[TEXTURE_SNAKE_HEAD][0]    = '<' | COLOR_PAIR(COLORS_ALT_GREEN);
+    gameTextures[TEXTURE_SNAKE_HEAD][1]    = '>' | COLOR_PAIR(COLORS_ALT_GREEN);
+    gameTextures[TEXTURE_SS_SNAKE][0]      = '(' | COLOR_PAIR(COLORS_MAGENTA);
+    gameTextures[TEXTURE_SS_SNAKE][1]      = ')' | COLOR_PAIR(COLORS_MAGENTA);
+    gameTextures[TEXTURE_SS_SNAKE_HEAD][0] = '<' | COLOR_PAIR(COLORS_ALT_MAGENTA);
+    gameTextures[TEXTURE_SS_SNAKE_HEAD][1] = '>' | COLOR_PAIR(COLORS_ALT_MAGENTA);
+    gameTextures[TEXTURE_FOOD][0]          = '{' | COLOR_PAIR(COLORS_YELLOW);
+    gameTextures[TEXTURE_FOOD][1]          = '}' | COLOR_PAIR(COLORS_YELLOW);
+    gameTextures[TEXTURE_COLLISION][0]     = '*' | COLOR_PAIR(COLORS_RED);
+    gameTextures[TEXTURE_COLLISION][1]     = '*' | COLOR_PAIR(COLORS_RED);
+    gameTextures[TEXTURE_BACKGROUND][0]    = ' ';
+    gameTextures[TEXTURE_BACKGROUND][1]    = ' ';
+}
+
+
+
+void CursesDisplay::updateLengthCounter(std::size_t length)
+{
+    mvwaddstr(gameWin, 0, windowPadding, lengthLabel);
+
+    std::size_t lengthLabelSize = std::strlen(lengthLabel);
+
+    mvwprintw(gameWin, 0, lengthLabelSize + windowPadding, "%-2u", length);
+
+    gameWinModified = true;
+}
+
+
+
+void CursesDisplay::updateMaxLengthCounter(std::size_t maxLength)
+{
+    std::size_t lengthLabelSize = std::strlen(maxLengthLabel);
+    mvwaddstr(gameWin, 0, getmaxx(gameWin) - (lengthLabelSize + windowPadding + 2), maxLengthLabel);
+
+    mvwprintw(gameWin, 0, getmaxx(gameWin) - (windowPadding + 2), "%-2u", maxLength);
+
+    gameWinModified = true;
+}
+
+
+
+void CursesDisplay::update()
+{
+    if ( !(snakeWinModified || gameWinModified || messageWinModified || !dirtyCells.empty()) )
+    {
+        return;
+    }
+
+    updateCells();
+    if (snakeWinModified)
+    {
+        pnoutrefresh(snakeWin, viewOrigin.y, viewOrigin.x * 2,
+                     windowPadding, windowPadding,
+                     windowPadding + viewSize.y - 1, windowPadding + viewSize.x * 2 - 1);
+    }
+    if (messageWinModified)
+    {
+        pnoutrefresh(messageWin, 0, 0,
+                     windowPadding + 2, windowPadding + 2,
+                     windowPadding + viewSize.y - 3, windowPadding + viewSize.x * 2 - 3);
+    }
+    if (gameWinModified)
+    {
+        pnoutrefresh(gameWin, 0, 0,
+                     ScreenSize.y - (gameTextLines + windowPadding), windowPadding,
+                     ScreenSize.y - windowPadding, ScreenSize.x - windowPadding);
+    }
+
+    doupdate();
+
+    snakeWinModified = gameWinModified = messageWinModified = false;
+}
+
+}
\ No newline at end of file
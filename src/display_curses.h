@@ -0,0 +1,146 @@
+
+// display_curses.h
+// Handles display messily using curses backend
+//
+
+#ifndef SLICERSNAKE_DISPLAY_CURSES_H
+#define SLICERSNAKE_DISPLAY_CURSES_H
+
+
+#include <cstdlib> // size_t, system (windows)
+#include <vector>
+
+#ifdef _WIN32
+    #include "curses.h" // pdcurses for windows
+#else
+    #include <ncurses.h> // ncurses for linux (and whatever else it happens to work on)
+#endif
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+class CursesDisplay : public Display
+{
+
+public:
+
+    // PreConditions:
+    //   X and Y should be big enough to not wrap the text
+    //   Y should be larger than x to allow for game messages
+    // PostConditions:
+    //   A Display is created with X and Y size (units of "snake chunks")
+    //   If that is larger than the terminal, only the part of the game window that fits the terminal is shown
+    // Size might later be difficulty depdendant?
+    CursesDisplay() : CursesDisplay(27, 30) {};
+    CursesDisplay(const coordType size_x, const coordType size_y);
+    ~CursesDisplay() override;
+
+    void clearScreen() override;
+
+    coordType getSize_x() const override;
+    coordType getSize_y() const override;
+
+    coordType getViewSize_x() const override;
+    coordType getViewSize_y() const override;
+
+    void keepInView(const Vec2& pos) override;
+
+    void drawTexture(Texture_t texture, const Vec2& pos) override;
+
+    void moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+    void moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+    void moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+
+    void printTextLine(unsigned int lineNumber, const char* message) override;
+
+    void printGameMessage(const char* message) override;
+    void clearGameMessage() override;
+
+    void update() override;
+
+    void updateLengthCounter(std::size_t newLength) override;
+    void updateMaxLengthCounter(std::size_t maxLength) override;
+
+
+private:
+    // curses back-end
+
+    // Initialize curses back-end
+    static void initCurses();
+
+    // Resizes console if necessary and creates the snakeWin and gameWin windows.
+    // If the windows already exist, reset them to the initial static text and border.
+    void initScreen(coordType size_x, coordType size_y);
+
+    // Initialize textures and curses color definitions
+    void setTextures();
+
+    // Forgets what is on the snake window, so every cell is drawn again on the next update
+    void resetCells();
+
+    // Writes the cells drawn since the last update to snakeWin, and copies only the changed parts to the screen
+    void updateCells();
+
+    // Index of the cell at pos in the cell lists
+    std::size_t cellIndex(const Vec2& pos) const;
+
+    // Shows the part of snakeWin from the cell at origin, writing out the cells that changed while they were out of view
+    void scrollView(const Vec2& origin);
+
+    // global size of application window (the part of the terminal that is used)
+    Vec2 ScreenSize;
+
+    // Cells of snakeWin that are on the screen, and the first of them
+    Vec2 viewSize = {0, 0};
+    Vec2 viewOrigin = {0, 0};
+
+    // Bordered window that contains the snakes
+    WINDOW* snakeWin = nullptr;
+    // Textbox located under the window
+    WINDOW* gameWin = nullptr;
+    // Window for outputing text, for menu or instructions (part of the shown part of snakeWin)
+    WINDOW* messageWin = nullptr;
+
+    // A window is modified if it called curses functions directly and needs curses to therefore update that window
+    // Textures drawn in snakeWin are tracked per cell instead, see cellTextures
+    bool snakeWinModified = true;
+    bool gameWinModified = true;
+    bool messageWinModified = true;
+
+    // List of loaded textures (chtypes in curses)
+    chtype** gameTextures = nullptr;
+
+    // Texture last drawn in each cell of snakeWin, and the texture that is in snakeWin (TEXTURE_COUNT if unknown).
+    // Drawing only updates cellTextures, so a cell drawn several times in a step is written out once with its final texture.
+    std::vector<Texture_t> cellTextures;
+    std::vector<Texture_t> shownTextures;
+    // Cells drawn since the last update, each listed once
+    std::vector<std::size_t> dirtyCells;
+    std::vector<bool> cellDirty;
+    // Cells that were drawn while out of view, and aren't written to snakeWin until they come into view
+    std::vector<bool> cellHidden;
+    // Range of columns written to each snakeWin row during an update
+    std::vector<int> rowDirtyBegin;
+    std::vector<int> rowDirtyEnd;
+    std::vector<int> dirtyRows;
+    // Cells per row of snakeWin
+    coordType cellColumns = 0;
+
+    // Size of empty space from game content and window edges
+    const unsigned int windowPadding = 1;
+    // Amount of vertical space alloted for Game Text
+    const unsigned int gameTextLines = 1;
+    // Smallest part of the terminal used, even in a smaller terminal, so that the menu and labels fit
+    const coordType minScreenWidth = 54;
+    const coordType minScreenHeight = 20;
+
+    const char* lengthLabel = "Length: ";
+    const char* maxLengthLabel = "Max Length: ";
+};
+
+}
+
+#endif
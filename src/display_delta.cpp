@@ -0,0 +1,456 @@
+
+#include "display_delta.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "display.h"
+#include "display_grid.h"
+#include "net.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// Indexed by Direction_t
+const Vec2 directionSteps[4] = {{1, 0}, {-1, 0}, {0, -1}, {0, 1}};
+
+
+
+// Returns the direction of the step from 'from' to 'to', or -1 if they aren't next to each other
+int stepDirection(const Vec2& from, const Vec2& to)
+{
+    for (int d = 0; d < 4; ++d)
+    {
+        if (from.x + directionSteps[d].x == to.x && from.y + directionSteps[d].y == to.y)
+        {
+            return d;
+        }
+    }
+
+    return -1;
+}
+
+
+
+std::size_t beginFrame(std::vector<std::uint8_t>& out, ServerMessage_t type, std::uint64_t frame, std::uint64_t delay)
+{
+    std::size_t start = beginMessage(out, type);
+    putNumber(out, frame);
+    putNumber(out, delay);
+    return start;
+}
+
+
+
+bool isTexture(unsigned int texture)
+{
+    return texture >= TEXTURE_SNAKE && texture <= TEXTURE_BACKGROUND;
+}
+
+}
+
+
+
+DeltaDisplay::DeltaDisplay(const coordType size_x, const coordType size_y, Display* inner)
+    : inner(inner), board(size_x, size_y)
+{
+}
+
+
+
+DeltaDisplay::~DeltaDisplay()
+{
+    if (stream != nullptr)
+    {
+        std::fclose(stream);
+    }
+}
+
+
+
+void DeltaDisplay::addCell(Texture_t texture, const Vec2& pos)
+{
+    if (!board.contains(pos) || board.getTexture(pos) == texture)
+    {
+        return;
+    }
+
+    addEvent(DELTA_CELL, 0, texture, pos);
+    board.drawTexture(texture, pos);
+}
+
+
+
+void DeltaDisplay::addEvent(DeltaEvent_t event, int direction, Texture_t texture, const Vec2& pos)
+{
+    events.push_back(static_cast<std::uint8_t>((event << 5) | (direction << 3) | texture));
+    putNumber(events, static_cast<std::uint64_t>(pos.x));
+    putNumber(events, static_cast<std::uint64_t>(pos.y));
+}
+
+
+
+void DeltaDisplay::clearScreen()
+{
+    if (inner != nullptr)
+    {
+        inner->clearScreen();
+    }
+
+    // Nothing drawn before it in the frame can still be seen
+    board.clearScreen();
+    events.clear();
+    events.push_back(static_cast<std::uint8_t>(DELTA_CLEAR << 5));
+
+    // Streams start every new game with a keyframe, so that watching live can start from it
+    framesSinceKeyframe = 0;
+}
+
+
+
+void DeltaDisplay::drawTexture(Texture_t texture, const Vec2& pos)
+{
+    if (inner != nullptr)
+    {
+        inner->drawTexture(texture, pos);
+    }
+
+    addCell(texture, pos);
+}
+
+
+
+void DeltaDisplay::endFrame(std::vector<std::uint8_t>& out)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    lastFrameDelay = (frames > 0) ? static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - lastFrameTime).count()) : 0;
+    lastFrameTime = now;
+    ++frames;
+
+    std::size_t start = beginFrame(out, MSG_DELTA, frames, lastFrameDelay);
+    out.insert(out.end(), events.begin(), events.end());
+    endMessage(out, start);
+    events.clear();
+
+    if (stream == nullptr)
+    {
+        return;
+    }
+
+    // Followers that start in the middle of the stream can start from the last keyframe
+    if (framesSinceKeyframe == 0)
+    {
+        keyframeBuffer.clear();
+        writeKeyframe(keyframeBuffer);
+        std::fwrite(keyframeBuffer.data(), 1, keyframeBuffer.size(), stream);
+    }
+    else
+    {
+        std::fwrite(out.data() + start, 1, out.size() - start, stream);
+    }
+    framesSinceKeyframe = (framesSinceKeyframe + 1) % keyframeInterval;
+
+    // Followers see every frame as soon as it is ended
+    std::fflush(stream);
+}
+
+
+
+std::uint64_t DeltaDisplay::getFrameCount() const
+{
+    return frames;
+}
+
+
+
+coordType DeltaDisplay::getSize_x() const
+{
+    return board.getSize_x();
+}
+
+
+
+coordType DeltaDisplay::getSize_y() const
+{
+    return board.getSize_y();
+}
+
+
+
+coordType DeltaDisplay::getViewSize_x() const
+{
+    return (inner != nullptr) ? inner->getViewSize_x() : board.getViewSize_x();
+}
+
+
+
+coordType DeltaDisplay::getViewSize_y() const
+{
+    return (inner != nullptr) ? inner->getViewSize_y() : board.getViewSize_y();
+}
+
+
+
+void DeltaDisplay::keepInView(const Vec2& pos)
+{
+    if (inner != nullptr)
+    {
+        inner->keepInView(pos);
+    }
+}
+
+
+
+void DeltaDisplay::moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    if (inner != nullptr)
+    {
+        inner->moveSnakeHead(oldPos, newPos, snakeTextures);
+    }
+
+    int direction = stepDirection(oldPos, newPos);
+    if (direction < 0 || !board.contains(oldPos) || !board.contains(newPos))
+    {
+        // Only the cells that are on the board can be drawn
+        addCell(snakeTextures.body, oldPos);
+        addCell(snakeTextures.head, newPos);
+        return;
+    }
+
+    addEvent(DELTA_HEAD, direction, snakeTextures.head, oldPos);
+    events.push_back(static_cast<std::uint8_t>(snakeTextures.body));
+    board.moveSnakeHead(oldPos, newPos, snakeTextures);
+}
+
+
+
+void DeltaDisplay::moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    // Bodies keep their textures, so there is nothing to record
+    if (inner != nullptr)
+    {
+        inner->moveSnakeBody(oldPos, newPos, snakeTextures);
+    }
+}
+
+
+
+void DeltaDisplay::moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    if (inner != nullptr)
+    {
+        inner->moveSnakeTail(oldPos, newPos, snakeTextures);
+    }
+
+    // Tails mostly move onto a body of the same texture, which only leaves the old tail to clear
+    bool clearsOld = board.contains(oldPos) && board.getTexture(oldPos) == snakeTextures.tail;
+    int direction = stepDirection(oldPos, newPos);
+    if (!clearsOld || direction < 0 || !board.contains(newPos))
+    {
+        addCell(snakeTextures.tail, newPos);
+        if (clearsOld)
+        {
+            addCell(TEXTURE_BACKGROUND, oldPos);
+        }
+        return;
+    }
+
+    addEvent(DELTA_TAIL, direction, snakeTextures.tail, oldPos);
+    board.drawTexture(snakeTextures.tail, newPos);
+    board.drawTexture(TEXTURE_BACKGROUND, oldPos);
+}
+
+
+
+bool DeltaDisplay::openStream(const char* path, unsigned int keyframeInterval)
+{
+    assert(keyframeInterval > 0);
+
+    if (stream != nullptr)
+    {
+        std::fclose(stream);
+    }
+    stream = std::fopen(path, "wb");
+    if (stream == nullptr)
+    {
+        return false;
+    }
+
+    this->keyframeInterval = keyframeInterval;
+    framesSinceKeyframe = 0;
+
+    std::vector<std::uint8_t> welcome;
+    std::size_t start = beginMessage(welcome, MSG_WELCOME);
+    putNumber(welcome, 0);
+    putNumber(welcome, static_cast<std::uint64_t>(board.getSize_x() + 1));
+    putNumber(welcome, static_cast<std::uint64_t>(board.getSize_y() + 3));
+    endMessage(welcome, start);
+    std::fwrite(welcome.data(), 1, welcome.size(), stream);
+
+    return true;
+}
+
+
+
+void DeltaDisplay::printGameMessage(const char* message)
+{
+    if (inner != nullptr)
+    {
+        inner->printGameMessage(message);
+    }
+}
+
+
+
+void DeltaDisplay::clearGameMessage()
+{
+    if (inner != nullptr)
+    {
+        inner->clearGameMessage();
+    }
+}
+
+
+
+void DeltaDisplay::printTextLine(unsigned int lineNumber, const char* message)
+{
+    if (inner != nullptr)
+    {
+        inner->printTextLine(lineNumber, message);
+    }
+}
+
+
+
+void DeltaDisplay::update()
+{
+    if (inner != nullptr)
+    {
+        inner->update();
+    }
+
+    if (stream != nullptr)
+    {
+        frameBuffer.clear();
+        endFrame(frameBuffer);
+    }
+}
+
+
+
+void DeltaDisplay::updateLengthCounter(std::size_t newLength)
+{
+    if (inner != nullptr)
+    {
+        inner->updateLengthCounter(newLength);
+    }
+}
+
+
+
+void DeltaDisplay::updateMaxLengthCounter(std::size_t maxLength)
+{
+    if (inner != nullptr)
+    {
+        inner->updateMaxLengthCounter(maxLength);
+    }
+}
+
+
+
+void DeltaDisplay::writeKeyframe(std::vector<std::uint8_t>& out) const
+{
+    std::size_t start = beginFrame(out, MSG_KEYFRAME, frames, lastFrameDelay);
+
+    Vec2 pos;
+    for (pos.y = 0; pos.y < board.getSize_y(); ++pos.y)
+    {
+        for (pos.x = 0; pos.x < board.getSize_x(); ++pos.x)
+        {
+            Texture_t texture = board.getTexture(pos);
+            if (texture != TEXTURE_BACKGROUND)
+            {
+                out.push_back(static_cast<std::uint8_t>((DELTA_CELL << 5) | texture));
+                putNumber(out, static_cast<std::uint64_t>(pos.x));
+                putNumber(out, static_cast<std::uint64_t>(pos.y));
+            }
+        }
+    }
+
+    endMessage(out, start);
+}
+
+
+
+bool readFrameHeader(const std::uint8_t*& payload, const std::uint8_t* end, std::uint64_t& frame, std::uint64_t& delay)
+{
+    return getNumber(payload, end, frame) && getNumber(payload, end, delay);
+}
+
+
+
+bool playDelta(Display& display, const std::uint8_t* payload, const std::uint8_t* end)
+{
+    while (payload < end)
+    {
+        std::uint8_t op = *payload++;
+        unsigned int event = op >> 5;
+        unsigned int direction = (op >> 3) & 3;
+        unsigned int texture = op & 7;
+
+        if (event == DELTA_CLEAR)
+        {
+            display.clearScreen();
+            continue;
+        }
+
+        Vec2 pos;
+        if (event > DELTA_CLEAR || !isTexture(texture) || !getCoord(payload, end, pos.x) || !getCoord(payload, end, pos.y))
+        {
+            return false;
+        }
+
+        Vec2 next = {pos.x + directionSteps[direction].x, pos.y + directionSteps[direction].y};
+        SnakeTextureList textures = {static_cast<Texture_t>(texture), static_cast<Texture_t>(texture), static_cast<Texture_t>(texture)};
+        switch (event)
+        {
+            case (DELTA_CELL) :
+                display.drawTexture(textures.head, pos);
+                break;
+
+            case (DELTA_HEAD) :
+                if (payload == end || !isTexture(*payload))
+                {
+                    return false;
+                }
+                textures.body = static_cast<Texture_t>(*payload++);
+                display.moveSnakeHead(pos, next, textures);
+                break;
+
+            default:
+                display.drawTexture(textures.tail, next);
+                display.drawTexture(TEXTURE_BACKGROUND, pos);
+                break;
+        }
+    }
+
+    return true;
+}
+
+
+
+bool playKeyframe(Display& display, const std::uint8_t* payload, const std::uint8_t* end)
+{
+    display.clearScreen();
+
+    return playDelta(display, payload, end);
+}
+
+}
@@ -0,0 +1,165 @@
+
+// display_delta.h
+// Display that turns what the game draws into a stream of small changes, for spectators and recordings
+//
+
+#ifndef SLICERSNAKE_DISPLAY_DELTA_H
+#define SLICERSNAKE_DISPLAY_DELTA_H
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib> // size_t
+#include <vector>
+
+#include "display.h"
+#include "display_grid.h"
+
+
+namespace ssnake
+{
+
+// Events of a MSG_DELTA, each one byte of (event << 5 | direction << 3 | texture) followed by x and y as numbers.
+// The direction is a Direction_t (right, left, up, down), the step from the cell at x, y to the cell the event also changes.
+//   DELTA_CELL   texture is drawn at x, y (food spawned, cells cleared, collisions)
+//   DELTA_HEAD   the head at x, y moves in direction, leaving a body behind: the texture is the head's,
+//                and one more byte holds the body's texture
+//   DELTA_TAIL   the tail at x, y moves in direction: the texture is drawn at the next cell and x, y is cleared
+//   DELTA_CLEAR  the screen is cleared, without a position
+// A MSG_KEYFRAME is a DELTA_CELL event for every cell that isn't background, drawn on a cleared screen.
+enum DeltaEvent_t
+{
+    DELTA_CELL, DELTA_HEAD, DELTA_TAIL, DELTA_CLEAR
+};
+
+
+
+// Passes everything on to another display (if there is one), and keeps the board changes of every frame as events.
+// A snake that moves costs a head and a tail event, so a frame is a few bytes per snake that moved, and cells that
+// are drawn with the texture they already have are left out. A GridDisplay copy of the board is kept for keyframes.
+// Frames are ended by endFrame, or by update while a stream is open, and are written as net.h messages:
+// a MSG_DELTA with the events of the frame, or a MSG_KEYFRAME with the whole board.
+class DeltaDisplay : public Display
+{
+
+public:
+
+    // PreConditions:
+    //   X and Y are the size the inner display was created with, inner is nullptr or outlives this display
+    // PostConditions:
+    //   A Display is created with X and Y size (units of "snake chunks") that draws to inner too
+    DeltaDisplay(const coordType size_x, const coordType size_y, Display* inner);
+
+    // PreConditions:
+    // PostConditions:
+    //   The stream is closed, the inner display is left alone
+    ~DeltaDisplay() override;
+
+    DeltaDisplay(const DeltaDisplay&) = delete;
+    DeltaDisplay& operator=(const DeltaDisplay&) = delete;
+
+    void clearScreen() override;
+
+    coordType getSize_x() const override;
+    coordType getSize_y() const override;
+
+    coordType getViewSize_x() const override;
+    coordType getViewSize_y() const override;
+
+    void keepInView(const Vec2& pos) override;
+
+    void drawTexture(Texture_t texture, const Vec2& pos) override;
+
+    void moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+    void moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+    void moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+
+    void printTextLine(unsigned int lineNumber, const char* message) override;
+
+    void printGameMessage(const char* message) override;
+    void clearGameMessage() override;
+
+    // PreConditions:
+    // PostConditions:
+    //   The inner display is updated, and the frame is ended if a stream is open
+    void update() override;
+
+    void updateLengthCounter(std::size_t newLength) override;
+    void updateMaxLengthCounter(std::size_t maxLength) override;
+
+    // PreConditions:
+    //   keyframeInterval is at least 1
+    // PostConditions:
+    //   Returns true once path is created, starting with a MSG_WELCOME of the display size (player 0),
+    //   then every frame is written to it: a keyframe for the first one, every keyframeInterval frames and
+    //   after the screen is cleared, otherwise its events
+    //   Returns false if path couldn't be created
+    bool openStream(const char* path, unsigned int keyframeInterval);
+
+    // PreConditions:
+    // PostConditions:
+    //   The frame is ended, with a MSG_DELTA of its events appended to out
+    void endFrame(std::vector<std::uint8_t>& out);
+
+    // PreConditions:
+    // PostConditions:
+    //   A MSG_KEYFRAME of the board is appended to out,
+    //   numbered as the last ended frame so that it can stand in for it right after endFrame
+    void writeKeyframe(std::vector<std::uint8_t>& out) const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of frames that were ended
+    std::uint64_t getFrameCount() const;
+
+
+private:
+
+    void addEvent(DeltaEvent_t event, int direction, Texture_t texture, const Vec2& pos);
+    // Draws texture at pos on the board copy, adding an event if that changes it
+    void addCell(Texture_t texture, const Vec2& pos);
+
+    Display* inner;
+
+    // The board as it is drawn, so that keyframes can be made and cells that don't change can be left out
+    GridDisplay board;
+
+    // Events since the last ended frame
+    std::vector<std::uint8_t> events;
+
+    std::uint64_t frames = 0;
+    std::chrono::steady_clock::time_point lastFrameTime;
+    std::uint64_t lastFrameDelay = 0;
+
+    std::FILE* stream = nullptr;
+    unsigned int keyframeInterval = 0;
+    unsigned int framesSinceKeyframe = 0;
+    // Frames ended by update, and keyframes of the stream
+    std::vector<std::uint8_t> frameBuffer;
+    std::vector<std::uint8_t> keyframeBuffer;
+};
+
+
+
+// PreConditions:
+// PostConditions:
+//   Returns true and sets frame and delay to the frame number and the microseconds since the frame before it
+//   of a MSG_DELTA or MSG_KEYFRAME payload, moving payload past them, or returns false if they are cut short
+bool readFrameHeader(const std::uint8_t*& payload, const std::uint8_t* end, std::uint64_t& frame, std::uint64_t& delay);
+
+// PreConditions:
+//   payload is past the frame header of a MSG_DELTA
+// PostConditions:
+//   The events up to end are drawn to display, returns false if they are cut short or aren't events
+bool playDelta(Display& display, const std::uint8_t* payload, const std::uint8_t* end);
+
+// PreConditions:
+//   payload is past the frame header of a MSG_KEYFRAME
+// PostConditions:
+//   display is cleared and the cells up to end are drawn to it, returns false if they are cut short or aren't textures
+bool playKeyframe(Display& display, const std::uint8_t* payload, const std::uint8_t* end);
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+
+#include "display_grid.h"
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+GridDisplay::GridDisplay(const coordType size_x, const coordType size_y)
+{
+    // Mirror the curses layout: a one chunk border around the snake area and a line for game text
+    size.x = size_x - 1;
+    size.y = size_y - 3;
+
+    std::size_t cellCount = static_cast<std::size_t>(size.x) * size.y;
+    textures.assign(cellCount, TEXTURE_BACKGROUND);
+}
+
+
+
+std::size_t GridDisplay::cellIndex(const Vec2& pos) const
+{
+    return static_cast<std::size_t>(pos.y) * size.x + pos.x;
+}
+
+
+
+void GridDisplay::clearScreen()
+{
+    textures.assign(textures.size(), TEXTURE_BACKGROUND);
+}
+
+
+
+bool GridDisplay::contains(const Vec2& pos) const
+{
+    return pos.x >= 0 && pos.y >= 0 && pos.x < size.x && pos.y < size.y;
+}
+
+
+
+void GridDisplay::drawTexture(Texture_t texture, const Vec2& pos)
+{
+    if (!contains(pos))
+    {
+        return;
+    }
+
+    textures[cellIndex(pos)] = static_cast<std::uint8_t>(texture);
+}
+
+
+
+coordType GridDisplay::getSize_x() const
+{
+    return size.x;
+}
+
+
+
+coordType GridDisplay::getSize_y() const
+{
+    return size.y;
+}
+
+
+
+Texture_t GridDisplay::getTexture(const Vec2& pos) const
+{
+    assert(contains(pos));
+
+    return static_cast<Texture_t>(textures[cellIndex(pos)]);
+}
+
+
+
+coordType GridDisplay::getViewSize_x() const
+{
+    return size.x;
+}
+
+
+
+coordType GridDisplay::getViewSize_y() const
+{
+    return size.y;
+}
+
+
+
+void GridDisplay::moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    drawTexture(snakeTextures.body, oldPos);
+
+    drawTexture(snakeTextures.head, newPos);
+}
+
+
+
+void GridDisplay::moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    drawTexture(snakeTextures.tail, newPos);
+
+    // Don't overwrite anything else when clearing old tail
+    if (contains(oldPos) && getTexture(oldPos) == snakeTextures.tail)
+    {
+        drawTexture(TEXTURE_BACKGROUND, oldPos);
+    }
+}
+
+}
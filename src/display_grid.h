@@ -0,0 +1,85 @@
+
+// display_grid.h
+// Display that keeps the texture of every cell, for sending games over a connection
+//
+
+#ifndef SLICERSNAKE_DISPLAY_GRID_H
+#define SLICERSNAKE_DISPLAY_GRID_H
+
+
+#include <cstdint>
+#include <cstdlib> // size_t
+#include <vector>
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+// Draws into a grid of textures instead of a screen, the way CursesDisplay would draw them.
+// Text and counters are not kept.
+class GridDisplay : public Display
+{
+
+public:
+
+    // PreConditions:
+    //   X and Y are large enough to leave room for a game area (same requirements as CursesDisplay)
+    // PostConditions:
+    //   A Display is created with X and Y size (units of "snake chunks"), with every cell background
+    //   The game area has the same size that a CursesDisplay of the same size would have
+    GridDisplay(const coordType size_x, const coordType size_y);
+
+    void clearScreen() override;
+
+    coordType getSize_x() const override;
+    coordType getSize_y() const override;
+
+    coordType getViewSize_x() const override;
+    coordType getViewSize_y() const override;
+
+    void keepInView(const Vec2& pos) override {};
+
+    void drawTexture(Texture_t texture, const Vec2& pos) override;
+
+    void moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+    void moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override {};
+    void moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+
+    void printTextLine(unsigned int lineNumber, const char* message) override {};
+
+    void printGameMessage(const char* message) override {};
+    void clearGameMessage() override {};
+
+    void update() override {};
+
+    void updateLengthCounter(std::size_t newLength) override {};
+    void updateMaxLengthCounter(std::size_t maxLength) override {};
+
+    // PreConditions:
+    //   pos is inside of the game area
+    // PostConditions:
+    //   Returns the texture of the cell at pos
+    Texture_t getTexture(const Vec2& pos) const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if pos is inside of the game area, drawing anywhere else does nothing
+    bool contains(const Vec2& pos) const;
+
+
+private:
+
+    std::size_t cellIndex(const Vec2& pos) const;
+
+    // Size of the game area (inside the snake border)
+    Vec2 size;
+
+    // Textures of the game area in row-major order, as bytes to keep large boards small
+    std::vector<std::uint8_t> textures;
+};
+
+}
+
+#endif
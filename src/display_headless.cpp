@@ -0,0 +1,45 @@
+
+#include "display_headless.h"
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+HeadlessDisplay::HeadlessDisplay(const coordType size_x, const coordType size_y)
+{
+    // Mirror the curses layout: a one chunk border around the snake area and a line for game text
+    size.x = size_x - 1;
+    size.y = size_y - 3;
+}
+
+
+
+coordType HeadlessDisplay::getSize_x() const
+{
+    return size.x;
+}
+
+
+
+coordType HeadlessDisplay::getSize_y() const
+{
+    return size.y;
+}
+
+
+
+coordType HeadlessDisplay::getViewSize_x() const
+{
+    return size.x;
+}
+
+
+
+coordType HeadlessDisplay::getViewSize_y() const
+{
+    return size.y;
+}
+
+}
@@ -0,0 +1,66 @@
+
+// display_headless.h
+// Display that does no rendering, for running games without a terminal
+//
+
+#ifndef SLICERSNAKE_DISPLAY_HEADLESS_H
+#define SLICERSNAKE_DISPLAY_HEADLESS_H
+
+
+#include <cstdlib> // size_t
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+class HeadlessDisplay : public Display
+{
+
+public:
+
+    // PreConditions:
+    //   X and Y are large enough to leave room for a game area (same requirements as CursesDisplay)
+    // PostConditions:
+    //   A Display is created with X and Y size (units of "snake chunks")
+    //   The game area has the same size that a CursesDisplay of the same size would have
+    HeadlessDisplay() : HeadlessDisplay(27, 30) {};
+    HeadlessDisplay(const coordType size_x, const coordType size_y);
+
+    void clearScreen() override {};
+
+    coordType getSize_x() const override;
+    coordType getSize_y() const override;
+
+    coordType getViewSize_x() const override;
+    coordType getViewSize_y() const override;
+
+    void keepInView(const Vec2& pos) override {};
+
+    void drawTexture(Texture_t texture, const Vec2& pos) override {};
+
+    void moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override {};
+    void moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override {};
+    void moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override {};
+
+    void printTextLine(unsigned int lineNumber, const char* message) override {};
+
+    void printGameMessage(const char* message) override {};
+    void clearGameMessage() override {};
+
+    void update() override {};
+
+    void updateLengthCounter(std::size_t newLength) override {};
+    void updateMaxLengthCounter(std::size_t maxLength) override {};
+
+
+private:
+
+    // Size of the game area (inside the snake border)
+    Vec2 size;
+};
+
+}
+
+#endif
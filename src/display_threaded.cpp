@@ -0,0 +1,324 @@
+
+#include "display_threaded.h"
+
+#include <cassert>
+#include <utility> // swap
+
+
+namespace ssnake
+{
+
+ThreadedDisplay::ThreadedDisplay(Display* inner, double maxFps, std::timed_mutex* drawLock)
+    : inner(inner), drawLock(drawLock), framePeriod(std::chrono::steady_clock::duration::zero())
+{
+    assert(inner != nullptr && maxFps >= 0.0);
+
+    size_x = inner->getSize_x();
+    size_y = inner->getSize_y();
+    viewSize_x = inner->getViewSize_x();
+    viewSize_y = inner->getViewSize_y();
+
+    if (maxFps > 0.0)
+    {
+        framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / maxFps));
+    }
+
+    thread = std::thread(&ThreadedDisplay::runThread, this);
+}
+
+
+
+ThreadedDisplay::~ThreadedDisplay()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        shuttingDown = true;
+    }
+    framePublished.notify_one();
+
+    thread.join();
+}
+
+
+
+ThreadedDisplay::Call& ThreadedDisplay::addCall(Call_t call)
+{
+    drawing.calls.push_back(Call());
+    Call& added = drawing.calls.back();
+    added.call = call;
+    return added;
+}
+
+
+
+std::size_t ThreadedDisplay::addText(const char* message)
+{
+    std::size_t start = drawing.text.size();
+    drawing.text.append(message);
+    drawing.text.push_back('\0');
+    return start;
+}
+
+
+
+void ThreadedDisplay::clearGameMessage()
+{
+    addCall(CALL_CLEAR_GAME_MESSAGE);
+}
+
+
+
+void ThreadedDisplay::clearScreen()
+{
+    // Nothing drawn before is left on a cleared screen
+    drawing.clear();
+    addCall(CALL_CLEAR);
+}
+
+
+
+void ThreadedDisplay::drawTexture(Texture_t texture, const Vec2& pos)
+{
+    Call& call = addCall(CALL_DRAW);
+    call.texture = texture;
+    call.newPos = pos;
+}
+
+
+
+void ThreadedDisplay::Frame::append(const Frame& other)
+{
+    std::size_t textOffset = text.size();
+    text.append(other.text);
+
+    for (const Call& call : other.calls)
+    {
+        calls.push_back(call);
+        calls.back().textStart += textOffset;
+    }
+}
+
+
+
+void ThreadedDisplay::Frame::clear()
+{
+    calls.clear();
+    text.clear();
+}
+
+
+
+void ThreadedDisplay::getFrameCounts(std::uint64_t& published, std::uint64_t& rendered)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    published = publishedFrames;
+    rendered = renderedFrames;
+}
+
+
+
+coordType ThreadedDisplay::getSize_x() const
+{
+    return size_x;
+}
+
+
+
+coordType ThreadedDisplay::getSize_y() const
+{
+    return size_y;
+}
+
+
+
+coordType ThreadedDisplay::getViewSize_x() const
+{
+    return viewSize_x;
+}
+
+
+
+coordType ThreadedDisplay::getViewSize_y() const
+{
+    return viewSize_y;
+}
+
+
+
+void ThreadedDisplay::keepInView(const Vec2& pos)
+{
+    Call& call = addCall(CALL_KEEP_IN_VIEW);
+    call.newPos = pos;
+}
+
+
+
+void ThreadedDisplay::moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    Call& call = addCall(CALL_HEAD);
+    call.oldPos = oldPos;
+    call.newPos = newPos;
+    call.snakeTextures = snakeTextures;
+}
+
+
+
+void ThreadedDisplay::moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures)
+{
+    Call& call = addCall(CALL_TAIL);
+    call.oldPos = oldPos;
+    call.newPos = newPos;
+    call.snakeTextures = snakeTextures;
+}
+
+
+
+void ThreadedDisplay::printGameMessage(const char* message)
+{
+    std::size_t textStart = addText(message);
+    addCall(CALL_GAME_MESSAGE).textStart = textStart;
+}
+
+
+
+void ThreadedDisplay::printTextLine(unsigned int lineNumber, const char* message)
+{
+    std::size_t textStart = addText(message);
+    Call& call = addCall(CALL_TEXT_LINE);
+    call.number = lineNumber;
+    call.textStart = textStart;
+}
+
+
+
+void ThreadedDisplay::render(const Frame& frame)
+{
+    for (const Call& call : frame.calls)
+    {
+        const char* text = frame.text.data() + call.textStart;
+
+        switch (call.call)
+        {
+            case (CALL_CLEAR) :
+                inner->clearScreen();
+                break;
+
+            case (CALL_KEEP_IN_VIEW) :
+                inner->keepInView(call.newPos);
+                break;
+
+            case (CALL_DRAW) :
+                inner->drawTexture(call.texture, call.newPos);
+                break;
+
+            case (CALL_HEAD) :
+                inner->moveSnakeHead(call.oldPos, call.newPos, call.snakeTextures);
+                break;
+
+            case (CALL_TAIL) :
+                inner->moveSnakeTail(call.oldPos, call.newPos, call.snakeTextures);
+                break;
+
+            case (CALL_TEXT_LINE) :
+                inner->printTextLine(static_cast<unsigned int>(call.number), text);
+                break;
+
+            case (CALL_GAME_MESSAGE) :
+                inner->printGameMessage(text);
+                break;
+
+            case (CALL_CLEAR_GAME_MESSAGE) :
+                inner->clearGameMessage();
+                break;
+
+            case (CALL_LENGTH) :
+                inner->updateLengthCounter(call.number);
+                break;
+
+            case (CALL_MAX_LENGTH) :
+                inner->updateMaxLengthCounter(call.number);
+                break;
+        }
+    }
+
+    inner->update();
+}
+
+
+
+void ThreadedDisplay::runThread()
+{
+    std::chrono::steady_clock::time_point nextFrame = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> guard(lock);
+    while (true)
+    {
+        framePublished.wait(guard, [this]() { return shuttingDown || hasPublished; });
+        if (!hasPublished)
+        {
+            return;
+        }
+
+        // Frames published until then are added onto this one, the last one is drawn right away on shutdown
+        framePublished.wait_until(guard, nextFrame, [this]() { return shuttingDown; });
+
+        std::swap(published, rendering);
+        hasPublished = false;
+        ++renderedFrames;
+        guard.unlock();
+
+        nextFrame = std::chrono::steady_clock::now() + framePeriod;
+        if (drawLock != nullptr)
+        {
+            std::lock_guard<std::timed_mutex> drawGuard(*drawLock);
+            render(rendering);
+        }
+        else
+        {
+            render(rendering);
+        }
+        rendering.clear();
+
+        guard.lock();
+    }
+}
+
+
+
+void ThreadedDisplay::update()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        // The waiting frame is replaced by one that starts with a clear, which draws over all of it anyway
+        if (!hasPublished || (!drawing.calls.empty() && drawing.calls.front().call == CALL_CLEAR))
+        {
+            std::swap(published, drawing);
+        }
+        else
+        {
+            published.append(drawing);
+        }
+        hasPublished = true;
+        ++publishedFrames;
+    }
+    framePublished.notify_one();
+
+    drawing.clear();
+}
+
+
+
+void ThreadedDisplay::updateLengthCounter(std::size_t newLength)
+{
+    addCall(CALL_LENGTH).number = newLength;
+}
+
+
+
+void ThreadedDisplay::updateMaxLengthCounter(std::size_t maxLength)
+{
+    addCall(CALL_MAX_LENGTH).number = maxLength;
+}
+
+}
@@ -0,0 +1,158 @@
+
+// display_threaded.h
+// Display that hands what the game draws to a thread that draws it to another display, at most so many times a second
+//
+
+#ifndef SLICERSNAKE_DISPLAY_THREADED_H
+#define SLICERSNAKE_DISPLAY_THREADED_H
+
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib> // size_t
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+// Keeps the calls the game makes as a frame, and update hands the frame to a render thread that makes the same calls
+// on the inner display and updates it, so that the game never waits on the terminal.
+// Frames are double buffered: the game draws into one while the last one it finished waits for the render thread,
+// and a frame finished before the render thread took the one waiting is added onto it, so that frames the terminal
+// can't keep up with (or that come faster than maxFps) are skipped while still ending up with the same screen.
+// Clearing the screen drops everything drawn before it that wasn't rendered yet.
+class ThreadedDisplay : public Display
+{
+
+public:
+
+    // PreConditions:
+    //   inner outlives this display, and nothing else draws to it while this display exists
+    //   maxFps is 0 for no limit
+    //   drawLock is nullptr, or a lock that outlives this display (getTerminalLock for a curses display)
+    // PostConditions:
+    //   A Display is created with the sizes of inner, and a render thread that draws to inner at most maxFps times a second,
+    //   holding drawLock while it does
+    ThreadedDisplay(Display* inner, double maxFps, std::timed_mutex* drawLock = nullptr);
+
+    // PreConditions:
+    // PostConditions:
+    //   The last frame is rendered and the render thread is joined, the inner display is left alone
+    ~ThreadedDisplay() override;
+
+    ThreadedDisplay(const ThreadedDisplay&) = delete;
+    ThreadedDisplay& operator=(const ThreadedDisplay&) = delete;
+
+    void clearScreen() override;
+
+    coordType getSize_x() const override;
+    coordType getSize_y() const override;
+
+    coordType getViewSize_x() const override;
+    coordType getViewSize_y() const override;
+
+    void keepInView(const Vec2& pos) override;
+
+    void drawTexture(Texture_t texture, const Vec2& pos) override;
+
+    void moveSnakeHead(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+    void moveSnakeBody(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override {};
+    void moveSnakeTail(const Vec2& oldPos, const Vec2& newPos, const SnakeTextureList& snakeTextures) override;
+
+    void printTextLine(unsigned int lineNumber, const char* message) override;
+
+    void printGameMessage(const char* message) override;
+    void clearGameMessage() override;
+
+    // PreConditions:
+    // PostConditions:
+    //   The frame is handed to the render thread without waiting on it, and a new one is started
+    void update() override;
+
+    void updateLengthCounter(std::size_t newLength) override;
+    void updateMaxLengthCounter(std::size_t maxLength) override;
+
+    // PreConditions:
+    // PostConditions:
+    //   Sets published to the frames ended by update and rendered to the times the inner display was updated
+    void getFrameCounts(std::uint64_t& published, std::uint64_t& rendered);
+
+
+private:
+
+    enum Call_t
+    {
+        CALL_CLEAR, CALL_KEEP_IN_VIEW, CALL_DRAW, CALL_HEAD, CALL_TAIL,
+        CALL_TEXT_LINE, CALL_GAME_MESSAGE, CALL_CLEAR_GAME_MESSAGE, CALL_LENGTH, CALL_MAX_LENGTH
+    };
+
+    // A call to the display, with the arguments it was made with
+    // Texts are kept in the frame's text, from textStart to the next 0
+    struct Call
+    {
+        Call_t call;
+        Texture_t texture;
+        Vec2 oldPos;
+        Vec2 newPos;
+        SnakeTextureList snakeTextures;
+        std::size_t number;
+        std::size_t textStart;
+    };
+
+    struct Frame
+    {
+        std::vector<Call> calls;
+        std::string text;
+
+        void clear();
+        // Adds the calls of other after the calls of this frame
+        void append(const Frame& other);
+    };
+
+    Call& addCall(Call_t call);
+    std::size_t addText(const char* message);
+
+    // Takes frames as they are published, no faster than framePeriod, until stopped
+    void runThread();
+
+    // Makes the calls of frame on inner, and updates it
+    void render(const Frame& frame);
+
+    Display* inner;
+    std::timed_mutex* drawLock;
+
+    // Sizes of inner, which don't change, so that the game never has to ask it
+    coordType size_x;
+    coordType size_y;
+    coordType viewSize_x;
+    coordType viewSize_y;
+
+    // Time between frames, zero for no limit
+    std::chrono::steady_clock::duration framePeriod;
+
+    // The frame the game is drawing, and the one the render thread is drawing from
+    Frame drawing;
+    Frame rendering;
+
+    // Guards published, hasPublished, shuttingDown and the frame counts
+    std::mutex lock;
+    std::condition_variable framePublished;
+    Frame published;
+    bool hasPublished = false;
+    bool shuttingDown = false;
+    std::uint64_t publishedFrames = 0;
+    std::uint64_t renderedFrames = 0;
+
+    std::thread thread;
+};
+
+}
+
+#endif
@@ -0,0 +1,187 @@
+
+#include "food_field.h"
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+#include "display.h"
+
+
+namespace ssnake
+{
+
+const std::uint32_t FoodField::unreachable;
+const std::uint32_t FoodField::noFood;
+
+
+
+void FoodField::addFood(const Vec2& pos)
+{
+    if (!built)
+    {
+        return;
+    }
+
+    std::uint32_t cell = static_cast<std::uint32_t>(pos.y * size.x + pos.x);
+    if (distance[cell] == 0)
+    {
+        return;
+    }
+
+    distance[cell] = 0;
+    nearest[cell] = cell;
+    ++foodCount;
+    queue.clear();
+    queue.push_back(cell);
+    spread();
+}
+
+
+
+std::uint32_t FoodField::getDistance(const Vec2& pos) const
+{
+    assert(built);
+
+    if (pos.x <= 0 || pos.y <= 0 || pos.x >= size.x - 1 || pos.y >= size.y - 1)
+    {
+        return unreachable;
+    }
+
+    return distance[static_cast<std::size_t>(pos.y) * size.x + pos.x];
+}
+
+
+
+void FoodField::invalidate()
+{
+    built = false;
+}
+
+
+
+void FoodField::removeFood(const Vec2& pos)
+{
+    if (!built)
+    {
+        return;
+    }
+
+    const std::ptrdiff_t stepOffsets[4] = {1, -1, -size.x, size.x};
+
+    std::uint32_t food = static_cast<std::uint32_t>(pos.y * size.x + pos.x);
+    assert(nearest[food] == food && foodCount > 0);
+
+    // Every cell was closest to the last food, so building the field again from the next food is just as fast
+    if (--foodCount == 0)
+    {
+        built = false;
+        return;
+    }
+
+    // Cells closest to other food keep their distance, only the cells of the eaten food can get further away
+    lost.clear();
+    lost.push_back(food);
+    distance[food] = unreachable;
+    nearest[food] = noFood;
+    for (std::size_t front = 0; front < lost.size(); ++front)
+    {
+        for (int d = 0; d < 4; ++d)
+        {
+            std::uint32_t next = static_cast<std::uint32_t>(lost[front] + stepOffsets[d]);
+            if (nearest[next] == food)
+            {
+                distance[next] = unreachable;
+                nearest[next] = noFood;
+                lost.push_back(next);
+            }
+        }
+    }
+
+    // The cells around the lost ones still hold the right distances, so spreading from them fills the lost ones in
+    queue.clear();
+    for (std::uint32_t cell : lost)
+    {
+        for (int d = 0; d < 4; ++d)
+        {
+            std::uint32_t next = static_cast<std::uint32_t>(cell + stepOffsets[d]);
+            if (nearest[next] != noFood)
+            {
+                queue.push_back(next);
+            }
+        }
+    }
+    spread();
+}
+
+
+
+void FoodField::spread()
+{
+    const std::ptrdiff_t stepOffsets[4] = {1, -1, -size.x, size.x};
+
+    // Cells are looked at in the order their distance went down, so each one settles the first time it is reached
+    // when the field is built, and only the cells that got closer are visited when food is added.
+    // The cells removeFood starts from are at different distances, so a lost cell can go down more than once
+    for (std::size_t front = 0; front < queue.size(); ++front)
+    {
+        std::uint32_t cell = queue[front];
+        std::uint32_t nextDistance = distance[cell] + 1;
+
+        for (int d = 0; d < 4; ++d)
+        {
+            std::uint32_t next = static_cast<std::uint32_t>(cell + stepOffsets[d]);
+            if (distance[next] > nextDistance)
+            {
+                distance[next] = nextDistance;
+                nearest[next] = nearest[cell];
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+
+
+void FoodField::update(const Board& board, const std::vector<Vec2>& foodList)
+{
+    if (built && board.getSize_x() == size.x && board.getSize_y() == size.y)
+    {
+        return;
+    }
+
+    size.x = board.getSize_x();
+    size.y = board.getSize_y();
+    distance.assign(static_cast<std::size_t>(size.x) * size.y, unreachable);
+    nearest.assign(distance.size(), noFood);
+    for (coordType x = 0; x < size.x; ++x)
+    {
+        distance[x] = 0;
+        distance[static_cast<std::size_t>(size.y - 1) * size.x + x] = 0;
+    }
+    for (coordType y = 0; y < size.y; ++y)
+    {
+        distance[static_cast<std::size_t>(y) * size.x] = 0;
+        distance[static_cast<std::size_t>(y) * size.x + size.x - 1] = 0;
+    }
+
+    foodCount = 0;
+    queue.clear();
+    for (std::size_t i = 0; i < foodList.size(); ++i)
+    {
+        std::uint32_t cell = static_cast<std::uint32_t>(foodList[i].y * size.x + foodList[i].x);
+        if (distance[cell] != 0)
+        {
+            distance[cell] = 0;
+            nearest[cell] = cell;
+            ++foodCount;
+            queue.push_back(cell);
+        }
+    }
+    spread();
+
+    built = true;
+}
+
+}
@@ -0,0 +1,95 @@
+
+// food_field.h
+// Distance from every cell to the closest food, shared by all computer snakes
+//
+
+#ifndef SLICERSNAKE_FOOD_FIELD_H
+#define SLICERSNAKE_FOOD_FIELD_H
+
+
+#include <cstdint>
+#include <cstdlib> // size_t
+#include <vector>
+
+#include "board.h"
+#include "display.h"
+
+
+namespace ssnake
+{
+
+// Multi-source breadth first search distances from all food, going around the border.
+// Snakes are left out, since they move every step, so snakes only need to check the cells next to their head.
+// New food only makes distances shorter, so it is spread into the field right away.
+// Eaten food only makes the cells that were closest to it further away, so only those are cleared and spread into again.
+class FoodField
+{
+
+public:
+
+    // Distance of cells that no food can reach
+    static const std::uint32_t unreachable = static_cast<std::uint32_t>(-1);
+
+    // PreConditions:
+    // PostConditions:
+    //   Food at pos is added to the field, if the field is up to date
+    void addFood(const Vec2& pos);
+
+    // PreConditions:
+    //   pos holds food that was added to the field, and no other food
+    // PostConditions:
+    //   The food at pos is taken out of the field, if the field is up to date
+    void removeFood(const Vec2& pos);
+
+    // PreConditions:
+    // PostConditions:
+    //   The field will be rebuilt on the next update
+    void invalidate();
+
+    // PreConditions:
+    //   foodList holds every food on board
+    // PostConditions:
+    //   The field holds the distances to the food of foodList, rebuilding it only if it was invalidated
+    void update(const Board& board, const std::vector<Vec2>& foodList);
+
+    // PreConditions:
+    //   The field was updated since the last time it was invalidated, pos is on the board
+    // PostConditions:
+    //   Returns the number of steps from pos to the closest food, or unreachable
+    std::uint32_t getDistance(const Vec2& pos) const;
+
+
+private:
+
+    // Nearest food of cells that have none
+    static const std::uint32_t noFood = static_cast<std::uint32_t>(-1);
+
+    // Lowers the distances of the cells around the cells in queue until nothing changes
+    void spread();
+
+    bool built = false;
+
+    // Food in the field
+    std::size_t foodCount = 0;
+
+    // Board size the field is built for
+    Vec2 size = {0, 0};
+
+    // Distance of each cell in row-major order.
+    // Border cells are stored as 0 so that nothing ever spreads into them, but are reported as unreachable.
+    std::vector<std::uint32_t> distance;
+
+    // Cell of the food each cell got its distance from, noFood for border cells and cells no food can reach.
+    // Every other cell of a food has a neighbour one step closer to it, so the cells of a food are all connected to it.
+    std::vector<std::uint32_t> nearest;
+
+    // Indexes of cells whose distance went down, and whose neighbours need to be checked
+    std::vector<std::uint32_t> queue;
+
+    // Cells removeFood cleared because the eaten food was the one they were closest to
+    std::vector<std::uint32_t> lost;
+};
+
+}
+
+#endif
@@ -1,325 +1,1045 @@
-
-#include "game.h"
-
-#include <chrono>
-#include <list>
-#include <thread> // sleep_until
-
-#include "display.h"
-#include "input.h"
-#include "snake.h"
-
-namespace ssnake
-{
-
-SnakeGame::SnakeGame(Display* displayHandle)
-{
-    display = displayHandle;
-}
-
-
-
-void SnakeGame::decreaseGameSpeed(unsigned int numberOfTimes)
-{
-    gameDelay += 0.0015 * numberOfTimes;
-}
-
-
-
-void SnakeGame::increaseGameSpeed(unsigned int numberOfTimes)
-{
-    gameDelay -= 0.0015 * numberOfTimes;
-}
-
-
-
-double SnakeGame::getGameDelay() const
-{
-    return gameDelay;
-}
-
-
-
-void SnakeGame::setGameDelay(double numSeconds)
-{
-    gameDelay = numSeconds;
-}
-
-
-
-void SnakeGame::processInputs(std::chrono::steady_clock::time_point& beginTime, Snake* playerSnake)
-{
-    if (input.getQuit())
-    {
-        alive = false;
-    }
-
-    Direction_t oldDir = playerSnake->getDirection();
-    Direction_t newDir;
-    switch (input.getDirection())
-    {
-        case (LEFT_KEY) :
-            newDir = LEFT;
-            break;
-        case (RIGHT_KEY) :
-            newDir = RIGHT;
-            break;
-        case (UP_KEY) :
-            newDir = UP;
-            break;
-        case (DOWN_KEY) :
-            newDir = DOWN;
-            break;
-        default:
-            newDir = oldDir;
-            break;
-    }
-    playerSnake->setDirection(newDir);
-
-    // Use older input if the player has an invalid input as the most recent
-    if (playerSnake->getDirection() == oldDir)
-    {
-        switch (input.getPrevDirection())
-        {
-            case (LEFT_KEY) :
-                newDir = LEFT;
-                break;
-            case (RIGHT_KEY) :
-                newDir = RIGHT;
-                break;
-            case (UP_KEY) :
-                newDir = UP;
-                break;
-            case (DOWN_KEY) :
-                newDir = DOWN;
-                break;
-            default:
-                break;
-        }
-        playerSnake->setDirection(newDir);
-    }
-
-    if (input.getPause())
-    {
-        display->printGameMessage("Paused");
-
-        do
-        {
-            input.collectInput();
-        } while (!input.getEnter());
-        beginTime = std::chrono::steady_clock::now();
-
-        display->clearGameMessage();
-    }
-}
-
-
-
-void SnakeGame::startGame(Game_t newGameType)
-{
-    gameType = newGameType;
-
-    snakeList.clear();
-    foodList.clear();
-
-    alive = true;
-
-    display->clearScreen();
-
-    switch (newGameType)
-    {
-        case GM_SLICER:
-        runNewSlicerGame();
-        break;
-
-        case GM_CLASSIC:
-        runNewClassicGame();
-        break;
-
-        default:
-        break;
-    }
-}
-
-
-
-void SnakeGame::runNewClassicGame()
-{
-    setGameDelay(0.09);
-
-    SnakeTextureList textures;
-    Vec2 snakeStartingPos = {4, 3};
-    textures.head = TEXTURE_SNAKE_HEAD; textures.body = TEXTURE_SNAKE; textures.tail = TEXTURE_SNAKE;
-    snakeList.emplace_front(display, textures, snakeStartingPos, 3);
-    Snake* playerSnake = &(snakeList.front());
-
-    spawnFood();
-
-    display->updateLengthCounter(playerSnake->getLength());
-
-    display->update();
-
-    std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
-    while (alive)
-    {
-        int msDelay = static_cast<int>(getGameDelay() * 1000);
-        std::this_thread::sleep_until(beginTime + std::chrono::milliseconds(msDelay));
-        beginTime = std::chrono::steady_clock::now();
-
-        input.updateInputs();
-
-        processInputs(beginTime, playerSnake);
-
-        playerSnake->move();
-
-        for (std::list<Vec2>::iterator it = foodList.begin(); it != foodList.end(); ++it)
-        {
-            if (playerSnake->checkFood(*it))
-            {
-                increaseGameSpeed();
-
-                display->updateLengthCounter(playerSnake->getLength());
-
-                foodList.erase(it);
-                spawnFood();
-                break;
-            }
-        }
-
-        alive = alive && !(playerSnake->checkCollision());
-
-        display->update();
-    }
-}
-
-
-
-void SnakeGame::runNewSlicerGame()
-{
-    setGameDelay(0.09);
-
-    SnakeTextureList textures;
-    Vec2 snakeStartingPos = {4, 3};
-    textures.head = TEXTURE_SNAKE_HEAD; textures.body = TEXTURE_SNAKE; textures.tail = TEXTURE_SNAKE;
-    snakeList.emplace_front(display, textures, snakeStartingPos, 3);
-    Snake* playerSnake = &(snakeList.front());
-
-    snakeStartingPos = {display->getSize_x() - 4, display->getSize_y() - 3};
-    textures.head = TEXTURE_SS_SNAKE_HEAD; textures.body = TEXTURE_SS_SNAKE; textures.tail = TEXTURE_SS_SNAKE;
-    snakeList.emplace_front(display, textures, snakeStartingPos, 3);
-
-    spawnFood();
-
-    size_t maxLength = playerSnake->getLength();
-    display->updateLengthCounter(playerSnake->getLength());
-    display->updateMaxLengthCounter(maxLength);
-
-    display->update();
-
-    bool isPlayer;
-    std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
-    while (alive)
-    {
-        int msDelay = static_cast<int>(getGameDelay() * 1000);
-        std::this_thread::sleep_until(beginTime + std::chrono::milliseconds(msDelay));
-        beginTime = std::chrono::steady_clock::now();
-
-        input.updateInputs();
-        processInputs(beginTime, playerSnake);
-
-        for (std::list<Snake>::iterator snakeIter = snakeList.begin(); snakeIter != snakeList.end(); ++snakeIter)
-        {
-            isPlayer = playerSnake == &(*snakeIter);
-
-            if (!isPlayer)
-            {
-                snakeIter->ai_getDirection(foodList);
-            }
-            snakeIter->move();
-
-            int n = snakeIter->checkSlice(snakeList);
-            if (n > 0)
-            {
-                decreaseGameSpeed(n);
-                display->updateLengthCounter(playerSnake->getLength());
-            }
-
-            if (!isPlayer)
-            {
-                if (snakeIter->checkCollision())
-                {
-                    std::list<Snake>::iterator deadSnake = snakeIter--;
-                    snakeList.erase(deadSnake);
-                    continue;
-                }
-            }
-
-            for (std::list<Vec2>::iterator it = foodList.begin(); it != foodList.end(); ++it)
-            {
-                if (snakeIter->checkFood(*it))
-                {
-                    increaseGameSpeed();
-
-                    if (isPlayer)
-                    {
-                        display->updateLengthCounter(playerSnake->getLength());
-                        if (playerSnake->getLength() > maxLength)
-                        {
-                            maxLength = playerSnake->getLength();
-                            display->updateMaxLengthCounter(maxLength);
-                        }
-                    }
-
-                    foodList.erase(it);
-                    spawnFood();
-                    break;
-                }
-            }
-        }
-
-        alive = alive && !(playerSnake->checkCollision());
-
-        display->update();
-    }
-}
-
-
-
-void SnakeGame::spawnFood()
-{
-    Vec2 win = {display->getSize_x(), display->getSize_y()};
-    Vec2 food;
-
-    // don't spawn food on snakes or other food
-    bool foodBad;
-    do
-    {
-        foodBad = false;
-        food.x = rand() % (win.x - 2) + 1;
-        food.y = rand() % (win.y - 2) + 1;
-
-        for (std::list<Snake>::const_iterator snakeIter = snakeList.cbegin(); snakeIter != snakeList.cend(); ++snakeIter)
-        {
-            if (snakeIter->checkTouch(food))
-            {
-                foodBad = true;
-                break;
-            }
-        }
-        for (std::list<Vec2>::const_iterator it = foodList.cbegin(); it != foodList.cend(); ++it)
-        {
-            if (food.x == it->x && food.y == it->y)
-            {
-                foodBad = true;
-                break;
-            }
-        }
-    } while (foodBad);
-
-    foodList.push_back(food);
-    display->drawTexture(TEXTURE_FOOD, food);
-
-    return;
-}
-
+
+#include "game.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iterator> // advance
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "board.h"
+#include "display.h"
+#include "input.h"
+#include "mcts.h"
+#include "random.h"
+#include "replay.h"
+#include "snake.h"
+
+namespace ssnake
+{
+
+namespace
+{
+
+const SnakeTextureList playerTextures = {TEXTURE_SNAKE_HEAD, TEXTURE_SNAKE, TEXTURE_SNAKE};
+const SnakeTextureList computerTextures = {TEXTURE_SS_SNAKE_HEAD, TEXTURE_SS_SNAKE, TEXTURE_SS_SNAKE};
+
+}
+
+
+
+constexpr double SnakeGame::minGameDelay;
+
+
+
+SnakeGame::SnakeGame(Display* displayHandle)
+    : board(displayHandle->getSize_x(), displayHandle->getSize_y())
+{
+    display = displayHandle;
+}
+
+
+
+SnakeGame::~SnakeGame()
+{
+    endReplay();
+}
+
+
+
+void SnakeGame::decreaseGameSpeed(unsigned int numberOfTimes)
+{
+    gameDelay += 0.0015 * numberOfTimes;
+}
+
+
+
+void SnakeGame::increaseGameSpeed(unsigned int numberOfTimes)
+{
+    gameDelay -= 0.0015 * numberOfTimes;
+}
+
+
+
+double SnakeGame::getGameDelay() const
+{
+    return gameDelay;
+}
+
+
+
+void SnakeGame::setGameDelay(double numSeconds)
+{
+    gameDelay = numSeconds;
+}
+
+
+
+void SnakeGame::applyAction(Snake* snake, const PlayerAction& action)
+{
+    if (action.quit)
+    {
+        alive = false;
+        deathCause = DEATH_QUIT;
+    }
+
+    if (action.autopilot)
+    {
+        steerComputerSnake(snake);
+        return;
+    }
+
+    Direction_t oldDir = snake->getDirection();
+    Direction_t newDir;
+    switch (action.direction)
+    {
+        case (LEFT_KEY) :
+            newDir = LEFT;
+            break;
+        case (RIGHT_KEY) :
+            newDir = RIGHT;
+            break;
+        case (UP_KEY) :
+            newDir = UP;
+            break;
+        case (DOWN_KEY) :
+            newDir = DOWN;
+            break;
+        default:
+            newDir = oldDir;
+            break;
+    }
+    snake->setDirection(newDir);
+
+    // Use older input if the player has an invalid input as the most recent
+    if (snake->getDirection() == oldDir)
+    {
+        switch (action.prevDirection)
+        {
+            case (LEFT_KEY) :
+                newDir = LEFT;
+                break;
+            case (RIGHT_KEY) :
+                newDir = RIGHT;
+                break;
+            case (UP_KEY) :
+                newDir = UP;
+                break;
+            case (DOWN_KEY) :
+                newDir = DOWN;
+                break;
+            default:
+                break;
+        }
+        snake->setDirection(newDir);
+    }
+}
+
+
+
+void SnakeGame::steerComputerSnake(Snake* snake)
+{
+    switch (aiMode)
+    {
+        case AI_PATHFINDING:
+        snake->ai_findPath(pathfinder);
+        break;
+
+        case AI_FOOD_FIELD:
+        // Only built by the first snake of a game, food changes are applied as they happen
+        foodField.update(board, foodList);
+        snake->ai_followField(foodField);
+        break;
+
+        case AI_MCTS:
+        if (!searchDirection(snake))
+        {
+            // Out of time, so the snake goes where the playouts would have taken it
+            foodField.update(board, foodList);
+            snake->ai_followField(foodField);
+        }
+        break;
+
+        default:
+        snake->ai_getDirection(foodList, rng);
+        break;
+    }
+}
+
+
+
+bool SnakeGame::searchDirection(Snake* snake)
+{
+    if (!planner)
+    {
+        planner.reset(new MctsPlanner(mctsConfig, board.getSize_x(), board.getSize_y()));
+    }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    if (mctsConfig.thinkShare > 0.0)
+    {
+        // Every search gets an even share of what is left of the step's time
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        long searches = (searchesLeft > 0) ? static_cast<long>(searchesLeft) : 1;
+        deadline = (thinkEnd > now) ? now + (thinkEnd - now) / searches : now;
+        if (searchesLeft > 0)
+        {
+            --searchesLeft;
+        }
+    }
+
+    int snakeIndex = 0;
+    for (std::list<Snake>::iterator it = snakeList.begin(); &(*it) != snake; ++it)
+    {
+        ++snakeIndex;
+    }
+
+    snapshot(searchRoot);
+    Direction_t direction;
+    if (!planner->search(searchRoot, snakeIndex, deadline, direction))
+    {
+        return false;
+    }
+
+    snake->setDirection(direction);
+    return true;
+}
+
+
+
+void SnakeGame::checkPlayerCollision()
+{
+    // Multiplayer games go on without a player of their own
+    if (playerSnake == nullptr)
+    {
+        return;
+    }
+
+    DeathCause_t cause;
+    switch (playerSnake->checkCollision())
+    {
+        case COLLISION_WALL:
+        cause = DEATH_WALL;
+        break;
+
+        case COLLISION_SELF:
+        cause = DEATH_SELF;
+        break;
+
+        case COLLISION_EATEN:
+        cause = DEATH_EATEN;
+        break;
+
+        default:
+        return;
+    }
+
+    // A player that quit during this step keeps that as the reason
+    if (alive)
+    {
+        deathCause = cause;
+    }
+    alive = false;
+}
+
+
+
+DeathCause_t SnakeGame::getDeathCause() const
+{
+    return deathCause;
+}
+
+
+
+std::size_t SnakeGame::getMaxLength() const
+{
+    return maxLength;
+}
+
+
+
+std::size_t SnakeGame::getPlayerLength() const
+{
+    if (playerSnake == nullptr)
+    {
+        return 0;
+    }
+
+    return playerSnake->getLength();
+}
+
+
+
+const Snake* SnakeGame::getPlayerSnake(std::size_t player) const
+{
+    return (player < players.size()) ? players[player] : nullptr;
+}
+
+
+
+int SnakeGame::getPlayerIndex(const Snake* snake) const
+{
+    std::size_t id = static_cast<std::size_t>(snake->getId());
+    return (id < idPlayers.size()) ? idPlayers[id] : -1;
+}
+
+
+
+std::size_t SnakeGame::getComputerSnakeCount() const
+{
+    return snakeList.size() - playerCount - ((playerSnake != nullptr) ? 1 : 0);
+}
+
+
+
+unsigned long SnakeGame::getStepCount() const
+{
+    return stepCount;
+}
+
+
+
+bool SnakeGame::isAlive() const
+{
+    return alive;
+}
+
+
+
+void SnakeGame::newGame(Game_t newGameType, std::uint64_t seed)
+{
+    // A game that was stopped before it was over is still a complete replay
+    endReplay();
+    if (replayWriter != nullptr)
+    {
+        ReplayHeader header;
+        header.gameType = newGameType;
+        header.seed = seed;
+        header.size_x = board.getSize_x();
+        header.size_y = board.getSize_y();
+        header.arenaSnakes = static_cast<std::uint32_t>(arenaSnakeCount);
+        header.aiMode = aiMode;
+        header.mctsRollouts = (mctsConfig.thinkShare > 0.0) ? 0 : static_cast<std::uint32_t>(mctsConfig.rollouts);
+        replayWriter->beginGame(header);
+    }
+
+    gameType = newGameType;
+    rng.seed(seed);
+
+    // The order of the free cells decides where food goes, so the board has to start out the same every game
+    snakeList.clear();
+    foodList.clear();
+    board.reset();
+    foodField.invalidate();
+
+    playerSnake = nullptr;
+    players.clear();
+    idPlayers.clear();
+    playerCount = 0;
+    maxLength = 0;
+    stepCount = 0;
+    alive = true;
+    deathCause = DEATH_NONE;
+
+    display->clearScreen();
+
+    switch (newGameType)
+    {
+        case GM_SLICER:
+        initSlicerGame();
+        break;
+
+        case GM_CLASSIC:
+        initClassicGame();
+        break;
+
+        case GM_ARENA:
+        initArenaGame();
+        break;
+
+        case GM_MULTIPLAYER:
+        initMultiplayerGame();
+        break;
+
+        default:
+        alive = false;
+        break;
+    }
+}
+
+
+
+void SnakeGame::startGame(Game_t newGameType, std::uint64_t seed, PlayerInput& input)
+{
+    newGame(newGameType, seed);
+
+    // Boards larger than the screen are scrolled along with the player
+    display->keepInView(playerSnake->getHeadPosition());
+    display->update();
+
+    TickPacer ownPacer(minGameDelay, 0.0);
+    TickPacer& pacer = (tickPacer != nullptr) ? *tickPacer : ownPacer;
+
+    std::vector<PlayerAction> actions(1);
+    input.startCollecting();
+    pacer.restart();
+    while (alive)
+    {
+        // Keys are read as they are pressed while waiting for the step, and used all together by it
+        pacer.schedule(getGameDelay());
+        input.waitUntil(pacer.getWakeTime());
+        pacer.startTick();
+        SSNAKE_PROFILE_MARK(profiler);
+
+#ifdef SSNAKE_PROFILE
+        std::chrono::steady_clock::time_point inputTime;
+        if (profiler != nullptr)
+        {
+            profiler->addTime(PHASE_JITTER, pacer.getLastLateness());
+            if (input.getInputTime(inputTime))
+            {
+                profiler->addTime(PHASE_LATENCY, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - inputTime).count()));
+            }
+        }
+#endif
+
+        actions[0].direction = input.getDirection();
+        actions[0].prevDirection = input.getPrevDirection();
+        actions[0].quit = input.getQuit();
+        SSNAKE_PROFILE_LAP(profiler, PHASE_INPUT);
+
+        if (input.getPause())
+        {
+            display->printGameMessage("Paused");
+
+            do
+            {
+                input.collectInput();
+            } while (!input.getEnter());
+            pacer.restart();
+
+            display->clearGameMessage();
+            SSNAKE_PROFILE_MARK(profiler);
+        }
+
+        step(actions);
+
+#ifdef SSNAKE_PROFILE
+        if (profiler != nullptr)
+        {
+            showTimings(input.getTimings());
+        }
+#endif
+        input.startCollecting();
+
+        display->keepInView(playerSnake->getHeadPosition());
+        display->update();
+        SSNAKE_PROFILE_LAP(profiler, PHASE_RENDER);
+        SSNAKE_PROFILE_END_TICK(profiler);
+    }
+}
+
+
+
+StepResult SnakeGame::step(const std::vector<PlayerAction>& actions)
+{
+    StepResult result;
+
+    if (!alive)
+    {
+        return result;
+    }
+
+    if (replayWriter != nullptr && replayWriter->inGame())
+    {
+        replayWriter->recordStep(actions.empty() ? PlayerAction() : actions[0]);
+    }
+    SSNAKE_PROFILE_LAP(profiler, PHASE_OTHER);
+
+    if (aiMode == AI_MCTS && mctsConfig.thinkShare > 0.0)
+    {
+        // The searches of the step think through time that the game loop would otherwise sleep through
+        std::chrono::duration<double> thinkTime(((gameDelay > minGameDelay) ? gameDelay : minGameDelay) * mctsConfig.thinkShare);
+        thinkEnd = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(thinkTime);
+        searchesLeft = getComputerSnakeCount() + ((!actions.empty() && actions[0].autopilot) ? 1 : 0);
+    }
+
+    if (playerSnake != nullptr && !actions.empty())
+    {
+        applyAction(playerSnake, actions[0]);
+    }
+    for (std::size_t player = 0; player < actions.size() && player < players.size(); ++player)
+    {
+        if (players[player] == nullptr)
+        {
+            continue;
+        }
+
+        // Quitting only takes the player out, the game goes on for everyone else
+        if (actions[player].quit)
+        {
+            removePlayer(player);
+        }
+        else
+        {
+            applyAction(players[player], actions[player]);
+        }
+    }
+    SSNAKE_PROFILE_LAP(profiler, PHASE_AI);
+
+    switch (gameType)
+    {
+        case GM_SLICER:
+        stepSlicerGame(result);
+        break;
+
+        case GM_CLASSIC:
+        stepClassicGame(result);
+        break;
+
+        case GM_ARENA:
+        case GM_MULTIPLAYER:
+        stepSlicerGame(result);
+        // A few tries per step is enough, a snake that doesn't fit comes back on a later step
+        for (int tries = 0; tries < 4 && getComputerSnakeCount() < arenaSnakeTarget; ++tries)
+        {
+            spawnArenaSnake(computerTextures);
+        }
+        SSNAKE_PROFILE_LAP(profiler, PHASE_OTHER);
+        break;
+
+        default:
+        break;
+    }
+
+    ++stepCount;
+
+    if (!alive)
+    {
+        endReplay();
+    }
+
+    result.alive = alive;
+    result.playerLength = getPlayerLength();
+    SSNAKE_PROFILE_LAP(profiler, PHASE_OTHER);
+
+    return result;
+}
+
+
+
+void SnakeGame::snapshot(GameSnapshot& snapshot) const
+{
+    snapshot.rng = rng;
+    snapshot.gameDelay = gameDelay;
+    snapshot.gameType = gameType;
+    snapshot.alive = alive;
+    snapshot.deathCause = deathCause;
+    snapshot.maxLength = maxLength;
+    snapshot.stepCount = stepCount;
+    snapshot.arenaSnakeTarget = arenaSnakeTarget;
+
+    board.saveState(snapshot.board);
+
+    snapshot.playerIndex = -1;
+    snapshot.snakes.resize(snakeList.size());
+    snapshot.bodies.clear();
+    std::size_t i = 0;
+    for (std::list<Snake>::const_iterator it = snakeList.cbegin(); it != snakeList.cend(); ++it, ++i)
+    {
+        if (&(*it) == playerSnake)
+        {
+            snapshot.playerIndex = static_cast<int>(i);
+        }
+        it->saveState(snapshot.snakes[i], snapshot.bodies);
+    }
+
+    snapshot.foodList = foodList;
+}
+
+
+
+void SnakeGame::restore(const GameSnapshot& snapshot)
+{
+    players.clear();
+    idPlayers.clear();
+    playerCount = 0;
+
+    // Extra snakes clear themselves from the board, which is overwritten right after
+    while (snakeList.size() > snapshot.snakes.size())
+    {
+        snakeList.pop_back();
+    }
+
+    board.loadState(snapshot.board);
+
+    // Snakes that are kept are loaded in place, since they can't be copied
+    std::size_t i = 0;
+    for (std::list<Snake>::iterator it = snakeList.begin(); it != snakeList.end(); ++it, ++i)
+    {
+        it->loadState(snapshot.snakes[i], snapshot.bodies);
+    }
+    for (; i < snapshot.snakes.size(); ++i)
+    {
+        snakeList.emplace_back(display, &board, snapshot.snakes[i], snapshot.bodies);
+    }
+
+    playerSnake = nullptr;
+    if (snapshot.playerIndex >= 0)
+    {
+        std::list<Snake>::iterator player = snakeList.begin();
+        std::advance(player, snapshot.playerIndex);
+        playerSnake = &(*player);
+    }
+
+    foodList = snapshot.foodList;
+    foodField.invalidate();
+
+    rng = snapshot.rng;
+    gameDelay = snapshot.gameDelay;
+    gameType = snapshot.gameType;
+    alive = snapshot.alive;
+    deathCause = snapshot.deathCause;
+    maxLength = snapshot.maxLength;
+    stepCount = snapshot.stepCount;
+    arenaSnakeTarget = snapshot.arenaSnakeTarget;
+}
+
+
+
+void SnakeGame::initClassicGame()
+{
+    setGameDelay(0.09);
+
+    SnakeTextureList textures;
+    Vec2 snakeStartingPos = {4, 3};
+    textures.head = TEXTURE_SNAKE_HEAD; textures.body = TEXTURE_SNAKE; textures.tail = TEXTURE_SNAKE;
+    snakeList.emplace_front(display, &board, textures, snakeStartingPos, 3);
+    playerSnake = &(snakeList.front());
+
+    spawnFood();
+
+    maxLength = playerSnake->getLength();
+    display->updateLengthCounter(playerSnake->getLength());
+}
+
+
+
+void SnakeGame::stepClassicGame(StepResult& result)
+{
+    playerSnake->move();
+    SSNAKE_PROFILE_LAP(profiler, PHASE_MOVE);
+
+    unsigned int foodIndex;
+    if (playerSnake->checkFood(foodIndex))
+    {
+        increaseGameSpeed();
+        ++result.foodEaten;
+
+        display->updateLengthCounter(playerSnake->getLength());
+        if (playerSnake->getLength() > maxLength)
+        {
+            maxLength = playerSnake->getLength();
+        }
+
+        removeFood(foodIndex);
+        spawnFood();
+    }
+    SSNAKE_PROFILE_LAP(profiler, PHASE_FOOD);
+
+    checkPlayerCollision();
+    SSNAKE_PROFILE_LAP(profiler, PHASE_COLLISION);
+}
+
+
+
+void SnakeGame::initSlicerGame()
+{
+    setGameDelay(0.09);
+
+    SnakeTextureList textures;
+    Vec2 snakeStartingPos = {4, 3};
+    textures.head = TEXTURE_SNAKE_HEAD; textures.body = TEXTURE_SNAKE; textures.tail = TEXTURE_SNAKE;
+    snakeList.emplace_front(display, &board, textures, snakeStartingPos, 3);
+    playerSnake = &(snakeList.front());
+
+    snakeStartingPos = {display->getSize_x() - 4, display->getSize_y() - 3};
+    textures.head = TEXTURE_SS_SNAKE_HEAD; textures.body = TEXTURE_SS_SNAKE; textures.tail = TEXTURE_SS_SNAKE;
+    snakeList.emplace_front(display, &board, textures, snakeStartingPos, 3);
+
+    spawnFood();
+
+    maxLength = playerSnake->getLength();
+    display->updateLengthCounter(playerSnake->getLength());
+    display->updateMaxLengthCounter(maxLength);
+}
+
+
+
+void SnakeGame::initArenaGame()
+{
+    setGameDelay(0.09);
+
+    SnakeTextureList textures;
+    Vec2 snakeStartingPos = {4, 3};
+    textures.head = TEXTURE_SNAKE_HEAD; textures.body = TEXTURE_SNAKE; textures.tail = TEXTURE_SNAKE;
+    snakeList.emplace_front(display, &board, textures, snakeStartingPos, 3);
+    playerSnake = &(snakeList.front());
+
+    fillArena();
+
+    maxLength = playerSnake->getLength();
+    display->updateLengthCounter(playerSnake->getLength());
+    display->updateMaxLengthCounter(maxLength);
+}
+
+
+
+void SnakeGame::initMultiplayerGame()
+{
+    setGameDelay(0.09);
+
+    fillArena();
+}
+
+
+
+void SnakeGame::fillArena()
+{
+    // Roughly one snake for every 100 cells unless asked for otherwise
+    arenaSnakeTarget = arenaSnakeCount;
+    if (arenaSnakeTarget == 0)
+    {
+        arenaSnakeTarget = static_cast<std::size_t>(board.getSize_x()) * board.getSize_y() / 100 + 1;
+    }
+
+    for (std::size_t i = 0; i < arenaSnakeTarget * 4 && getComputerSnakeCount() < arenaSnakeTarget; ++i)
+    {
+        spawnArenaSnake(computerTextures);
+    }
+
+    for (std::size_t i = 0; i < arenaSnakeTarget / 2 + 1; ++i)
+    {
+        spawnFood();
+    }
+}
+
+
+
+void SnakeGame::stepSlicerGame(StepResult& result)
+{
+    // Arena games keep the same speed no matter what happens
+    bool fixedSpeed = gameType == GM_ARENA || gameType == GM_MULTIPLAYER;
+
+    bool isPlayer;
+    for (std::list<Snake>::iterator snakeIter = snakeList.begin(); snakeIter != snakeList.end();)
+    {
+        isPlayer = playerSnake == &(*snakeIter);
+        int player = getPlayerIndex(&(*snakeIter));
+
+        if (!isPlayer && player < 0)
+        {
+            steerComputerSnake(&(*snakeIter));
+        }
+        SSNAKE_PROFILE_LAP(profiler, PHASE_AI);
+        snakeIter->move();
+        SSNAKE_PROFILE_LAP(profiler, PHASE_MOVE);
+
+        int n = snakeIter->checkSlice();
+        if (n > 0)
+        {
+            if (!fixedSpeed)
+            {
+                decreaseGameSpeed(n);
+            }
+            result.piecesSliced += n;
+            display->updateLengthCounter(getPlayerLength());
+        }
+        SSNAKE_PROFILE_LAP(profiler, PHASE_SLICE);
+
+        if (!isPlayer)
+        {
+            if (snakeIter->checkCollision())
+            {
+                // Lots of snakes die in an arena, so don't leave them all on the screen
+                if (fixedSpeed)
+                {
+                    snakeIter->clearDisplay();
+                }
+                if (player >= 0)
+                {
+                    releasePlayer(player);
+                }
+
+                snakeIter = snakeList.erase(snakeIter);
+                SSNAKE_PROFILE_LAP(profiler, PHASE_COLLISION);
+                continue;
+            }
+        }
+        SSNAKE_PROFILE_LAP(profiler, PHASE_COLLISION);
+
+        unsigned int foodIndex;
+        if (snakeIter->checkFood(foodIndex))
+        {
+            if (!fixedSpeed)
+            {
+                increaseGameSpeed();
+            }
+            ++result.foodEaten;
+
+            if (isPlayer)
+            {
+                display->updateLengthCounter(playerSnake->getLength());
+                if (playerSnake->getLength() > maxLength)
+                {
+                    maxLength = playerSnake->getLength();
+                    display->updateMaxLengthCounter(maxLength);
+                }
+            }
+
+            removeFood(foodIndex);
+            spawnFood();
+        }
+        SSNAKE_PROFILE_LAP(profiler, PHASE_FOOD);
+
+        ++snakeIter;
+    }
+
+    // Players that were eaten by a snake after them in the list would be left without a head until the next step
+    for (std::size_t player = 0; player < players.size() && playerCount > 0; ++player)
+    {
+        if (players[player] != nullptr && players[player]->isEaten())
+        {
+            removePlayer(player);
+        }
+    }
+
+    checkPlayerCollision();
+    SSNAKE_PROFILE_LAP(profiler, PHASE_COLLISION);
+}
+
+
+
+bool SnakeGame::spawnFood()
+{
+    // Every cell is taken, so there is nowhere to put food
+    Vec2 food;
+    if (!board.pickFreeCell(rng, food))
+    {
+        return false;
+    }
+
+    board.setFood(food, static_cast<unsigned int>(foodList.size()));
+    foodList.push_back(food);
+    foodField.addFood(food);
+    display->drawTexture(TEXTURE_FOOD, food);
+
+    return true;
+}
+
+
+
+void SnakeGame::removeFood(unsigned int foodIndex)
+{
+    // Usually the snake that ate it is already on the cell, and that is left alone
+    board.clearFood(foodList[foodIndex]);
+    foodField.removeFood(foodList[foodIndex]);
+
+    // Move the last food into the gap so that removal is constant time
+    foodList[foodIndex] = foodList.back();
+    foodList.pop_back();
+    if (foodIndex < foodList.size() && board.getCell(foodList[foodIndex]).owner == OWNER_FOOD)
+    {
+        board.setFood(foodList[foodIndex], foodIndex);
+    }
+}
+
+
+
+void SnakeGame::setArenaSnakeCount(std::size_t snakeCount)
+{
+    arenaSnakeCount = snakeCount;
+}
+
+
+
+void SnakeGame::setAiMode(AiMode_t newAiMode)
+{
+    aiMode = newAiMode;
+}
+
+
+
+AiMode_t SnakeGame::getAiMode() const
+{
+    return aiMode;
+}
+
+
+
+void SnakeGame::setMctsConfig(const MctsConfig& config)
+{
+    assert(config.rollouts > 0 || config.thinkShare > 0.0);
+    assert(config.rolloutDepth > 0);
+
+    mctsConfig = config;
+
+    // Started again with the new threads on the next search
+    planner.reset();
+}
+
+
+
+void SnakeGame::setReplayWriter(ReplayWriter* writer)
+{
+    endReplay();
+    replayWriter = writer;
+}
+
+
+
+#ifdef SSNAKE_PROFILE
+void SnakeGame::setProfiler(TickProfiler* profiler)
+{
+    this->profiler = profiler;
+}
+
+
+
+void SnakeGame::showTimings(bool nextPage)
+{
+    // Pages go through every phase, the whole tick, the input latency and the tick jitter, then hide the timings again
+    if (nextPage)
+    {
+        shownPhase = static_cast<TickPhase_t>((shownPhase == PHASE_COUNT) ? 0 : shownPhase + 1);
+        if (shownPhase == PHASE_COUNT)
+        {
+            display->clearGameMessage();
+        }
+    }
+
+    // A few times a second is as fast as anyone can read it
+    if (shownPhase != PHASE_COUNT && (nextPage || stepCount % 8 == 0))
+    {
+        char text[32];
+        profiler->formatSummary(shownPhase, text, sizeof(text));
+        display->printGameMessage(text);
+    }
+}
+#endif
+
+
+
+void SnakeGame::setTickPacer(TickPacer* pacer)
+{
+    tickPacer = pacer;
+}
+
+
+
+void SnakeGame::endReplay()
+{
+    if (replayWriter == nullptr || !replayWriter->inGame())
+    {
+        return;
+    }
+
+    ReplayOutcome outcome;
+    outcome.steps = stepCount;
+    outcome.finalLength = getPlayerLength();
+    outcome.maxLength = maxLength;
+    outcome.cause = deathCause;
+    replayWriter->endGame(outcome);
+}
+
+
+
+bool SnakeGame::spawnPlayer(std::size_t player)
+{
+    assert(gameType == GM_MULTIPLAYER && getPlayerSnake(player) == nullptr);
+
+    Snake* snake = spawnArenaSnake(playerTextures);
+    if (snake == nullptr)
+    {
+        return false;
+    }
+
+    if (player >= players.size())
+    {
+        players.resize(player + 1, nullptr);
+    }
+    players[player] = snake;
+
+    std::size_t id = static_cast<std::size_t>(snake->getId());
+    if (id >= idPlayers.size())
+    {
+        idPlayers.resize(id + 1, -1);
+    }
+    idPlayers[id] = static_cast<int>(player);
+    ++playerCount;
+
+    return true;
+}
+
+
+
+void SnakeGame::removePlayer(std::size_t player)
+{
+    if (getPlayerSnake(player) == nullptr)
+    {
+        return;
+    }
+
+    for (std::list<Snake>::iterator it = snakeList.begin(); it != snakeList.end(); ++it)
+    {
+        if (&(*it) == players[player])
+        {
+            it->clearDisplay();
+            releasePlayer(static_cast<int>(player));
+            snakeList.erase(it);
+            return;
+        }
+    }
+}
+
+
+
+void SnakeGame::releasePlayer(int player)
+{
+    idPlayers[players[player]->getId()] = -1;
+    players[player] = nullptr;
+    --playerCount;
+}
+
+
+
+Snake* SnakeGame::spawnArenaSnake(const SnakeTextureList& textures)
+{
+    const int length = 3;
+
+    Vec2 head;
+    if (!board.pickFreeCell(rng, head))
+    {
+        return nullptr;
+    }
+
+    // Snakes face away from the closest side wall with their body behind them (see the Snake constructor),
+    // the body and a few cells in front of the head must be clear
+    int facing = (head.x < board.getSize_x() / 2) ? 1 : -1;
+    for (int i = -(length - 1); i <= length; ++i)
+    {
+        Vec2 cell = {head.x + facing * i, head.y};
+        if (cell.x < 1 || cell.x > board.getSize_x() - 2 || !board.isEmpty(cell))
+        {
+            return nullptr;
+        }
+    }
+
+    snakeList.emplace_back(display, &board, textures, head, length);
+
+    return &(snakeList.back());
+}
+
 }
\ No newline at end of file
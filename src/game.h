@@ -1,95 +1,415 @@
-
-// game.h
-// Game
-//
-
-#ifndef SLICERSNAKE_GAME_H
-#define SLICERSNAKE_GAME_H
-
-
-#include <chrono>
-#include <list>
-
-#include "display.h"
-#include "snake.h"
-#include "input.h"
-
-
-namespace ssnake
-{
-
-enum Game_t
-{
-    GM_SLICER, GM_CLASSIC, GM_NONE
-};
-
-
-
-class SnakeGame
-{
-
-public:
-
-    // PreConditions:
-    //   displayHandle points to an active display
-    // PostConditions:
-    //   A game becomes ready to be started using that display
-    explicit SnakeGame(Display* displayHandle);
-
-    // PreConditions:
-    // PostConditions:
-    //   Game speed is decreased the specified number of times (delay increases)
-    void decreaseGameSpeed(unsigned int numTimes = 1);
-
-    // PreConditions:
-    // PostConditions:
-    //   Game speed is increased the specified number of times (delay decreases)
-    void increaseGameSpeed(unsigned int numTimes = 1);
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns game delay in seconds
-    double getGameDelay() const;
-
-    // PreConditions:
-    // PostConditions:
-    //   Game delay is set to the specified number of seconds
-    void setGameDelay(double numSeconds);
-
-    // PreConditions:
-    // PostConditions:
-    //   Begins a new game of the specified type
-    void startGame(Game_t newGameType);
-
-    // PreConditions:
-    // PostConditions:
-    //   Spawns a food somewhere on the game field, but never on top of a snake or other food.
-    void spawnFood();
-
-
-
-private:
-
-    void runNewClassicGame();
-    void runNewSlicerGame();
-
-    void processInputs(std::chrono::steady_clock::time_point& beginTime, Snake* playerSnake);
-
-    Display* display;
-    PlayerInput input;
-
-    // delay of game loop steps in seconds
-    double gameDelay = 0.0;
-
-    // Snake list holds all snakes, including the player snake
-    std::list<Snake> snakeList;
-    std::list<Vec2> foodList;
-
-    bool alive = false;
-    Game_t gameType = GM_NONE;
-
-};
-
-}
-
-#endif
+// game.h
+// Game
+//
+
+#ifndef SLICERSNAKE_GAME_H
+#define SLICERSNAKE_GAME_H
+
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "board.h"
+#include "display.h"
+#include "food_field.h"
+#include "snake.h"
+#include "input.h"
+#include "pathfinder.h"
+#include "random.h"
+#include "tick_pacer.h"
+#include "tick_profiler.h"
+
+
+namespace ssnake
+{
+
+class MctsPlanner;
+class ReplayWriter;
+
+
+
+// GM_ARENA is slicer rules with many computer snakes that come back when they die, at a fixed speed
+// GM_MULTIPLAYER is an arena without a player of its own, for players that join and leave (see spawnPlayer),
+// it only ends when it is stopped
+enum Game_t
+{
+    GM_SLICER, GM_CLASSIC, GM_ARENA, GM_MULTIPLAYER, GM_NONE
+};
+
+
+
+// How computer snakes (and the player's snake on autopilot) choose where to go
+// AI_SIMPLE is the original wall avoiding and food grabbing AI, AI_PATHFINDING searches for paths to food,
+// AI_FOOD_FIELD follows a distance field to food that is shared by every snake,
+// AI_MCTS plays out the snake's next moves on copies of the game, see MctsPlanner
+enum AiMode_t
+{
+    AI_SIMPLE, AI_PATHFINDING, AI_FOOD_FIELD, AI_MCTS
+};
+
+
+
+// How hard AI_MCTS searches
+struct MctsConfig
+{
+    // Threads that search for each move, counting the game's own thread, 0 uses every hardware thread
+    unsigned int threadCount = 1;
+
+    // Playouts per move, shared between the threads, 0 for no limit
+    std::size_t rollouts = 256;
+
+    // Steps that each playout looks ahead
+    unsigned int rolloutDepth = 24;
+
+    // Share of the game delay that the searches of a step may take, counted from the start of the step.
+    // 0 searches without a time limit, which plays out the same every time for the same rollouts and threads
+    double thinkShare = 0.0;
+};
+
+
+
+// Why the player's game ended
+enum DeathCause_t
+{
+    DEATH_NONE, DEATH_WALL, DEATH_SELF, DEATH_EATEN, DEATH_QUIT
+};
+
+
+
+// Input of one player for a single game step
+struct PlayerAction
+{
+    // Most recent directional request, and the one before it (NONE if there wasn't one)
+    DirectionalKey_t direction = NONE;
+    DirectionalKey_t prevDirection = NONE;
+
+    // Player gives up, ending the game
+    bool quit = false;
+
+    // The game's AI steers the player's snake instead of the directions
+    bool autopilot = false;
+};
+
+
+
+// Outcome of a single game step
+struct StepResult
+{
+    // False once the game is over
+    bool alive = false;
+
+    std::size_t playerLength = 0;
+
+    // Food eaten by any snake, and snake pieces sliced off of any snake during the step
+    std::size_t foodEaten = 0;
+    std::size_t piecesSliced = 0;
+};
+
+
+
+// Everything needed to put a game back the way it was, see SnakeGame::snapshot.
+// Made of plain values and flat arrays, so taking a snapshot into an old one reuses its storage.
+struct GameSnapshot
+{
+    Random rng;
+    double gameDelay = 0.0;
+    Game_t gameType = GM_NONE;
+    bool alive = false;
+    DeathCause_t deathCause = DEATH_NONE;
+    std::size_t maxLength = 0;
+    unsigned long stepCount = 0;
+    std::size_t arenaSnakeTarget = 0;
+
+    // Position of the player's snake in snakes, -1 if there is no game.
+    // The players of multiplayer games are not kept, their snakes come back as computer snakes
+    int playerIndex = -1;
+
+    BoardState board;
+    // In the order of the game's snake list, with all of their bodies in bodies
+    std::vector<SnakeState> snakes;
+    std::vector<Vec2> bodies;
+    std::vector<Vec2> foodList;
+};
+
+
+
+class SnakeGame
+{
+
+public:
+
+    // PreConditions:
+    //   displayHandle points to an active display
+    // PostConditions:
+    //   A game becomes ready to be started using that display
+    explicit SnakeGame(Display* displayHandle);
+
+    // PreConditions:
+    // PostConditions:
+    //   A game that is still being recorded is ended in its replay
+    ~SnakeGame();
+
+    // PreConditions:
+    // PostConditions:
+    //   Game speed is decreased the specified number of times (delay increases)
+    void decreaseGameSpeed(unsigned int numTimes = 1);
+
+    // PreConditions:
+    // PostConditions:
+    //   Game speed is increased the specified number of times (delay decreases)
+    void increaseGameSpeed(unsigned int numTimes = 1);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns game delay in seconds
+    double getGameDelay() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Game delay is set to the specified number of seconds
+    void setGameDelay(double numSeconds);
+
+    // Steps are never paced closer together than this many seconds, however low (or negative) the game delay gets
+    static constexpr double minGameDelay = 0.02;
+
+    // PreConditions:
+    //   input is the player's input, curses is initialized
+    // PostConditions:
+    //   Plays a new game of the specified type in real time, returning when it is over
+    //   Steps are paced with the pacer of setTickPacer, or with a TickPacer of minGameDelay if there is none
+    void startGame(Game_t newGameType, std::uint64_t seed, PlayerInput& input);
+
+    // PreConditions:
+    // PostConditions:
+    //   A new game of the specified type is set up, ready to be advanced with step
+    //   Games with the same type, seed and actions always play out the same way
+    void newGame(Game_t newGameType, std::uint64_t seed);
+
+    // PreConditions:
+    //   A game was set up with newGame
+    //   actions holds the input of each player in order, missing players have no input
+    //   The player of a multiplayer game with index i is steered by actions[i]
+    // PostConditions:
+    //   The game is advanced by exactly one step, independent of wall-clock time
+    //   Returns the outcome of the step
+    //   Does nothing once the game is over
+    StepResult step(const std::vector<PlayerAction>& actions);
+
+    // PreConditions:
+    // PostConditions:
+    //   snapshot holds the whole state of the current game
+    //   Once snapshot has been used a few times, taking another one doesn't allocate
+    void snapshot(GameSnapshot& snapshot) const;
+
+    // PreConditions:
+    //   snapshot was taken from a game with the same board size
+    // PostConditions:
+    //   The game is exactly as it was when snapshot was taken, and plays out the same from there
+    //   The display is not redrawn, so restoring is meant for headless games
+    void restore(const GameSnapshot& snapshot);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true while the current game is not over
+    bool isAlive() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of steps taken in the current game
+    unsigned long getStepCount() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the current length of the player's snake
+    std::size_t getPlayerLength() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the longest the player's snake has been in the current game
+    std::size_t getMaxLength() const;
+
+    // PreConditions:
+    //   A multiplayer game was set up with newGame, and player has no snake
+    // PostConditions:
+    //   Returns true and puts a new snake for player at a random clear spot,
+    //   or returns false if the spot wasn't clear, so that it can be tried again on a later step
+    //   The snake is taken out of the game when it dies, or when its player quits
+    bool spawnPlayer(std::size_t player);
+
+    // PreConditions:
+    // PostConditions:
+    //   The snake of player is taken out of the multiplayer game, if it has one
+    void removePlayer(std::size_t player);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the snake of player in the multiplayer game, or nullptr if it has none
+    const Snake* getPlayerSnake(std::size_t player) const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns why the current game ended, or DEATH_NONE if it is not over
+    DeathCause_t getDeathCause() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Arena games started after this have snakeCount computer snakes, 0 picks a count from the board size
+    void setArenaSnakeCount(std::size_t snakeCount);
+
+    // PreConditions:
+    // PostConditions:
+    //   Computer snakes use newAiMode from now on
+    void setAiMode(AiMode_t newAiMode);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the AI mode of the computer snakes
+    AiMode_t getAiMode() const;
+
+    // PreConditions:
+    //   config.rollouts or config.thinkShare is not 0, config.rolloutDepth is not 0
+    // PostConditions:
+    //   AI_MCTS searches with config from now on
+    void setMctsConfig(const MctsConfig& config);
+
+    // PreConditions:
+    //   writer is open, and stays valid until it is replaced or the game is destroyed
+    // PostConditions:
+    //   Games started after this are recorded with writer, nullptr stops recording
+    void setReplayWriter(ReplayWriter* writer);
+
+    // PreConditions:
+    //   pacer stays valid until it is replaced or the game is destroyed
+    // PostConditions:
+    //   Games started after this are paced with pacer, which keeps their tick statistics, nullptr uses a pacer of the game's own
+    void setTickPacer(TickPacer* pacer);
+
+#ifdef SSNAKE_PROFILE
+    // PreConditions:
+    //   profiler stays valid until it is replaced or the game is destroyed
+    // PostConditions:
+    //   The phases of every tick of startGame are timed with profiler, nullptr stops timing
+    void setProfiler(TickProfiler* profiler);
+#endif
+
+    // PreConditions:
+    // PostConditions:
+    //   Spawns a food somewhere on the game field, but never on top of a snake or other food.
+    //   Returns false without spawning anything if the game field is full
+    bool spawnFood();
+
+
+
+private:
+
+    void initClassicGame();
+    void initSlicerGame();
+    void initArenaGame();
+    void initMultiplayerGame();
+
+    // Adds the computer snakes and food of an arena or multiplayer game
+    void fillArena();
+
+    // Returns the number of snakes that are not steered by a player
+    std::size_t getComputerSnakeCount() const;
+
+    // Returns the multiplayer player that steers snake, or -1 if it is not a player's snake
+    int getPlayerIndex(const Snake* snake) const;
+
+    void stepClassicGame(StepResult& result);
+    // Steps both slicer and arena games
+    void stepSlicerGame(StepResult& result);
+
+    // Tries to add a snake with textures at a random clear spot, returns nullptr if the spot wasn't clear
+    Snake* spawnArenaSnake(const SnakeTextureList& textures);
+
+    // Forgets the snake of player, which is about to be taken out of the game
+    void releasePlayer(int player);
+
+    // Removes the food at foodIndex of foodList
+    void removeFood(unsigned int foodIndex);
+
+    void applyAction(Snake* snake, const PlayerAction& action);
+
+    // Sets the direction of a computer controlled snake with the AI of the current mode
+    void steerComputerSnake(Snake* snake);
+
+    // Sets the direction of snake with a tree search of the game as it is now,
+    // returns false without changing it if the search had no time to finish a playout
+    bool searchDirection(Snake* snake);
+
+    // Ends the game if the player's snake had a lethal collision
+    void checkPlayerCollision();
+
+    // Writes the outcome of the game being recorded, if there is one
+    void endReplay();
+
+#ifdef SSNAKE_PROFILE
+    // Goes on to the next page of timings if nextPage, and shows the timings of the page on the game message line
+    void showTimings(bool nextPage);
+#endif
+
+    Display* display;
+
+    // Every random choice of the game and its snakes comes from here
+    Random rng;
+
+    // delay of game loop steps in seconds
+    double gameDelay = 0.0;
+
+    // Occupancy of the game area, must outlive the snakes that are registered with it
+    Board board;
+
+    // Snake list holds all snakes, including the player snake
+    std::list<Snake> snakeList;
+    // Food cells on the board hold their index in foodList
+    std::vector<Vec2> foodList;
+
+    // Number of computer snakes asked for, and the number kept alive in the current arena game
+    std::size_t arenaSnakeCount = 0;
+    std::size_t arenaSnakeTarget = 0;
+
+    AiMode_t aiMode = AI_SIMPLE;
+    // Search buffers for AI_PATHFINDING, shared by every snake
+    Pathfinder pathfinder;
+    // Distances to food for AI_FOOD_FIELD, kept up to date as food comes and goes
+    FoodField foodField;
+
+    MctsConfig mctsConfig;
+    // Started the first time a snake searches, since its threads and game copies aren't needed otherwise
+    std::unique_ptr<MctsPlanner> planner;
+    // The game as it was when a snake started searching
+    GameSnapshot searchRoot;
+    // Time that the searches of the current step have to be done by, and how many of them are still to come
+    std::chrono::steady_clock::time_point thinkEnd;
+    std::size_t searchesLeft = 0;
+
+    ReplayWriter* replayWriter = nullptr;
+    TickPacer* tickPacer = nullptr;
+
+#ifdef SSNAKE_PROFILE
+    TickProfiler* profiler = nullptr;
+    // Phase shown on the game message line, PHASE_COUNT when the timings are hidden
+    TickPhase_t shownPhase = PHASE_COUNT;
+#endif
+
+    Snake* playerSnake = nullptr;
+    // Snakes of the players of a multiplayer game, nullptr for players without one,
+    // and the player of every board owner id, -1 for snakes without one
+    std::vector<Snake*> players;
+    std::vector<int> idPlayers;
+    std::size_t playerCount = 0;
+    std::size_t maxLength = 0;
+    unsigned long stepCount = 0;
+
+    bool alive = false;
+    DeathCause_t deathCause = DEATH_NONE;
+    Game_t gameType = GM_NONE;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,672 @@
+
+#include "game_client.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio> // snprintf
+#include <cstring> // strerror
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "display.h"
+#include "display_curses.h"
+#include "display_delta.h"
+#include "input.h"
+#include "net.h"
+#include "random.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// What a MSG_PLAYER tells about the player
+struct PlayerState
+{
+    bool hasSnake;
+    std::uint64_t length;
+    Vec2 head;
+    std::uint64_t players;
+};
+
+
+
+// Reads what the socket has into the end of buffer, returns false if the connection was closed or failed
+bool receive(int fd, std::vector<std::uint8_t>& buffer, std::uint64_t& received)
+{
+    const std::size_t chunk = 64 * 1024;
+    std::size_t oldSize = buffer.size();
+    buffer.resize(oldSize + chunk);
+
+    ssize_t got;
+    do
+    {
+        got = recv(fd, buffer.data() + oldSize, chunk, 0);
+    } while (got < 0 && errno == EINTR);
+
+    buffer.resize(oldSize + ((got > 0) ? static_cast<std::size_t>(got) : 0));
+    if (got > 0)
+    {
+        received += static_cast<std::uint64_t>(got);
+        return true;
+    }
+    return got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+
+
+bool sendMessage(int fd, std::uint8_t message)
+{
+    ssize_t sent;
+    do
+    {
+        sent = send(fd, &message, 1, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    return sent == 1;
+}
+
+
+
+bool readWelcome(const std::uint8_t* payload, std::size_t size, coordType& size_x, coordType& size_y)
+{
+    const std::uint8_t* end = payload + size;
+    std::uint64_t player;
+    return getNumber(payload, end, player) && getCoord(payload, end, size_x) && getCoord(payload, end, size_y);
+}
+
+
+
+bool readPlayer(const std::uint8_t* payload, std::size_t size, PlayerState& state)
+{
+    const std::uint8_t* end = payload + size;
+    if (payload == end)
+    {
+        return false;
+    }
+
+    state.hasSnake = *payload++ != 0;
+    return getNumber(payload, end, state.length) && getCoord(payload, end, state.head.x)
+           && getCoord(payload, end, state.head.y) && getNumber(payload, end, state.players);
+}
+
+
+
+// Reads up to a chunk of the file into the end of buffer, returns the bytes read, 0 at the end of the file or -1 if it failed
+ssize_t readChunk(int fd, std::vector<std::uint8_t>& buffer)
+{
+    const std::size_t chunk = 64 * 1024;
+    std::size_t oldSize = buffer.size();
+    buffer.resize(oldSize + chunk);
+
+    ssize_t got;
+    do
+    {
+        got = read(fd, buffer.data() + oldSize, chunk);
+    } while (got < 0 && errno == EINTR);
+
+    buffer.resize(oldSize + ((got > 0) ? static_cast<std::size_t>(got) : 0));
+    return got;
+}
+
+
+
+// Waits until deadline while reading keys, a little at a time so that quitting doesn't wait for a far off deadline.
+// Returns true if the player quit.
+bool waitForQuit(PlayerInput& input, std::chrono::steady_clock::time_point deadline)
+{
+    const std::chrono::milliseconds slice(100);
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    do
+    {
+        input.startCollecting();
+        input.waitUntil((deadline - now > slice) ? now + slice : deadline);
+        if (input.getQuit())
+        {
+            return true;
+        }
+        now = std::chrono::steady_clock::now();
+    } while (now < deadline);
+
+    return false;
+}
+
+
+
+// Moves the messages before consumed out of buffer
+void consume(std::vector<std::uint8_t>& buffer, const std::uint8_t* consumed)
+{
+    buffer.erase(buffer.begin(), buffer.begin() + (consumed - buffer.data()));
+}
+
+
+
+// A connection of runBots
+struct Bot
+{
+    int fd = -1;
+    std::vector<std::uint8_t> buffer;
+    std::uint64_t steps = 0;
+    bool welcomed = false;
+    bool spawning = false;
+};
+
+}
+
+
+
+bool playOnline(const std::string& address, std::string& error)
+{
+    int fd;
+    if (!connectSocket(address, fd, error))
+    {
+        return false;
+    }
+
+    // The server's display size is needed before the display can be created
+    std::vector<std::uint8_t> buffer;
+    std::uint64_t received = 0;
+    coordType size_x = 0;
+    coordType size_y = 0;
+    bool welcomed = false;
+    while (!welcomed)
+    {
+        if (!receive(fd, buffer, received))
+        {
+            error = "The server closed the connection";
+            close(fd);
+            return false;
+        }
+
+        std::uint8_t type;
+        const std::uint8_t* payload;
+        std::size_t payloadSize;
+        std::size_t size;
+        if (parseMessage(buffer.data(), buffer.data() + buffer.size(), type, payload, payloadSize, size))
+        {
+            if (type != MSG_WELCOME || !readWelcome(payload, payloadSize, size_x, size_y))
+            {
+                error = "The server sent something that isn't a game";
+                close(fd);
+                return false;
+            }
+            consume(buffer, buffer.data() + size);
+            welcomed = true;
+        }
+    }
+
+    // The same as the interactive game, larger boards scroll but the game message has to fit
+    if (size_x < 27 || size_y < 20)
+    {
+        error = "The server's game is too small to show";
+        close(fd);
+        return false;
+    }
+
+    bool connected = true;
+    {
+        CursesDisplay display(size_x, size_y);
+        // Made again for every snake, so that the first key of a snake counts even if it was the last key of the one before
+        std::unique_ptr<PlayerInput> input(new PlayerInput);
+
+        display.clearScreen();
+
+        bool hasSnake = false;
+        DirectionalKey_t sentDirection = NONE;
+        std::size_t maxLength = 0;
+        std::string shownMessage;
+        bool redrawText = true;
+
+        struct pollfd waits[2];
+        waits[0].fd = STDIN_FILENO;
+        waits[0].events = POLLIN;
+        waits[1].fd = fd;
+        waits[1].events = POLLIN;
+
+        bool playing = true;
+        while (playing)
+        {
+            if (poll(waits, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                error = std::strerror(errno);
+                connected = false;
+                break;
+            }
+
+            if ((waits[0].revents & POLLIN) != 0)
+            {
+                input->updateInputs();
+
+                if (input->getQuit())
+                {
+                    sendMessage(fd, MSG_QUIT);
+                    break;
+                }
+
+                if (hasSnake)
+                {
+                    // Both of the turns since the last update are sent, so that quick turns work like in the game
+                    DirectionalKey_t prevDirection = input->getPrevDirection();
+                    DirectionalKey_t direction = input->getDirection();
+                    if (prevDirection != NONE && prevDirection != sentDirection && prevDirection != direction)
+                    {
+                        sendMessage(fd, static_cast<std::uint8_t>(prevDirection));
+                        sentDirection = prevDirection;
+                    }
+                    if (direction != NONE && direction != sentDirection)
+                    {
+                        sendMessage(fd, static_cast<std::uint8_t>(direction));
+                        sentDirection = direction;
+                    }
+                }
+                else if (input->getEnter() || input->getRestart())
+                {
+                    sendMessage(fd, MSG_SPAWN);
+                    input.reset(new PlayerInput);
+                    sentDirection = NONE;
+                }
+            }
+            // A closed terminal stays readable forever, so stop waiting on it
+            else if (waits[0].revents != 0)
+            {
+                waits[0].fd = -1;
+            }
+
+            if (waits[1].revents == 0)
+            {
+                continue;
+            }
+            if (!receive(fd, buffer, received))
+            {
+                error = "The server closed the connection";
+                connected = false;
+                break;
+            }
+
+            const std::uint8_t* data = buffer.data();
+            const std::uint8_t* end = data + buffer.size();
+            std::uint8_t type;
+            const std::uint8_t* payload;
+            std::size_t payloadSize;
+            std::size_t size;
+            while (playing && parseMessage(data, end, type, payload, payloadSize, size))
+            {
+                data += size;
+
+                const std::uint8_t* payloadEnd = payload + payloadSize;
+                PlayerState state;
+                std::uint64_t frame;
+                std::uint64_t delay;
+                bool understood = true;
+                switch (type)
+                {
+                    case (MSG_KEYFRAME) :
+                        understood = readFrameHeader(payload, payloadEnd, frame, delay) &&
+                                     playKeyframe(display, payload, payloadEnd);
+                        redrawText = true;
+                        break;
+
+                    case (MSG_DELTA) :
+                        understood = readFrameHeader(payload, payloadEnd, frame, delay) &&
+                                     playDelta(display, payload, payloadEnd);
+                        break;
+
+                    case (MSG_PLAYER) :
+                        understood = readPlayer(payload, payloadSize, state);
+                        if (!understood)
+                        {
+                            break;
+                        }
+
+                        hasSnake = state.hasSnake;
+                        if (hasSnake)
+                        {
+                            display.updateLengthCounter(state.length);
+                            display.keepInView(state.head);
+                        }
+                        if (state.length > maxLength || redrawText)
+                        {
+                            if (state.length > maxLength)
+                            {
+                                maxLength = state.length;
+                            }
+                            display.updateMaxLengthCounter(maxLength);
+                        }
+
+                        char message[48];
+                        if (hasSnake)
+                        {
+                            std::snprintf(message, sizeof(message), "Players: %llu", static_cast<unsigned long long>(state.players));
+                        }
+                        else
+                        {
+                            std::snprintf(message, sizeof(message), "Enter: Respawn");
+                        }
+                        if (redrawText || shownMessage != message)
+                        {
+                            display.printGameMessage(message);
+                            shownMessage = message;
+                            redrawText = false;
+                        }
+
+                        display.update();
+                        break;
+
+                    default:
+                        understood = false;
+                        break;
+                }
+
+                if (!understood)
+                {
+                    error = "The server sent something that isn't understood";
+                    connected = false;
+                    playing = false;
+                }
+            }
+            consume(buffer, data);
+        }
+    }
+
+    close(fd);
+    return connected;
+}
+
+
+
+bool runBots(const std::string& address, std::size_t botCount, std::uint64_t steps, std::uint64_t seed,
+             BotStats& stats, std::string& error)
+{
+    std::vector<Bot> bots(botCount);
+    std::vector<struct pollfd> waits(botCount);
+
+    // Connected all at once, since the server only greets them when it steps
+    bool connected = true;
+    for (std::size_t i = 0; i < botCount && connected; ++i)
+    {
+        connected = connectSocket(address, bots[i].fd, error);
+        waits[i].fd = bots[i].fd;
+        waits[i].events = POLLIN;
+    }
+
+    Random rng(seed);
+    stats = BotStats();
+    stats.bots = botCount;
+
+    std::size_t running = connected ? botCount : 0;
+    bool understood = true;
+    while (running > 0 && understood)
+    {
+        if (poll(waits.data(), waits.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            error = std::strerror(errno);
+            connected = false;
+            break;
+        }
+
+        for (std::size_t i = 0; i < botCount && understood; ++i)
+        {
+            if (waits[i].fd < 0 || waits[i].revents == 0)
+            {
+                continue;
+            }
+
+            Bot& bot = bots[i];
+            bool open = receive(bot.fd, bot.buffer, stats.bytesReceived);
+
+            const std::uint8_t* data = bot.buffer.data();
+            const std::uint8_t* end = data + bot.buffer.size();
+            std::uint8_t type;
+            const std::uint8_t* payload;
+            std::size_t payloadSize;
+            std::size_t size;
+            while (open && parseMessage(data, end, type, payload, payloadSize, size))
+            {
+                data += size;
+
+                // The rest of the messages are only counted, drawing them is up to real players
+                PlayerState state;
+                if (!bot.welcomed)
+                {
+                    understood = type == MSG_WELCOME;
+                    bot.welcomed = true;
+                }
+                else if (type == MSG_KEYFRAME)
+                {
+                    ++stats.keyframes;
+                }
+                else if (type == MSG_PLAYER)
+                {
+                    understood = readPlayer(payload, payloadSize, state);
+                    ++bot.steps;
+                    ++stats.steps;
+
+                    if (steps != 0 && bot.steps >= steps)
+                    {
+                        sendMessage(bot.fd, MSG_QUIT);
+                        open = false;
+                    }
+                    else if (!state.hasSnake && !bot.spawning)
+                    {
+                        open = sendMessage(bot.fd, MSG_SPAWN);
+                        bot.spawning = true;
+                        ++stats.respawns;
+                    }
+                    else if (state.hasSnake)
+                    {
+                        bot.spawning = false;
+                        // Turns every eighth step or so, which keeps a snake alive for a while on an open board
+                        if (rng.below(8) == 0)
+                        {
+                            open = sendMessage(bot.fd, static_cast<std::uint8_t>(rng.below(4)));
+                        }
+                    }
+                }
+                else
+                {
+                    understood = type == MSG_DELTA;
+                }
+            }
+            consume(bot.buffer, data);
+
+            if (!open || !understood)
+            {
+                close(bot.fd);
+                bot.fd = -1;
+                waits[i].fd = -1;
+                --running;
+            }
+        }
+    }
+
+    if (!understood)
+    {
+        error = "The server sent something that isn't understood";
+    }
+
+    for (std::size_t i = 0; i < botCount; ++i)
+    {
+        if (bots[i].fd >= 0)
+        {
+            close(bots[i].fd);
+        }
+    }
+
+    return connected && understood;
+}
+
+
+
+bool watchStream(const std::string& path, bool live, std::string& error)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        error = "Couldn't open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // All of the file so far, so that a live watch can start at its last keyframe
+    std::vector<std::uint8_t> buffer;
+    ssize_t got;
+    while ((got = readChunk(fd, buffer)) > 0)
+    {
+    }
+    if (got < 0)
+    {
+        error = "Couldn't read " + path + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    const std::uint8_t* end = buffer.data() + buffer.size();
+    std::uint8_t type;
+    const std::uint8_t* payload;
+    std::size_t payloadSize;
+    std::size_t size;
+    coordType size_x = 0;
+    coordType size_y = 0;
+    if (!parseMessage(buffer.data(), end, type, payload, payloadSize, size) ||
+        type != MSG_WELCOME || !readWelcome(payload, payloadSize, size_x, size_y))
+    {
+        error = path + " isn't a game stream";
+        close(fd);
+        return false;
+    }
+    if (size_x < 27 || size_y < 20)
+    {
+        error = "The stream's game is too small to show";
+        close(fd);
+        return false;
+    }
+
+    // Messages before at were played
+    std::size_t at = size;
+    if (live)
+    {
+        std::size_t next = at;
+        while (parseMessage(buffer.data() + next, end, type, payload, payloadSize, size))
+        {
+            if (type == MSG_KEYFRAME)
+            {
+                at = next;
+            }
+            next += size;
+        }
+    }
+
+    bool understood = true;
+    bool failed = false;
+    {
+        CursesDisplay display(size_x, size_y);
+        PlayerInput input;
+
+        display.clearScreen();
+
+        // When the last frame was played, or should have been
+        std::chrono::steady_clock::time_point frameTime;
+        bool playing = false;
+
+        while (true)
+        {
+            if (!parseMessage(buffer.data() + at, buffer.data() + buffer.size(), type, payload, payloadSize, size))
+            {
+                consume(buffer, buffer.data() + at);
+                at = 0;
+
+                got = readChunk(fd, buffer);
+                if (got < 0)
+                {
+                    error = "Couldn't read " + path + ": " + std::strerror(errno);
+                    failed = true;
+                    break;
+                }
+
+                // Caught up with whatever writes the stream, so wait for it to write more
+                if (got == 0)
+                {
+                    if (waitForQuit(input, std::chrono::steady_clock::now() + std::chrono::milliseconds(50)))
+                    {
+                        break;
+                    }
+                    playing = false;
+                }
+                continue;
+            }
+            at += size;
+
+            const std::uint8_t* payloadEnd = payload + payloadSize;
+            std::uint64_t frame;
+            std::uint64_t delay;
+            if ((type != MSG_KEYFRAME && type != MSG_DELTA) || !readFrameHeader(payload, payloadEnd, frame, delay))
+            {
+                understood = false;
+                break;
+            }
+
+            // Recordings play at the speed they were made, live streams as their frames are written
+            if (!playing)
+            {
+                frameTime = std::chrono::steady_clock::now();
+                playing = true;
+            }
+            else if (!live)
+            {
+                frameTime += std::chrono::microseconds(delay);
+                if (waitForQuit(input, frameTime))
+                {
+                    break;
+                }
+            }
+
+            if (type == MSG_KEYFRAME)
+            {
+                understood = playKeyframe(display, payload, payloadEnd);
+                display.printGameMessage("Q: Quit");
+            }
+            else
+            {
+                understood = playDelta(display, payload, payloadEnd);
+            }
+            if (!understood)
+            {
+                break;
+            }
+            display.update();
+
+            input.updateInputs();
+            if (input.getQuit())
+            {
+                break;
+            }
+        }
+    }
+
+    if (!understood)
+    {
+        error = path + " has something in it that isn't understood";
+    }
+
+    close(fd);
+    return understood && !failed;
+}
+
+}
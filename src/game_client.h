@@ -0,0 +1,58 @@
+
+// game_client.h
+// Plays multiplayer games on a GameServer, and watches games that were streamed to a file
+//
+
+#ifndef SLICERSNAKE_GAME_CLIENT_H
+#define SLICERSNAKE_GAME_CLIENT_H
+
+
+#include <cstdint>
+#include <string>
+
+
+namespace ssnake
+{
+
+// What the bots of runBots got from the server
+struct BotStats
+{
+    std::size_t bots = 0;
+    // Steps each bot got, added up
+    std::uint64_t steps = 0;
+    std::uint64_t bytesReceived = 0;
+    std::uint64_t keyframes = 0;
+    std::uint64_t respawns = 0;
+};
+
+
+
+// PreConditions:
+//   curses isn't started
+// PostConditions:
+//   Connects to the server at address and shows its game in the terminal, sending the player's turns,
+//   until the player quits or the server closes the connection
+//   Returns false with error set if it couldn't connect, the server went away or sent something that isn't understood
+bool playOnline(const std::string& address, std::string& error);
+
+// PreConditions:
+//   botCount is at least 1
+// PostConditions:
+//   Connects botCount players to the server at address that turn at random and respawn when they die,
+//   until each of them got steps steps (0 for until the server closes the connections)
+//   Returns false with error set if a bot couldn't connect or the server sent something that isn't understood
+bool runBots(const std::string& address, std::size_t botCount, std::uint64_t steps, std::uint64_t seed,
+             BotStats& stats, std::string& error);
+
+// PreConditions:
+//   curses isn't started
+// PostConditions:
+//   Shows the game of a stream written by DeltaDisplay::openStream in the terminal, from the start of the file at the
+//   speed it was recorded, or from its last keyframe as frames are written if live, and keeps following the file
+//   as it grows until the player quits
+//   Returns false with error set if the file couldn't be read or has something in it that isn't understood
+bool watchStream(const std::string& path, bool live, std::string& error);
+
+}
+
+#endif
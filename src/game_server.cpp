@@ -0,0 +1,538 @@
+
+#include "game_server.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring> // strerror
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h> // TCP_NODELAY
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "display.h"
+#include "display_delta.h"
+#include "game.h"
+#include "net.h"
+#include "snake.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// Clients are told apart by the serial of their connection in the top half and their player in the bottom half
+const std::uint64_t listenerToken = ~std::uint64_t(0);
+const std::uint64_t timerToken = ~std::uint64_t(0) - 1;
+
+std::uint64_t clientToken(std::uint32_t serial, std::size_t player)
+{
+    return (static_cast<std::uint64_t>(serial) << 32) | static_cast<std::uint32_t>(player);
+}
+
+}
+
+
+
+GameServer::GameServer(const ServerConfig& config)
+    : config(config), display(config.size_x, config.size_y, nullptr), game(&display),
+      pacer(SnakeGame::minGameDelay, config.spinTime), stopping(false)
+{
+    game.setArenaSnakeCount(config.arenaSnakes);
+    game.setAiMode(config.aiMode);
+    game.setMctsConfig(config.mctsConfig);
+    game.newGame(GM_MULTIPLAYER, config.seed);
+}
+
+
+
+GameServer::~GameServer()
+{
+    for (std::size_t player = 0; player < clients.size(); ++player)
+    {
+        if (clients[player])
+        {
+            close(clients[player]->fd);
+        }
+    }
+
+    if (listener >= 0)
+    {
+        close(listener);
+
+        std::string path = getSocketPath(config.address);
+        if (!path.empty())
+        {
+            unlink(path.c_str());
+        }
+    }
+    if (epoll >= 0)
+    {
+        close(epoll);
+    }
+    if (timer >= 0)
+    {
+        close(timer);
+    }
+}
+
+
+
+bool GameServer::open(std::string& error)
+{
+    if (!config.streamPath.empty() && !display.openStream(config.streamPath.c_str(), config.streamKeyframeInterval))
+    {
+        error = "Couldn't create " + config.streamPath;
+        return false;
+    }
+
+    if (!listenSocket(config.address, listener, error))
+    {
+        return false;
+    }
+
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+    timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (epoll < 0 || timer < 0)
+    {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = listenerToken;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event) != 0)
+    {
+        error = std::strerror(errno);
+        return false;
+    }
+    event.data.u64 = timerToken;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &event) != 0)
+    {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+
+
+void GameServer::acceptClients()
+{
+    while (true)
+    {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // Nothing left to accept (or out of descriptors, then they are accepted once some are closed)
+            return;
+        }
+
+        if (clientCount >= config.maxClients)
+        {
+            close(fd);
+            ++stats.clientsRefused;
+            continue;
+        }
+
+        // Steps are sent as soon as they are ready, this fails harmlessly for Unix sockets
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        // Players that left free up their number for the next one
+        std::size_t player = 0;
+        while (player < clients.size() && clients[player])
+        {
+            ++player;
+        }
+        if (player == clients.size())
+        {
+            clients.emplace_back();
+        }
+
+        std::unique_ptr<Client> client(new Client);
+        client->fd = fd;
+        client->serial = nextSerial++;
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = clientToken(client->serial, player);
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            close(fd);
+            ++stats.clientsRefused;
+            continue;
+        }
+
+        std::size_t start = beginMessage(client->output, MSG_WELCOME);
+        putNumber(client->output, player);
+        putNumber(client->output, static_cast<std::uint64_t>(config.size_x));
+        putNumber(client->output, static_cast<std::uint64_t>(config.size_y));
+        endMessage(client->output, start);
+
+        clients[player] = std::move(client);
+        ++clientCount;
+        ++stats.clientsAccepted;
+    }
+}
+
+
+
+void GameServer::dropClient(std::size_t player)
+{
+    game.removePlayer(player);
+
+    epoll_ctl(epoll, EPOLL_CTL_DEL, clients[player]->fd, nullptr);
+    close(clients[player]->fd);
+    clients[player].reset();
+    --clientCount;
+}
+
+
+
+void GameServer::encodeChanges()
+{
+    changes.clear();
+    display.endFrame(changes);
+
+    // Anything drawn from here on, like the snake of a client that is dropped, goes out with the next step
+    keyframeEncoded = false;
+}
+
+
+
+void GameServer::encodeKeyframe()
+{
+    if (keyframeEncoded)
+    {
+        return;
+    }
+
+    keyframe.clear();
+    display.writeKeyframe(keyframe);
+
+    keyframeEncoded = true;
+}
+
+
+
+void GameServer::encodePlayer(std::size_t player, std::vector<std::uint8_t>& out) const
+{
+    const Snake* snake = game.getPlayerSnake(player);
+    Vec2 head = (snake != nullptr) ? snake->getHeadPosition() : Vec2{0, 0};
+
+    std::size_t start = beginMessage(out, MSG_PLAYER);
+    out.push_back((snake != nullptr) ? 1 : 0);
+    putNumber(out, (snake != nullptr) ? snake->getLength() : 0);
+    putNumber(out, static_cast<std::uint64_t>(head.x));
+    putNumber(out, static_cast<std::uint64_t>(head.y));
+    putNumber(out, clientCount);
+    endMessage(out, start);
+}
+
+
+
+std::size_t GameServer::getClientCount() const
+{
+    return clientCount;
+}
+
+
+
+const ServerStats& GameServer::getStats() const
+{
+    return stats;
+}
+
+
+
+unsigned long GameServer::getStepCount() const
+{
+    return game.getStepCount();
+}
+
+
+
+const TickStats& GameServer::getTickStats() const
+{
+    return pacer.getStats();
+}
+
+
+
+void GameServer::readClient(std::size_t player)
+{
+    Client& client = *clients[player];
+
+    // One read per wakeup, so that a client that sends a lot can't keep the others waiting
+    std::uint8_t buffer[256];
+    ssize_t got = recv(client.fd, buffer, sizeof(buffer), 0);
+    if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+    if (got <= 0)
+    {
+        dropClient(player);
+        return;
+    }
+
+    for (ssize_t i = 0; i < got; ++i)
+    {
+        std::uint8_t message = buffer[i];
+        if (message < NONE)
+        {
+            DirectionalKey_t key = static_cast<DirectionalKey_t>(message);
+            if (client.direction != key)
+            {
+                client.prevDirection = client.direction;
+                client.direction = key;
+            }
+        }
+        else if (message == MSG_SPAWN)
+        {
+            // Asking while still alive doesn't bring the next snake back right away
+            client.wantsSnake = game.getPlayerSnake(player) == nullptr;
+        }
+        else
+        {
+            // MSG_QUIT, or a client that doesn't speak the protocol
+            dropClient(player);
+            return;
+        }
+    }
+}
+
+
+
+bool GameServer::run()
+{
+    pacer.restart();
+    while (!stopping.load() && (config.maxSteps == 0 || game.getStepCount() < config.maxSteps))
+    {
+        pacer.schedule(game.getGameDelay());
+        if (!serveUntil(pacer.getWakeTime()))
+        {
+            return false;
+        }
+        if (stopping.load())
+        {
+            break;
+        }
+
+        pacer.startTick();
+        step();
+    }
+
+    return true;
+}
+
+
+
+bool GameServer::serveUntil(std::chrono::steady_clock::time_point deadline)
+{
+    // steady_clock is CLOCK_MONOTONIC on Linux, so the deadline can be handed to the timer as it is.
+    // A zero time would disarm the timer instead, and a deadline that passed fires right away.
+    std::int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    if (ns <= 0)
+    {
+        ns = 1;
+    }
+    struct itimerspec due = {};
+    due.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+    due.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+    if (timerfd_settime(timer, TFD_TIMER_ABSTIME, &due, nullptr) != 0)
+    {
+        return false;
+    }
+
+    epoll_event events[64];
+    while (!stopping.load())
+    {
+        int count = epoll_wait(epoll, events, 64, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        bool timeUp = false;
+        for (int i = 0; i < count; ++i)
+        {
+            std::uint64_t token = events[i].data.u64;
+            if (token == listenerToken)
+            {
+                acceptClients();
+                continue;
+            }
+            if (token == timerToken)
+            {
+                std::uint64_t expirations;
+                timeUp = read(timer, &expirations, sizeof(expirations)) == static_cast<ssize_t>(sizeof(expirations));
+                continue;
+            }
+
+            // The client may have been dropped earlier in this batch, and its player taken by someone new
+            std::size_t player = static_cast<std::uint32_t>(token);
+            std::uint32_t serial = static_cast<std::uint32_t>(token >> 32);
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0
+                && player < clients.size() && clients[player] && clients[player]->serial == serial)
+            {
+                readClient(player);
+            }
+            if ((events[i].events & EPOLLOUT) != 0
+                && player < clients.size() && clients[player] && clients[player]->serial == serial)
+            {
+                writeClient(player);
+            }
+        }
+
+        if (timeUp)
+        {
+            return true;
+        }
+    }
+
+    return true;
+}
+
+
+
+void GameServer::step()
+{
+    actions.assign(clients.size(), PlayerAction());
+    for (std::size_t player = 0; player < clients.size(); ++player)
+    {
+        Client* client = clients[player].get();
+        if (client == nullptr)
+        {
+            continue;
+        }
+
+        if (client->wantsSnake && game.getPlayerSnake(player) == nullptr && game.spawnPlayer(player))
+        {
+            client->wantsSnake = false;
+            client->direction = NONE;
+            client->prevDirection = NONE;
+        }
+
+        // Like PlayerInput, the direction is kept from step to step and the one before it is only kept for a step
+        actions[player].direction = client->direction;
+        actions[player].prevDirection = client->prevDirection;
+        client->prevDirection = client->direction;
+    }
+
+    game.step(actions);
+
+    encodeChanges();
+    for (std::size_t player = 0; player < clients.size(); ++player)
+    {
+        Client* client = clients[player].get();
+        if (client == nullptr)
+        {
+            continue;
+        }
+
+        if (client->output.size() - client->outputSent > config.maxBacklog)
+        {
+            client->needsKeyframe = true;
+            ++stats.stepsSkipped;
+            continue;
+        }
+
+        if (client->needsKeyframe)
+        {
+            encodeKeyframe();
+            client->output.insert(client->output.end(), keyframe.begin(), keyframe.end());
+            client->needsKeyframe = false;
+            ++stats.keyframesSent;
+        }
+        else
+        {
+            client->output.insert(client->output.end(), changes.begin(), changes.end());
+        }
+        encodePlayer(player, client->output);
+
+        writeClient(player);
+    }
+}
+
+
+
+void GameServer::stop()
+{
+    stopping.store(true);
+}
+
+
+
+void GameServer::writeClient(std::size_t player)
+{
+    Client& client = *clients[player];
+
+    while (client.outputSent < client.output.size())
+    {
+        ssize_t sent = send(client.fd, client.output.data() + client.outputSent,
+                            client.output.size() - client.outputSent, MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            client.outputSent += static_cast<std::size_t>(sent);
+            stats.bytesSent += static_cast<std::uint64_t>(sent);
+        }
+        else if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        else
+        {
+            dropClient(player);
+            return;
+        }
+    }
+
+    // Sent bytes are only moved out once they are half of the output, so that a slow client costs no more than copying
+    if (client.outputSent == client.output.size())
+    {
+        client.output.clear();
+        client.outputSent = 0;
+    }
+    else if (client.outputSent > client.output.size() / 2)
+    {
+        client.output.erase(client.output.begin(), client.output.begin() + client.outputSent);
+        client.outputSent = 0;
+    }
+
+    // Only waits for the socket to be writable while there is something to write
+    bool writing = !client.output.empty();
+    if (writing != client.writing)
+    {
+        epoll_event event = {};
+        event.events = EPOLLIN | (writing ? EPOLLOUT : 0);
+        event.data.u64 = clientToken(client.serial, player);
+        epoll_ctl(epoll, EPOLL_CTL_MOD, client.fd, &event);
+        client.writing = writing;
+    }
+}
+
+}
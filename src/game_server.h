@@ -0,0 +1,206 @@
+
+// game_server.h
+// Runs a multiplayer game for players that connect over a socket
+//
+
+#ifndef SLICERSNAKE_GAME_SERVER_H
+#define SLICERSNAKE_GAME_SERVER_H
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "display.h"
+#include "display_delta.h"
+#include "game.h"
+#include "input.h"
+#include "tick_pacer.h"
+
+
+namespace ssnake
+{
+
+struct ServerConfig
+{
+    // Where clients connect, see listenSocket
+    std::string address;
+
+    // Display size of the game (units of "snake chunks"), clients show the same game area
+    coordType size_x = 27;
+    coordType size_y = 30;
+
+    // Computer snakes in the arena, 0 lets the game pick from the board size
+    std::size_t arenaSnakes = 0;
+
+    AiMode_t aiMode = AI_SIMPLE;
+    MctsConfig mctsConfig;
+
+    std::uint64_t seed = 0;
+
+    // run returns after this many steps, 0 for no limit
+    unsigned long maxSteps = 0;
+
+    // Seconds spun before each step instead of sleeping, see TickPacer
+    double spinTime = 0.0;
+
+    // Connections past this many are closed right away
+    std::size_t maxClients = 1000;
+
+    // A client with more than this many bytes not sent yet skips steps, and gets a keyframe once it caught up
+    std::size_t maxBacklog = 256 * 1024;
+
+    // Every step is also written to this file for spectators, see DeltaDisplay::openStream, if it isn't empty
+    std::string streamPath;
+    unsigned int streamKeyframeInterval = 250;
+};
+
+
+
+struct ServerStats
+{
+    std::uint64_t clientsAccepted = 0;
+    std::uint64_t clientsRefused = 0;
+    std::uint64_t bytesSent = 0;
+    std::uint64_t keyframesSent = 0;
+    // Steps that clients didn't get because they were too far behind
+    std::uint64_t stepsSkipped = 0;
+};
+
+
+
+// Runs a GM_MULTIPLAYER game on one thread with an epoll loop.
+// Every connection is a player: it gets a snake when it connects and whenever it asks for one after dying,
+// and its turns are collected between steps the way PlayerInput collects keys.
+// The game draws into a DeltaDisplay, and after every step its events are encoded once and sent to
+// every client, followed by a short message of its own player (see net.h). Clients that just connected or
+// fell behind get a keyframe of the whole board instead.
+class GameServer
+{
+
+public:
+
+    // PreConditions:
+    //   config.size_x and config.size_y are large enough for a game
+    // PostConditions:
+    //   A server is created for a new game, not listening yet
+    explicit GameServer(const ServerConfig& config);
+
+    // PreConditions:
+    // PostConditions:
+    //   Every connection is closed, and the file of a Unix socket is removed
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true once the server listens on its address and its stream is created,
+    //   or false with error set to why it couldn't
+    bool open(std::string& error);
+
+    // PreConditions:
+    //   open succeeded
+    // PostConditions:
+    //   Steps the game at its speed while serving clients, until stop is called or maxSteps steps were taken
+    //   Returns false if waiting for clients failed
+    bool run();
+
+    // PreConditions:
+    //   open succeeded
+    // PostConditions:
+    //   Clients are accepted, read from and written to as they are ready, until deadline or until stop is called
+    //   Returns false if waiting for clients failed
+    bool serveUntil(std::chrono::steady_clock::time_point deadline);
+
+    // PreConditions:
+    //   open succeeded
+    // PostConditions:
+    //   The game is stepped once with the turns collected since the last step, and every client is sent the changes
+    void step();
+
+    // PreConditions:
+    // PostConditions:
+    //   run and serveUntil return as soon as they can, safe to call from a signal handler
+    void stop();
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of connected clients
+    std::size_t getClientCount() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of steps the game took
+    unsigned long getStepCount() const;
+
+    const ServerStats& getStats() const;
+    const TickStats& getTickStats() const;
+
+
+private:
+
+    struct Client
+    {
+        int fd = -1;
+        // Tells events of a connection apart from those of an earlier one of the same player
+        std::uint32_t serial = 0;
+
+        // Bytes not sent yet start at output[outputSent]
+        std::vector<std::uint8_t> output;
+        std::size_t outputSent = 0;
+        // Waiting for the socket to be writable
+        bool writing = false;
+
+        DirectionalKey_t direction = NONE;
+        DirectionalKey_t prevDirection = NONE;
+        bool wantsSnake = true;
+        bool needsKeyframe = true;
+    };
+
+    void acceptClients();
+    void readClient(std::size_t player);
+    // Sends as much of the client's output as the socket takes
+    void writeClient(std::size_t player);
+    void dropClient(std::size_t player);
+
+    // Encodes the events of the step, and a keyframe once a client needs one
+    void encodeChanges();
+    void encodeKeyframe();
+    void encodePlayer(std::size_t player, std::vector<std::uint8_t>& out) const;
+
+    ServerConfig config;
+
+    DeltaDisplay display;
+    SnakeGame game;
+    TickPacer pacer;
+
+    int listener = -1;
+    int epoll = -1;
+    // timerfd that fires at the deadline of serveUntil
+    int timer = -1;
+
+    // Indexed by player, nullptr where no one is connected
+    std::vector<std::unique_ptr<Client>> clients;
+    std::size_t clientCount = 0;
+    std::uint32_t nextSerial = 1;
+
+    std::vector<PlayerAction> actions;
+
+    // Messages shared by every client, encoded once per step
+    std::vector<std::uint8_t> changes;
+    std::vector<std::uint8_t> keyframe;
+    bool keyframeEncoded = false;
+
+    std::atomic<bool> stopping;
+
+    ServerStats stats;
+};
+
+}
+
+#endif
@@ -1,191 +1,393 @@
-
-#include "input.h"
-
-#ifdef _WIN32
-    #include "curses.h" // pdcurses for windows
-#else
-    #include <ncurses.h> // ncurses for linux (and whatever else it happens to work on)
-#endif
-
-namespace ssnake
-{
-
-PlayerInput::PlayerInput()
-{
-    initCurses();
-}
-
-
-
-void PlayerInput::clearInputs()
-{
-    pause = restart = quit = enter = false;
-}
-
-
-
-void PlayerInput::getInput(bool once)
-{
-    int input;
-    do
-    {
-        input = getch();
-
-        switch (input)
-        {
-            case (KEY_LEFT) :
-            case ('a') :
-            case ('A') :
-                if (direction != LEFT_KEY)
-                {
-                    prevDirection = direction;
-                    direction = LEFT_KEY;
-                }
-                break;
-
-            case (KEY_RIGHT) :
-            case ('d') :
-            case ('D') :
-                if (direction != RIGHT_KEY)
-                {
-                    prevDirection = direction;
-                    direction = RIGHT_KEY;
-                }
-                break;
-
-            case (KEY_UP) :
-            case ('w') :
-            case ('W') :
-                if (direction != UP_KEY)
-                {
-                    prevDirection = direction;
-                    direction = UP_KEY;
-                }
-                break;
-
-            case (KEY_DOWN) :
-            case ('s') :
-            case ('S') :
-                if (direction != DOWN_KEY)
-                {
-                    prevDirection = direction;
-                    direction = DOWN_KEY;
-                }
-                break;
-
-            case ('q') :
-            case ('Q') :
-            case (KEY_EXIT) :
-            case (KEY_END) :
-                quit = true;
-                break;
-
-            case (KEY_ENTER) :
-            case ('\n') :
-            case ('\r') :
-                enter = true;
-                pause = true;
-                break;
-
-            case ('r') :
-            case ('R') :
-            case (KEY_RESTART) :
-                restart = true;
-
-            default:
-                break;
-        }
-
-    } while (!once && input != ERR);
-}
-
-
-
-void PlayerInput::updateInputs()
-{
-    clearInputs();
-
-    prevDirection = direction;
-
-    getInput(false);
-}
-
-
-
-void PlayerInput::collectInput()
-{
-    clearInputs();
-
-    prevDirection = direction;
-
-    nodelay(stdscr, FALSE);
-    getInput(true);
-    nodelay(stdscr, TRUE);
-
-    getInput(false);
-}
-
-
-
-DirectionalKey_t PlayerInput::getDirection() const
-{
-    return direction;
-}
-
-
-
-DirectionalKey_t PlayerInput::getPrevDirection() const
-{
-    return prevDirection;
-}
-
-
-
-bool PlayerInput::getPause() const
-{
-    return pause;
-}
-
-
-
-bool PlayerInput::getRestart() const
-{
-    return restart;
-}
-
-
-
-bool PlayerInput::getQuit() const
-{
-    return quit;
-}
-
-
-
-bool PlayerInput::getEnter() const
-{
-    return enter;
-}
-
-
-
-void PlayerInput::initCurses()
-{
-    /*
-    // Not sure of any proper way to check if initscr() has already been called.
-    // Display (using curses) will always init curses first, so don't bother
-    // adding mess to the code to add a boolean for this for now
-    if (curscr != NULL)
-    {
-        initscr();
-        refresh();
-    }
-    */
-
-    noecho();
-    keypad(stdscr, TRUE);
-    nodelay(stdscr, TRUE);
-    cbreak();
-}
-
+
+#include "input.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread> // sleep_until
+
+#ifdef _WIN32
+    #include "curses.h" // pdcurses for windows
+#else
+    #include <ncurses.h> // ncurses for linux (and whatever else it happens to work on)
+#endif
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <poll.h>
+    #include <sys/timerfd.h>
+    #include <unistd.h>
+#endif
+
+namespace ssnake
+{
+
+std::timed_mutex& getTerminalLock()
+{
+    static std::timed_mutex terminalLock;
+    return terminalLock;
+}
+
+
+
+PlayerInput::PlayerInput()
+{
+    initCurses();
+
+#ifdef __linux__
+    tickTimer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+#endif
+}
+
+
+
+PlayerInput::~PlayerInput()
+{
+#ifdef __linux__
+    if (tickTimer >= 0)
+    {
+        close(tickTimer);
+    }
+#endif
+}
+
+
+
+void PlayerInput::clearInputs()
+{
+    pause = restart = quit = enter = timings = false;
+    hasInputTime = false;
+}
+
+
+
+void PlayerInput::getInput()
+{
+    int input;
+    do
+    {
+        input = getch();
+
+        if (input != ERR && !hasInputTime)
+        {
+            inputTime = std::chrono::steady_clock::now();
+            hasInputTime = true;
+        }
+
+        switch (input)
+        {
+            case (KEY_LEFT) :
+            case ('a') :
+            case ('A') :
+                if (direction != LEFT_KEY)
+                {
+                    prevDirection = direction;
+                    direction = LEFT_KEY;
+                }
+                break;
+
+            case (KEY_RIGHT) :
+            case ('d') :
+            case ('D') :
+                if (direction != RIGHT_KEY)
+                {
+                    prevDirection = direction;
+                    direction = RIGHT_KEY;
+                }
+                break;
+
+            case (KEY_UP) :
+            case ('w') :
+            case ('W') :
+                if (direction != UP_KEY)
+                {
+                    prevDirection = direction;
+                    direction = UP_KEY;
+                }
+                break;
+
+            case (KEY_DOWN) :
+            case ('s') :
+            case ('S') :
+                if (direction != DOWN_KEY)
+                {
+                    prevDirection = direction;
+                    direction = DOWN_KEY;
+                }
+                break;
+
+            case ('q') :
+            case ('Q') :
+            case (KEY_EXIT) :
+            case (KEY_END) :
+                quit = true;
+                break;
+
+            case (KEY_ENTER) :
+            case ('\n') :
+            case ('\r') :
+                enter = true;
+                pause = true;
+                break;
+
+            case ('r') :
+            case ('R') :
+            case (KEY_RESTART) :
+                restart = true;
+                break;
+
+            case ('p') :
+            case ('P') :
+                timings = true;
+                break;
+
+            default:
+                break;
+        }
+
+    } while (input != ERR);
+}
+
+
+
+void PlayerInput::updateInputs()
+{
+    clearInputs();
+
+    prevDirection = direction;
+
+    std::unique_lock<std::timed_mutex> guard(getTerminalLock(), std::try_to_lock);
+    if (guard.owns_lock())
+    {
+        getInput();
+    }
+}
+
+
+
+void PlayerInput::startCollecting()
+{
+    clearInputs();
+
+    prevDirection = direction;
+}
+
+
+
+void PlayerInput::waitUntil(std::chrono::steady_clock::time_point deadline)
+{
+    if (pollUntil(deadline))
+    {
+        return;
+    }
+
+    std::this_thread::sleep_until(deadline);
+
+    std::unique_lock<std::timed_mutex> guard(getTerminalLock(), std::try_to_lock);
+    if (guard.owns_lock())
+    {
+        getInput();
+    }
+}
+
+
+
+void PlayerInput::waitForKey()
+{
+#ifdef __linux__
+    struct pollfd wait;
+    wait.fd = STDIN_FILENO;
+    wait.events = POLLIN;
+    if (poll(&wait, 1, -1) >= 0 || errno == EINTR)
+    {
+        return;
+    }
+#endif
+    // Checking a few times a step is still quick enough for menus
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+
+
+bool PlayerInput::pollUntil(std::chrono::steady_clock::time_point deadline)
+{
+#ifdef __linux__
+    if (tickTimer < 0)
+    {
+        return false;
+    }
+
+    // steady_clock is CLOCK_MONOTONIC on Linux, so the deadline can be handed to the timer as it is.
+    // A zero time would disarm the timer instead, and a deadline that passed fires right away.
+    std::int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    if (ns <= 0)
+    {
+        ns = 1;
+    }
+    struct itimerspec tick = {};
+    tick.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+    tick.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+    if (timerfd_settime(tickTimer, TFD_TIMER_ABSTIME, &tick, nullptr) != 0)
+    {
+        return false;
+    }
+
+    struct pollfd waits[2];
+    waits[0].fd = STDIN_FILENO;
+    waits[0].events = POLLIN;
+    waits[1].fd = tickTimer;
+    waits[1].events = POLLIN;
+    while (true)
+    {
+        if (poll(waits, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        if ((waits[0].revents & POLLIN) != 0)
+        {
+            // The keys stay readable until they are read, so give up on them until the next step
+            // rather than wait for a drawing thread past the deadline
+            std::unique_lock<std::timed_mutex> guard(getTerminalLock(), std::defer_lock);
+            if (!guard.try_lock_until(deadline))
+            {
+                return true;
+            }
+            getInput();
+        }
+        // A closed terminal stays readable forever, so stop waiting on it
+        else if (waits[0].revents != 0)
+        {
+            waits[0].fd = -1;
+        }
+
+        if ((waits[1].revents & POLLIN) != 0)
+        {
+            std::uint64_t expirations;
+            if (read(tickTimer, &expirations, sizeof(expirations)) == static_cast<ssize_t>(sizeof(expirations)))
+            {
+                return true;
+            }
+        }
+    }
+#else
+    (void)deadline;
+    return false;
+#endif
+}
+
+
+
+void PlayerInput::collectInput()
+{
+    clearInputs();
+
+    prevDirection = direction;
+
+    // Keys are only read with the terminal lock held, and a blocking read would keep it from a drawing thread
+    while (true)
+    {
+        {
+            std::lock_guard<std::timed_mutex> guard(getTerminalLock());
+            getInput();
+        }
+        if (hasInputTime)
+        {
+            return;
+        }
+
+        waitForKey();
+    }
+}
+
+
+
+DirectionalKey_t PlayerInput::getDirection() const
+{
+    return direction;
+}
+
+
+
+DirectionalKey_t PlayerInput::getPrevDirection() const
+{
+    return prevDirection;
+}
+
+
+
+bool PlayerInput::getPause() const
+{
+    return pause;
+}
+
+
+
+bool PlayerInput::getRestart() const
+{
+    return restart;
+}
+
+
+
+bool PlayerInput::getQuit() const
+{
+    return quit;
+}
+
+
+
+bool PlayerInput::getEnter() const
+{
+    return enter;
+}
+
+
+
+bool PlayerInput::getTimings() const
+{
+    return timings;
+}
+
+
+
+bool PlayerInput::getInputTime(std::chrono::steady_clock::time_point& time) const
+{
+    if (!hasInputTime)
+    {
+        return false;
+    }
+
+    time = inputTime;
+    return true;
+}
+
+
+
+void PlayerInput::initCurses()
+{
+    /*
+    // Not sure of any proper way to check if initscr() has already been called.
+    // Display (using curses) will always init curses first, so don't bother
+    // adding mess to the code to add a boolean for this for now
+    if (curscr != NULL)
+    {
+        initscr();
+        refresh();
+    }
+    */
+
+    // The display of the last game may still be drawing on its own thread
+    std::lock_guard<std::timed_mutex> guard(getTerminalLock());
+
+    noecho();
+    keypad(stdscr, TRUE);
+    nodelay(stdscr, TRUE);
+    cbreak();
+}
+
 }
\ No newline at end of file
@@ -1,84 +1,143 @@
-
-// input.h
-// Handles inputs using curses
-//
-
-#ifndef SLICERSNAKE_INPUT_H
-#define SLICERSNAKE_INPUT_H
-
-
-namespace ssnake
-{
-
-enum DirectionalKey_t
-{
-    RIGHT_KEY, LEFT_KEY, UP_KEY, DOWN_KEY, NONE
-};
-
-
-
-class PlayerInput
-{
-
-public:
-
-    PlayerInput();
-
-    // PreConditions:
-    // PostConditions:
-    //   Updates state to reflect inputs since last update
-    void updateInputs();
-
-    // PreConditions:
-    // PostConditions:
-    //   Collects an input, then updates state to reflect inputs since last update
-    void collectInput();
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns the most recent directional keypress
-    DirectionalKey_t getDirection() const;
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns the direction input that was previous to the current one
-    DirectionalKey_t getPrevDirection() const;
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns true if the user requested to pause during previous collection input, else returns false
-    bool getPause() const;
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns true if the user requested to restart during previous collection input, else returns false
-    bool getRestart() const;
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns true if the user requested to quit during previous collection input, else returns false
-    bool getQuit() const;
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns true if the user pressed enter/acknowledge/activate during previous collection input, else returns false
-    bool getEnter() const;
-
-private:
-
-    void clearInputs();
-    void getInput(bool once);
-    static void initCurses();
-
-    DirectionalKey_t direction = NONE;
-    DirectionalKey_t prevDirection = NONE;
-    bool pause = false;
-    bool restart = false;
-    bool quit = false;
-    bool enter = false;
-
-};
-
-}
-
-#endif
+
+// input.h
+// Handles inputs using curses
+//
+
+#ifndef SLICERSNAKE_INPUT_H
+#define SLICERSNAKE_INPUT_H
+
+
+#include <chrono>
+#include <mutex>
+
+
+namespace ssnake
+{
+
+// PreConditions:
+// PostConditions:
+//   Returns the lock of the curses terminal, which PlayerInput holds while it calls curses.
+//   A display that draws with curses on another thread has to hold it while drawing, since curses isn't thread safe.
+//   PlayerInput never waits for it past the deadline of a step, so drawing never holds up the game.
+std::timed_mutex& getTerminalLock();
+
+
+enum DirectionalKey_t
+{
+    RIGHT_KEY, LEFT_KEY, UP_KEY, DOWN_KEY, NONE
+};
+
+
+
+class PlayerInput
+{
+
+public:
+
+    PlayerInput();
+
+    // PreConditions:
+    // PostConditions:
+    //   The tick timer is closed
+    ~PlayerInput();
+
+    PlayerInput(const PlayerInput&) = delete;
+    PlayerInput& operator=(const PlayerInput&) = delete;
+
+    // PreConditions:
+    // PostConditions:
+    //   Updates state to reflect inputs since last update
+    //   Keys are left for the next update if another thread is drawing to the terminal
+    void updateInputs();
+
+    // PreConditions:
+    // PostConditions:
+    //   Forgets the requests collected since the last update, so that inputs are collected from now on,
+    //   like updateInputs but without reading any input yet
+    void startCollecting();
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns at deadline, with state updated to reflect every input since the last update
+    //   On Linux, inputs are read as they arrive while waiting, otherwise they are read at deadline
+    //   Keys that arrive while another thread is drawing to the terminal are read once it is done, or next time
+    void waitUntil(std::chrono::steady_clock::time_point deadline);
+
+    // PreConditions:
+    // PostConditions:
+    //   Collects an input, then updates state to reflect inputs since last update
+    void collectInput();
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the most recent directional keypress
+    DirectionalKey_t getDirection() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the direction input that was previous to the current one
+    DirectionalKey_t getPrevDirection() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if the user requested to pause during previous collection input, else returns false
+    bool getPause() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if the user requested to restart during previous collection input, else returns false
+    bool getRestart() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if the user requested to quit during previous collection input, else returns false
+    bool getQuit() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if the user pressed enter/acknowledge/activate during previous collection input, else returns false
+    bool getEnter() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if the user asked for the next page of tick timings during previous collection input, else returns false
+    bool getTimings() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true and sets time to when the first input since the last update was read,
+    //   or returns false if there was no input
+    bool getInputTime(std::chrono::steady_clock::time_point& time) const;
+
+private:
+
+    void clearInputs();
+    // Reads every key waiting, with the terminal lock held
+    void getInput();
+    static void initCurses();
+
+    // Waits for input and the tick timer together, returns false if they couldn't be waited on
+    bool pollUntil(std::chrono::steady_clock::time_point deadline);
+
+    // Waits until a key might have been pressed, without holding the terminal lock
+    static void waitForKey();
+
+    // timerfd that fires at the deadline of waitUntil, -1 where there is none
+    int tickTimer = -1;
+
+    std::chrono::steady_clock::time_point inputTime;
+    bool hasInputTime = false;
+
+    DirectionalKey_t direction = NONE;
+    DirectionalKey_t prevDirection = NONE;
+    bool pause = false;
+    bool restart = false;
+    bool quit = false;
+    bool enter = false;
+    bool timings = false;
+
+};
+
+}
+
+#endif
@@ -1,106 +1,818 @@
-
-//
-// SlicerSnake
-// main.cpp
-// https://github.com/adisib
-//
-
-
-#include <cstdlib>  // srand
-#include <ctime> // srand(time(NULL))
-
-#include "display.h"
-#include "game.h"
-
-
-
-// Allows the player to select a game mode
-ssnake::Game_t gameSelectMenu(ssnake::Display* display, ssnake::PlayerInput& input);
-
-
-int main()
-{
-    //
-
-    std::srand(static_cast<unsigned int>(std::time(NULL)));
-
-    ssnake::Display* display = new ssnake::Display(27, 30);
-
-    bool play = true;
-    while (play)
-    {
-        ssnake::PlayerInput input;
-        ssnake::SnakeGame game(display);
-
-        display->clearScreen();
-
-        ssnake::Game_t gameTypeSelected = gameSelectMenu(display, input);
-
-        game.startGame(gameTypeSelected);
-
-        display->printTextLine(display->getSize_y() / 2 - 2, "GAME OVER");
-        display->printTextLine(display->getSize_y() / 2 - 1, "R: Restart | Enter: Quit");
-        display->update();
-
-        do
-        {
-            input.collectInput();
-        } while (!input.getEnter() && !input.getRestart());
-        if (!input.getRestart())
-        {
-            play = false;
-        }
-    }
-
-    delete display;
-
-
-    return 0;
-}
-
-
-
-ssnake::Game_t gameSelectMenu(ssnake::Display* display, ssnake::PlayerInput& input)
-{
-    bool initialSelect = true;
-    ssnake::Game_t typeSelected;
-    ssnake::DirectionalKey_t direction;
-
-    display->printTextLine(7, "Arrow keys move, enter key pauses");
-
-    do
-    {
-        if (initialSelect)
-        {
-            direction = ssnake::LEFT_KEY;
-            typeSelected = ssnake::GM_SLICER;
-            initialSelect = false;
-        }
-        else
-        {
-            input.collectInput();
-            direction = input.getDirection();
-        }
-
-        if (direction == ssnake::LEFT_KEY)
-        {
-            display->printTextLine(4, "Get as long as you can");
-            display->printTextLine(5, "But don't let the other snake eat you!");
-
-            typeSelected = ssnake::GM_SLICER;
-            display->printTextLine(display->getSize_y() / 2, "[ Slicer Snake ]     Classic  ");
-            display->update();
-        }
-        else if (direction == ssnake::RIGHT_KEY)
-        {
-            display->printTextLine(4, "Classic Snake");
-            display->printTextLine(5, "Get the food but don't hit yourself!");
-
-            typeSelected = ssnake::GM_CLASSIC;
-            display->printTextLine(display->getSize_y() / 2, "  Slicer Snake     [ Classic ]");
-            display->update();
-        }
-    } while (!input.getEnter() && !input.getQuit());
-
-    return typeSelected;
-}
+
+//
+// SlicerSnake
+// main.cpp
+// https://github.com/adisib
+//
+
+
+#include <chrono> // seeding games
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib> // strtod, strtoul
+#include <cstring> // strcmp
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "board.h"
+#include "display.h"
+#include "display_ansi.h"
+#include "display_curses.h"
+#include "display_delta.h"
+#include "display_headless.h"
+#include "display_threaded.h"
+#include "game.h"
+#include "game_client.h"
+#include "game_server.h"
+#include "input.h"
+#include "replay.h"
+#include "tick_pacer.h"
+#include "tick_profiler.h"
+
+
+
+// Command line options
+struct Options
+{
+    // Run headless games instead of the interactive game
+    bool batch = false;
+    ssnake::BatchConfig batchConfig;
+    // Print the result of every batch game, not just the summary
+    bool printGames = false;
+    // Replay files to play back instead of playing
+    std::vector<const char*> replayPaths;
+    // Seconds the interactive game spins for before each step, instead of only sleeping
+    double spinTime = 0.0;
+    // Print how well the interactive game kept to its step times once it is over
+    bool printTickStats = false;
+    // Draw the interactive game with AnsiDisplay instead of CursesDisplay
+    bool ansiRenderer = false;
+    // Most times a second the interactive game is drawn to the terminal, 0 for no limit
+    double maxFps = 60.0;
+    // Address to run a multiplayer server on, or to connect to one on
+    const char* serveAddress = nullptr;
+    const char* connectAddress = nullptr;
+    // Bots to connect instead of playing
+    std::size_t botCount = 0;
+    // Steps the server or every bot stops after, 0 for no limit
+    unsigned long onlineSteps = 0;
+    // File the interactive game or the server streams to
+    const char* streamPath = nullptr;
+    // Stream to show instead of playing, from its last keyframe on if live
+    const char* watchPath = nullptr;
+    bool live = false;
+};
+
+
+
+// Names of DeathCause_t values for printing
+const char* causeNames[] = {"none", "wall", "self", "eaten", "quit"};
+
+// Frames between the keyframes of streams, a few seconds of the game at its usual speed
+const unsigned int streamKeyframeInterval = 250;
+
+
+
+// Allows the player to select a game mode
+ssnake::Game_t gameSelectMenu(ssnake::Display* display, ssnake::PlayerInput& input);
+
+// Fills options from the command line, returns false if it couldn't be understood
+bool parseOptions(int argc, char* argv[], Options& options);
+void printUsage(const char* programName);
+
+// Runs the batch described by options and prints the results
+int runBatch(const Options& options);
+
+// Plays back every game of the replay files in options, and prints which ones ended differently
+int runReplays(const Options& options);
+
+// Runs a multiplayer server until it is interrupted, then prints how it went
+int runServer(const Options& options);
+
+// Plays on a multiplayer server, or connects the bots of options to it and prints what they got
+int runClient(const Options& options);
+
+// Shows the stream of options until the player quits
+int runWatch(const Options& options);
+
+// The server that SIGINT and SIGTERM stop
+ssnake::GameServer* runningServer = nullptr;
+void stopServer(int signal);
+
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (!options.replayPaths.empty())
+    {
+        return runReplays(options);
+    }
+    if (options.batch)
+    {
+        return runBatch(options);
+    }
+    if (options.serveAddress != nullptr)
+    {
+        return runServer(options);
+    }
+    if (options.connectAddress != nullptr)
+    {
+        return runClient(options);
+    }
+    if (options.watchPath != nullptr)
+    {
+        return runWatch(options);
+    }
+
+    // Opened before curses starts, so that an error can still be printed
+    ssnake::ReplayWriter replayWriter;
+    if (!options.batchConfig.recordPath.empty() && !replayWriter.open(options.batchConfig.recordPath.c_str()))
+    {
+        std::fprintf(stderr, "Couldn't create %s\n", options.batchConfig.recordPath.c_str());
+        return 1;
+    }
+
+    // Larger boards than the terminal are fine, but the menu has to fit
+    if (options.batchConfig.size_x < 27 || options.batchConfig.size_y < 20)
+    {
+        std::fprintf(stderr, "The interactive game needs a size of at least 27x20\n");
+        return 1;
+    }
+
+    ssnake::Display* screen;
+    if (options.ansiRenderer)
+    {
+        screen = new ssnake::AnsiDisplay(options.batchConfig.size_x, options.batchConfig.size_y);
+    }
+    else
+    {
+        screen = new ssnake::CursesDisplay(options.batchConfig.size_x, options.batchConfig.size_y);
+    }
+
+    // The terminal is drawn to on its own thread, so that the game never waits for it.
+    // Curses is also called for keys on this thread, so the thread draws with the terminal lock held
+    std::timed_mutex* drawLock = options.ansiRenderer ? nullptr : &ssnake::getTerminalLock();
+    ssnake::ThreadedDisplay* renderer = new ssnake::ThreadedDisplay(screen, options.maxFps, drawLock);
+
+    // Draws to the screen too, so that the stream shows what the player sees, every frame of it
+    ssnake::DeltaDisplay* streamDisplay = nullptr;
+    ssnake::Display* display = renderer;
+    if (options.streamPath != nullptr)
+    {
+        streamDisplay = new ssnake::DeltaDisplay(options.batchConfig.size_x, options.batchConfig.size_y, renderer);
+        if (!streamDisplay->openStream(options.streamPath, streamKeyframeInterval))
+        {
+            delete streamDisplay;
+            delete renderer;
+            delete screen;
+            std::fprintf(stderr, "Couldn't create %s\n", options.streamPath);
+            return 1;
+        }
+        display = streamDisplay;
+    }
+
+    // Kept over every game, so that its statistics cover all of them
+    ssnake::TickPacer pacer(ssnake::SnakeGame::minGameDelay, options.spinTime);
+
+    // Searches think for as long as they can in the time between steps instead of for a number of playouts
+    ssnake::MctsConfig interactiveMcts;
+    interactiveMcts.threadCount = 0;
+    interactiveMcts.rollouts = 0;
+    interactiveMcts.thinkShare = 0.5;
+
+#ifdef SSNAKE_PROFILE
+    // Kept over every game, and printed once curses is done with the terminal
+    ssnake::TickProfiler profiler;
+#endif
+
+    bool play = true;
+    while (play)
+    {
+        ssnake::PlayerInput input;
+        ssnake::SnakeGame game(display);
+        game.setAiMode(options.batchConfig.aiMode);
+        game.setMctsConfig(interactiveMcts);
+        game.setTickPacer(&pacer);
+#ifdef SSNAKE_PROFILE
+        game.setProfiler(&profiler);
+#endif
+        if (!options.batchConfig.recordPath.empty())
+        {
+            game.setReplayWriter(&replayWriter);
+        }
+
+        display->clearScreen();
+
+        ssnake::Game_t gameTypeSelected = gameSelectMenu(display, input);
+
+        // Every game gets its own seed
+        std::uint64_t seed = static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+        game.startGame(gameTypeSelected, seed, input);
+
+        display->printTextLine(display->getViewSize_y() / 2 - 2, "GAME OVER");
+        display->printTextLine(display->getViewSize_y() / 2 - 1, "R: Restart | Enter: Quit");
+        display->update();
+
+        do
+        {
+            input.collectInput();
+        } while (!input.getEnter() && !input.getRestart());
+        if (!input.getRestart())
+        {
+            play = false;
+        }
+    }
+
+    std::uint64_t publishedFrames, renderedFrames;
+    renderer->getFrameCounts(publishedFrames, renderedFrames);
+
+    delete streamDisplay;
+    delete renderer;
+    delete screen;
+
+    if (options.printTickStats)
+    {
+        const ssnake::TickStats& stats = pacer.getStats();
+        double meanLateness = (stats.ticks > 0) ? static_cast<double>(stats.totalLateness) / stats.ticks : 0.0;
+        std::fprintf(stderr, "steps: %llu, overruns: %llu, late by: %.1f us mean, %.1f us max\n",
+                     static_cast<unsigned long long>(stats.ticks), static_cast<unsigned long long>(stats.overruns),
+                     meanLateness / 1000.0, stats.maxLateness / 1000.0);
+        std::fprintf(stderr, "frames: %llu, drawn: %llu\n",
+                     static_cast<unsigned long long>(publishedFrames), static_cast<unsigned long long>(renderedFrames));
+    }
+
+#ifdef SSNAKE_PROFILE
+    profiler.dump(stderr);
+#endif
+
+    return 0;
+}
+
+
+
+ssnake::Game_t gameSelectMenu(ssnake::Display* display, ssnake::PlayerInput& input)
+{
+    bool initialSelect = true;
+    ssnake::Game_t typeSelected;
+    ssnake::DirectionalKey_t direction;
+
+    display->printTextLine(7, "Arrow keys move, enter key pauses");
+
+    do
+    {
+        if (initialSelect)
+        {
+            direction = ssnake::LEFT_KEY;
+            typeSelected = ssnake::GM_SLICER;
+            initialSelect = false;
+        }
+        else
+        {
+            input.collectInput();
+            direction = input.getDirection();
+        }
+
+        // Slicer and Classic are side by side, Arena is below them
+        if (direction == ssnake::LEFT_KEY || (direction == ssnake::UP_KEY && typeSelected == ssnake::GM_ARENA))
+        {
+            display->printTextLine(4, "Get as long as you can");
+            display->printTextLine(5, "But don't let the other snake eat you!");
+
+            typeSelected = ssnake::GM_SLICER;
+            display->printTextLine(display->getViewSize_y() / 2, "[ Slicer Snake ]     Classic  ");
+            display->printTextLine(display->getViewSize_y() / 2 + 2, "  Arena  ");
+            display->update();
+        }
+        else if (direction == ssnake::RIGHT_KEY)
+        {
+            display->printTextLine(4, "Classic Snake");
+            display->printTextLine(5, "Get the food but don't hit yourself!");
+
+            typeSelected = ssnake::GM_CLASSIC;
+            display->printTextLine(display->getViewSize_y() / 2, "  Slicer Snake     [ Classic ]");
+            display->printTextLine(display->getViewSize_y() / 2 + 2, "  Arena  ");
+            display->update();
+        }
+        else if (direction == ssnake::DOWN_KEY)
+        {
+            display->printTextLine(4, "Slicer Snake with a crowd of snakes");
+            display->printTextLine(5, "They come back when they die, you don't!");
+
+            typeSelected = ssnake::GM_ARENA;
+            display->printTextLine(display->getViewSize_y() / 2, "  Slicer Snake       Classic  ");
+            display->printTextLine(display->getViewSize_y() / 2 + 2, "[ Arena ]");
+            display->update();
+        }
+    } while (!input.getEnter() && !input.getQuit());
+
+    return typeSelected;
+}
+
+
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (std::strcmp(arg, "--per-game") == 0)
+        {
+            options.printGames = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--tick-stats") == 0)
+        {
+            options.printTickStats = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--live") == 0)
+        {
+            options.live = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--replay") == 0)
+        {
+            // Takes every argument up to the next option, so that a shell pattern can be passed
+            std::size_t pathCount = options.replayPaths.size();
+            while (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+            {
+                options.replayPaths.push_back(argv[++i]);
+            }
+            if (options.replayPaths.size() == pathCount)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        // Every other option takes a value
+        if (value == nullptr)
+        {
+            return false;
+        }
+        ++i;
+
+        if (std::strcmp(arg, "--batch") == 0)
+        {
+            options.batch = true;
+            options.batchConfig.gameCount = std::strtoul(value, nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--mode") == 0)
+        {
+            if (std::strcmp(value, "slicer") == 0)
+            {
+                options.batchConfig.gameType = ssnake::GM_SLICER;
+            }
+            else if (std::strcmp(value, "classic") == 0)
+            {
+                options.batchConfig.gameType = ssnake::GM_CLASSIC;
+            }
+            else if (std::strcmp(value, "arena") == 0)
+            {
+                options.batchConfig.gameType = ssnake::GM_ARENA;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--seed") == 0)
+        {
+            options.batchConfig.firstSeed = std::strtoull(value, nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--threads") == 0)
+        {
+            options.batchConfig.threadCount = std::strtoul(value, nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--max-steps") == 0)
+        {
+            options.batchConfig.maxSteps = std::strtoul(value, nullptr, 10);
+            options.onlineSteps = options.batchConfig.maxSteps;
+        }
+        else if (std::strcmp(arg, "--serve") == 0)
+        {
+            options.serveAddress = value;
+        }
+        else if (std::strcmp(arg, "--connect") == 0)
+        {
+            options.connectAddress = value;
+        }
+        else if (std::strcmp(arg, "--stream") == 0)
+        {
+            options.streamPath = value;
+        }
+        else if (std::strcmp(arg, "--watch") == 0)
+        {
+            options.watchPath = value;
+        }
+        else if (std::strcmp(arg, "--bots") == 0)
+        {
+            options.botCount = std::strtoul(value, nullptr, 10);
+            if (options.botCount == 0)
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--ai") == 0)
+        {
+            if (std::strcmp(value, "simple") == 0)
+            {
+                options.batchConfig.aiMode = ssnake::AI_SIMPLE;
+            }
+            else if (std::strcmp(value, "path") == 0)
+            {
+                options.batchConfig.aiMode = ssnake::AI_PATHFINDING;
+            }
+            else if (std::strcmp(value, "field") == 0)
+            {
+                options.batchConfig.aiMode = ssnake::AI_FOOD_FIELD;
+            }
+            else if (std::strcmp(value, "mcts") == 0)
+            {
+                options.batchConfig.aiMode = ssnake::AI_MCTS;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--renderer") == 0)
+        {
+            if (std::strcmp(value, "curses") == 0)
+            {
+                options.ansiRenderer = false;
+            }
+            else if (std::strcmp(value, "ansi") == 0)
+            {
+                options.ansiRenderer = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--max-fps") == 0)
+        {
+            char* end;
+            options.maxFps = std::strtod(value, &end);
+            if (*end != '\0' || options.maxFps < 0.0 || options.maxFps > 10000.0)
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--rollouts") == 0)
+        {
+            options.batchConfig.mctsRollouts = std::strtoul(value, nullptr, 10);
+            if (options.batchConfig.mctsRollouts == 0)
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--record") == 0)
+        {
+            options.batchConfig.recordPath = value;
+        }
+        else if (std::strcmp(arg, "--arena-snakes") == 0)
+        {
+            options.batchConfig.arenaSnakes = std::strtoul(value, nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--spin") == 0)
+        {
+            // Microseconds, so that the sub-millisecond precision it is for can be asked for directly
+            char* end;
+            double spinMicroseconds = std::strtod(value, &end);
+            if (*end != '\0' || spinMicroseconds < 0.0 || spinMicroseconds > 1000000.0)
+            {
+                return false;
+            }
+            options.spinTime = spinMicroseconds / 1000000.0;
+        }
+        else if (std::strcmp(arg, "--size") == 0)
+        {
+            // Board size as WIDTHxHEIGHT, the same units as the interactive game's 27x30
+            int size_x, size_y;
+            if (std::sscanf(value, "%dx%d", &size_x, &size_y) != 2 || size_x < 8 || size_y < 8)
+            {
+                return false;
+            }
+            options.batchConfig.size_x = size_x;
+            options.batchConfig.size_y = size_y;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // Bots only play on a server, and only streams are watched live
+    if (options.botCount > 0 && options.connectAddress == nullptr)
+    {
+        return false;
+    }
+    if (options.live && options.watchPath == nullptr)
+    {
+        return false;
+    }
+
+    // The food field has a distance for every cell, and every search has its own copy of the game with one,
+    // so they would take gigabytes on the boards that only keep the tiles something is on
+    ssnake::HeadlessDisplay layout(options.batchConfig.size_x, options.batchConfig.size_y);
+    if ((options.batchConfig.aiMode == ssnake::AI_FOOD_FIELD || options.batchConfig.aiMode == ssnake::AI_MCTS)
+        && ssnake::Board::isSparseSize(layout.getSize_x(), layout.getSize_y()))
+    {
+        std::fprintf(stderr, "--ai field and --ai mcts need a board of at most about four million cells, "
+                             "use --ai simple or --ai path for larger boards\n\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+
+void printUsage(const char* programName)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [options]\n"
+                 "Without options the interactive game is started.\n"
+                 "\n"
+                 "  --batch N        play N headless games with the AI steering the player\n"
+                 "  --mode M         slicer (default), classic or arena\n"
+                 "  --seed S         seed of the first game, game i uses S + i (default 0)\n"
+                 "  --threads T      worker threads, 0 uses every core (default 0)\n"
+                 "  --max-steps M    stop games after M steps, 0 for no limit (default 100000)\n"
+                 "  --arena-snakes N computer snakes in arena games, 0 picks one per 100 cells (default 0)\n"
+                 "  --size WxH       board size of every game (default 27x30), the interactive game scrolls\n"
+                 "                   boards larger than the terminal and needs at least 27x20\n"
+                 "  --ai A           simple (default), path, field or mcts, the AI of computer snakes and autopilot,\n"
+                 "                   field and mcts only on boards of up to about four million cells\n"
+                 "  --rollouts N     playouts per move of the mcts AI in batches (default 256),\n"
+                 "                   the interactive game searches with every core for half of each step instead\n"
+                 "  --per-game       print the result of every game\n"
+                 "  --spin US        sleep until US microseconds before each step of the interactive game,\n"
+                 "                   then spin for more precise step times (default 0)\n"
+                 "  --tick-stats     print how late the interactive game's steps were and how many frames were drawn\n"
+                 "                   once it is over\n"
+                 "  --renderer R     curses (default) or ansi, which draws the interactive game straight to the\n"
+                 "                   terminal with escape codes, writing only what changed once per step\n"
+                 "  --max-fps F      draw the interactive game at most F times a second, skipping steps in between,\n"
+                 "                   0 for every step (default 60), drawing never holds up the game\n"
+                 "  --record FILE    record games to the replay file FILE, batches write FILE.N for each worker N\n"
+                 "  --replay FILE... play back every game in the replay files as fast as possible,\n"
+                 "                   the exit code is 2 if any game ended differently than when it was recorded\n"
+                 "  --serve ADDR     run an arena for players that connect to ADDR, \"HOST:PORT\" for TCP\n"
+                 "                   or \"unix:PATH\" for a Unix socket, with --size, --seed, --ai, --arena-snakes,\n"
+                 "                   --spin and --max-steps (default 0, no limit) applying to it\n"
+                 "  --connect ADDR   play on the server at ADDR\n"
+                 "  --bots N         connect N bots that turn at random to the server of --connect instead,\n"
+                 "                   each stops after --max-steps steps (default 0, until the server stops)\n"
+                 "  --stream FILE    write the board of the interactive game or of the --serve arena to FILE\n"
+                 "                   as it is played, for --watch\n"
+                 "  --watch FILE     show the game streamed to FILE at the speed it was played,\n"
+                 "                   following the file as it grows\n"
+                 "  --live           start --watch at the newest part of the stream and keep up with it\n",
+                 programName);
+}
+
+
+
+int runBatch(const Options& options)
+{
+    ssnake::BatchRunner runner(options.batchConfig);
+
+    std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    std::vector<ssnake::GameResult> results = runner.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+
+    if (options.printGames)
+    {
+        std::printf("seed,final_length,max_length,steps,cause\n");
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            std::printf("%llu,%zu,%zu,%lu,%s\n",
+                        static_cast<unsigned long long>(results[i].seed),
+                        results[i].finalLength, results[i].maxLength, results[i].steps,
+                        causeNames[results[i].cause]);
+        }
+    }
+
+    ssnake::BatchSummary summary = ssnake::BatchRunner::summarize(results);
+    std::printf("games: %zu in %.3f s\n", summary.games, seconds);
+    std::printf("mean final length: %.2f\n", summary.meanFinalLength);
+    std::printf("mean max length: %.2f (longest %zu)\n", summary.meanMaxLength, summary.longestLength);
+    std::printf("mean steps: %.1f\n", summary.meanSteps);
+    for (int cause = ssnake::DEATH_NONE; cause <= ssnake::DEATH_QUIT; ++cause)
+    {
+        std::printf("ended by %s: %zu\n", causeNames[cause], summary.causeCounts[cause]);
+    }
+
+    return 0;
+}
+
+
+
+int runReplays(const Options& options)
+{
+    std::size_t games = 0;
+    std::size_t differentGames = 0;
+
+    if (options.printGames)
+    {
+        std::printf("file,seed,steps,final_length,max_length,cause,same\n");
+    }
+
+    std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < options.replayPaths.size(); ++i)
+    {
+        const char* path = options.replayPaths[i];
+
+        ssnake::ReplayReader reader;
+        if (!reader.open(path))
+        {
+            std::fprintf(stderr, "Couldn't open %s\n", path);
+            return 1;
+        }
+
+        ssnake::ReplayHeader header;
+        while (reader.nextGame(header))
+        {
+            ssnake::ReplayOutcome outcome = ssnake::playReplay(reader, header);
+            if (reader.failed())
+            {
+                break;
+            }
+
+            const ssnake::ReplayOutcome& recorded = reader.getOutcome();
+            bool same = outcome.steps == recorded.steps && outcome.finalLength == recorded.finalLength
+                        && outcome.maxLength == recorded.maxLength && outcome.cause == recorded.cause;
+
+            ++games;
+            if (!same)
+            {
+                ++differentGames;
+            }
+
+            if (options.printGames)
+            {
+                std::printf("%s,%llu,%lu,%zu,%zu,%s,%s\n", path,
+                            static_cast<unsigned long long>(header.seed),
+                            outcome.steps, outcome.finalLength, outcome.maxLength,
+                            causeNames[outcome.cause], same ? "yes" : "no");
+            }
+        }
+
+        if (reader.failed())
+        {
+            std::fprintf(stderr, "%s is cut short or is not a replay file\n", path);
+            return 1;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+
+    std::printf("replays: %zu in %.3f s\n", games, seconds);
+    std::printf("ended differently: %zu\n", differentGames);
+
+    return (differentGames > 0) ? 2 : 0;
+}
+
+
+int runServer(const Options& options)
+{
+    // Clients show the whole game message line, the same as the interactive game
+    if (options.batchConfig.size_x < 27 || options.batchConfig.size_y < 20)
+    {
+        std::fprintf(stderr, "The server needs a size of at least 27x20\n");
+        return 1;
+    }
+
+    ssnake::ServerConfig config;
+    config.address = options.serveAddress;
+    config.size_x = options.batchConfig.size_x;
+    config.size_y = options.batchConfig.size_y;
+    config.arenaSnakes = options.batchConfig.arenaSnakes;
+    config.aiMode = options.batchConfig.aiMode;
+    config.seed = options.batchConfig.firstSeed;
+    config.maxSteps = options.onlineSteps;
+    config.spinTime = options.spinTime;
+    if (options.streamPath != nullptr)
+    {
+        config.streamPath = options.streamPath;
+        config.streamKeyframeInterval = streamKeyframeInterval;
+    }
+
+    // Searches think for as long as they can in the time between steps, like in the interactive game
+    config.mctsConfig.threadCount = 0;
+    config.mctsConfig.rollouts = 0;
+    config.mctsConfig.thinkShare = 0.5;
+
+    ssnake::GameServer server(config);
+    std::string error;
+    if (!server.open(error))
+    {
+        std::fprintf(stderr, "Couldn't serve on %s: %s\n", options.serveAddress, error.c_str());
+        return 1;
+    }
+
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    std::fprintf(stderr, "Serving on %s\n", options.serveAddress);
+    bool served = server.run();
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    runningServer = nullptr;
+
+    const ssnake::ServerStats& stats = server.getStats();
+    const ssnake::TickStats& tickStats = server.getTickStats();
+    std::printf("steps: %lu, overruns: %llu\n", server.getStepCount(),
+                static_cast<unsigned long long>(tickStats.overruns));
+    std::printf("clients: %llu (refused %llu), connected at the end: %zu\n",
+                static_cast<unsigned long long>(stats.clientsAccepted),
+                static_cast<unsigned long long>(stats.clientsRefused), server.getClientCount());
+    std::printf("sent: %llu bytes, keyframes: %llu, steps skipped by slow clients: %llu\n",
+                static_cast<unsigned long long>(stats.bytesSent), static_cast<unsigned long long>(stats.keyframesSent),
+                static_cast<unsigned long long>(stats.stepsSkipped));
+
+    if (!served)
+    {
+        std::fprintf(stderr, "Waiting for clients failed\n");
+        return 1;
+    }
+    return 0;
+}
+
+
+
+int runClient(const Options& options)
+{
+    std::string error;
+
+    if (options.botCount == 0)
+    {
+        if (!ssnake::playOnline(options.connectAddress, error))
+        {
+            std::fprintf(stderr, "%s: %s\n", options.connectAddress, error.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    ssnake::BotStats stats;
+    std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    bool played = ssnake::runBots(options.connectAddress, options.botCount, options.onlineSteps,
+                                  options.batchConfig.firstSeed, stats, error);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+
+    double bytesPerStep = (stats.steps > 0) ? static_cast<double>(stats.bytesReceived) / stats.steps : 0.0;
+    std::printf("bots: %zu for %.3f s\n", stats.bots, seconds);
+    std::printf("steps: %llu, received: %llu bytes (%.1f per bot per step)\n",
+                static_cast<unsigned long long>(stats.steps), static_cast<unsigned long long>(stats.bytesReceived),
+                bytesPerStep);
+    std::printf("keyframes: %llu, respawns: %llu\n",
+                static_cast<unsigned long long>(stats.keyframes), static_cast<unsigned long long>(stats.respawns));
+
+    if (!played)
+    {
+        std::fprintf(stderr, "%s: %s\n", options.connectAddress, error.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+
+
+int runWatch(const Options& options)
+{
+    std::string error;
+    if (!ssnake::watchStream(options.watchPath, options.live, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+void stopServer(int signal)
+{
+    (void)signal;
+    if (runningServer != nullptr)
+    {
+        runningServer->stop();
+    }
+}
@@ -0,0 +1,426 @@
+
+#include "mcts.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath> // log, sqrt
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "display.h"
+#include "display_headless.h"
+#include "game.h"
+#include "input.h"
+#include "random.h"
+#include "snake.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// Indexed by Direction_t
+const DirectionalKey_t directionKeys[4] = {RIGHT_KEY, LEFT_KEY, UP_KEY, DOWN_KEY};
+const Direction_t oppositeDirections[4] = {LEFT, RIGHT, DOWN, UP};
+
+// How much the search tries directions that were played less over ones that did well so far (UCB1)
+const double exploration = 0.3;
+
+// Directions past this many steps are left to the AI of the playouts. Deeper lines mostly get played
+// for the sake of trying them, which only blurs how good the first directions are.
+const unsigned int maxTreeDepth = 4;
+
+// Playouts that end alive score from 0.25 to 1 by how they did, and ones that die from 0 to 0.25 by how long they lasted
+const double survivalReward = 0.25;
+
+// Rewards of root directions are added up as whole numbers, so that the threads can add them atomically
+const double rewardScale = 65536.0;
+
+
+
+// How well a playout went, added up step by step.
+// Food is worth a tenth less for every step it takes to get to, so that a step closer to food stands out,
+// and every piece sliced off of the snake counts against it.
+// Only the first food counts, since the food after it is placed at random and would only add noise.
+struct PlayoutScore
+{
+    std::size_t length;
+    double food;
+    double worth;
+
+    void addStep(std::size_t newLength)
+    {
+        if (newLength > length)
+        {
+            food += worth;
+            worth = 0.0;
+        }
+        else if (newLength < length)
+        {
+            food -= 0.25 * static_cast<double>(length - newLength);
+        }
+        length = newLength;
+        worth *= 0.9;
+    }
+};
+
+}
+
+
+
+MctsPlanner::Worker::Worker(coordType size_x, coordType size_y)
+    : display(size_x + 1, size_y + 3), game(&display)
+{
+    // Fast enough to play out many steps, and still heads for food and away from traps
+    game.setAiMode(AI_FOOD_FIELD);
+}
+
+
+
+MctsPlanner::MctsPlanner(const MctsConfig& config, coordType size_x, coordType size_y)
+    : stopping(false)
+{
+    assert(config.rollouts > 0 || config.thinkShare > 0.0);
+    assert(config.rolloutDepth > 0);
+
+    this->config = config;
+
+    std::size_t threadCount = config.threadCount;
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    for (int d = 0; d < 4; ++d)
+    {
+        rootVisits[d].store(0);
+        rootReward[d].store(0);
+    }
+
+    // The thread that searches runs the first worker itself
+    for (std::size_t worker = 0; worker < threadCount; ++worker)
+    {
+        workers.emplace_back(new Worker(size_x, size_y));
+    }
+    for (std::size_t worker = 1; worker < threadCount; ++worker)
+    {
+        threads.emplace_back(&MctsPlanner::runThread, this, worker);
+    }
+}
+
+
+
+MctsPlanner::~MctsPlanner()
+{
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        shuttingDown = true;
+    }
+    startSearch.notify_all();
+
+    for (std::size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+}
+
+
+
+bool MctsPlanner::search(const GameSnapshot& root,
+                         int snakeIndex,
+                         std::chrono::steady_clock::time_point deadline,
+                         Direction_t& direction)
+{
+    assert(snakeIndex >= 0 && static_cast<std::size_t>(snakeIndex) < root.snakes.size());
+
+    // Threads can still be finishing a playout of the last search, which returned at its deadline
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        threadsIdle.wait(guard, [this]() { return busyThreads == 0; });
+    }
+
+    searchRoot = root;
+    searchIndex = snakeIndex;
+    searchDeadline = deadline;
+    hasDeadline = deadline != std::chrono::steady_clock::time_point::max();
+    assert(hasDeadline || config.rollouts > 0);
+
+    // Seeded from the game, so that searches without a deadline play out the same every time
+    Random seeder = root.rng;
+    searchSeed = seeder.next();
+
+    for (int d = 0; d < 4; ++d)
+    {
+        rootVisits[d].store(0, std::memory_order_relaxed);
+        rootReward[d].store(0, std::memory_order_relaxed);
+    }
+    stopping = false;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ++generation;
+        busyThreads = threads.size();
+    }
+    startSearch.notify_all();
+
+    runWorker(0);
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        if (hasDeadline)
+        {
+            threadsIdle.wait_until(guard, deadline, [this]() { return busyThreads == 0; });
+        }
+        else
+        {
+            threadsIdle.wait(guard, [this]() { return busyThreads == 0; });
+        }
+    }
+    stopping = true;
+
+    // The most played direction is the one the search trusts the most
+    int best = -1;
+    std::uint32_t bestVisits = 0;
+    std::uint64_t bestReward = 0;
+    for (int d = 0; d < 4; ++d)
+    {
+        std::uint32_t visits = rootVisits[d].load(std::memory_order_relaxed);
+        std::uint64_t reward = rootReward[d].load(std::memory_order_relaxed);
+        if (visits > bestVisits || (visits == bestVisits && visits > 0 && reward > bestReward))
+        {
+            best = d;
+            bestVisits = visits;
+            bestReward = reward;
+        }
+    }
+
+    if (best < 0)
+    {
+        return false;
+    }
+
+    direction = static_cast<Direction_t>(best);
+    return true;
+}
+
+
+
+void MctsPlanner::runThread(std::size_t worker)
+{
+    std::uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            startSearch.wait(guard, [&]() { return shuttingDown || generation != seenGeneration; });
+            if (shuttingDown)
+            {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runWorker(worker);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            --busyThreads;
+            if (busyThreads == 0)
+            {
+                threadsIdle.notify_all();
+            }
+        }
+    }
+}
+
+
+
+void MctsPlanner::runWorker(std::size_t worker)
+{
+    Worker& current = *workers[worker];
+
+    // The searched snake plays as the player, so that it is steered by the actions of the playouts,
+    // and the game ends when it dies
+    current.root = searchRoot;
+    current.root.playerIndex = searchIndex;
+    current.rng.seed(searchSeed + worker);
+
+    Node root = {{-1, -1, -1, -1}, 0, 0.0, false};
+    current.tree.clear();
+    current.tree.push_back(root);
+
+    // Playouts are shared out evenly, so each thread's tree only depends on its seed
+    std::size_t playouts = config.rollouts * (worker + 1) / workers.size() - config.rollouts * worker / workers.size();
+    Direction_t rootDirection = searchRoot.snakes[searchIndex].direction;
+    for (std::size_t done = 0; config.rollouts == 0 || done < playouts; ++done)
+    {
+        if (outOfTime() || !playout(current, rootDirection))
+        {
+            break;
+        }
+    }
+}
+
+
+
+bool MctsPlanner::playout(Worker& worker, Direction_t rootDirection)
+{
+    std::vector<Node>& tree = worker.tree;
+    SnakeGame& game = worker.game;
+
+    worker.root.rng.seed(worker.rng.next());
+    game.restore(worker.root);
+    PlayoutScore score = {game.getPlayerLength(), 0.0, 1.0};
+
+    std::vector<PlayerAction> actions(1);
+    Direction_t direction = rootDirection;
+    int firstDirection = -1;
+    unsigned int depth = 0;
+
+    // Down the tree by UCB1 until a direction that wasn't played from there yet is added
+    std::int32_t node = 0;
+    worker.line.clear();
+    worker.line.push_back(node);
+    bool added = false;
+    while (!added && depth < maxTreeDepth && depth < config.rolloutDepth && game.isAlive())
+    {
+        int chosen = -1;
+        double chosenScore = 0.0;
+        double logVisits = std::log(static_cast<double>(tree[node].visits) + 1.0);
+        for (int d = 0; d < 4; ++d)
+        {
+            if (d == oppositeDirections[direction])
+            {
+                continue;
+            }
+
+            std::int32_t child = tree[node].children[d];
+            if (child < 0)
+            {
+                chosen = d;
+                break;
+            }
+            if (tree[child].lethal)
+            {
+                continue;
+            }
+
+            double visits = tree[child].visits;
+            double score = tree[child].reward / visits + exploration * std::sqrt(logVisits / visits);
+            if (chosen < 0 || score > chosenScore)
+            {
+                chosen = d;
+                chosenScore = score;
+            }
+        }
+
+        // Every way on dies right away, so the step into this node does too
+        if (chosen < 0)
+        {
+            tree[node].lethal = true;
+            return node != 0;
+        }
+
+        if (tree[node].children[chosen] < 0)
+        {
+            Node leaf = {{-1, -1, -1, -1}, 0, 0.0, false};
+            tree[node].children[chosen] = static_cast<std::int32_t>(tree.size());
+            tree.push_back(leaf);
+            added = true;
+        }
+        node = tree[node].children[chosen];
+        worker.line.push_back(node);
+        if (firstDirection < 0)
+        {
+            firstDirection = chosen;
+        }
+
+        actions[0] = PlayerAction();
+        actions[0].direction = directionKeys[chosen];
+        StepResult result = game.step(actions);
+        direction = static_cast<Direction_t>(chosen);
+        ++depth;
+        score.addStep(result.playerLength);
+
+        // A direction that runs into something is never played again, instead of making
+        // every line that goes through its node look bad
+        if (added && !game.isAlive())
+        {
+            tree[node].lethal = true;
+            return true;
+        }
+
+        if (outOfTime())
+        {
+            return false;
+        }
+    }
+
+    // Then out to the playout depth with the AI steering
+    actions[0] = PlayerAction();
+    actions[0].autopilot = true;
+    while (depth < config.rolloutDepth && game.isAlive())
+    {
+        StepResult result = game.step(actions);
+        ++depth;
+        score.addStep(result.playerLength);
+
+        if (outOfTime())
+        {
+            return false;
+        }
+    }
+
+    // A game that is already over (the player quit this step) has nothing to search
+    if (firstDirection < 0)
+    {
+        return false;
+    }
+
+    double reward;
+    if (game.isAlive())
+    {
+        double food = (score.food < -1.0) ? -1.0 : ((score.food > 2.0) ? 2.0 : score.food);
+        reward = survivalReward * (2.0 + food);
+    }
+    else
+    {
+        reward = survivalReward * depth / config.rolloutDepth;
+    }
+
+    for (std::size_t i = 0; i < worker.line.size(); ++i)
+    {
+        ++tree[worker.line[i]].visits;
+        tree[worker.line[i]].reward += reward;
+    }
+
+    rootVisits[firstDirection].fetch_add(1, std::memory_order_relaxed);
+    rootReward[firstDirection].fetch_add(static_cast<std::uint64_t>(reward * rewardScale), std::memory_order_relaxed);
+
+    return true;
+}
+
+
+
+bool MctsPlanner::outOfTime() const
+{
+    if (stopping.load(std::memory_order_relaxed))
+    {
+        return true;
+    }
+
+    return hasDeadline && std::chrono::steady_clock::now() >= searchDeadline;
+}
+
+}
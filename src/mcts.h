@@ -0,0 +1,143 @@
+
+// mcts.h
+// Monte Carlo tree search for computer snakes, played out on copies of the game across threads
+//
+
+#ifndef SLICERSNAKE_MCTS_H
+#define SLICERSNAKE_MCTS_H
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "display.h"
+#include "display_headless.h"
+#include "game.h"
+#include "random.h"
+#include "snake.h"
+
+
+namespace ssnake
+{
+
+// Root parallel search for the next direction of one snake.
+// Every thread grows its own tree of the snake's next directions from a copy of the game, playing each
+// line out for a few more steps with the food field AI steering every snake, and the visits of the first
+// directions are added up over all threads.
+// Only the snake's own moves are in the tree, so the other snakes and the food are left to the playouts.
+// Each playout places food with a new seed, so that the search doesn't know where food will really appear.
+class MctsPlanner
+{
+
+public:
+
+    // PreConditions:
+    //   config asks for playouts or for a time limit
+    //   size_x and size_y are the board size of the games that will be searched
+    // PostConditions:
+    //   The worker threads of config are started, waiting for searches
+    MctsPlanner(const MctsConfig& config, coordType size_x, coordType size_y);
+
+    // PreConditions:
+    // PostConditions:
+    //   The worker threads are stopped and joined
+    ~MctsPlanner();
+
+    MctsPlanner(const MctsPlanner&) = delete;
+    MctsPlanner& operator=(const MctsPlanner&) = delete;
+
+    // PreConditions:
+    //   root was taken from a game of the planner's board size, that has a snake at snakeIndex of its snake list
+    //   deadline is not time_point::max() if the config has no playout limit
+    // PostConditions:
+    //   Once the playouts of the config are done or deadline has passed, whichever is first,
+    //   returns true and sets direction to the snake's most played first direction,
+    //   or returns false if no playout finished in time
+    //   Returns by the deadline even if threads are still in the middle of a playout, those are left out
+    //   Without a deadline, the direction only depends on root and the config
+    bool search(const GameSnapshot& root,
+                int snakeIndex,
+                std::chrono::steady_clock::time_point deadline,
+                Direction_t& direction);
+
+
+private:
+
+    // Tree node of a line of the snake's directions, whatever the game did along it
+    struct Node
+    {
+        // Node of each next direction, -1 if it wasn't played yet
+        std::int32_t children[4];
+        std::uint32_t visits;
+        double reward;
+        // The snake dies on the step into the node, or on every step out of it
+        bool lethal;
+    };
+
+    // Everything a thread searches with
+    struct Worker
+    {
+        Worker(coordType size_x, coordType size_y);
+
+        // A headless display is one chunk wider and three taller than its board
+        HeadlessDisplay display;
+        SnakeGame game;
+
+        // The searched game with the searched snake as the player
+        GameSnapshot root;
+        Random rng;
+
+        std::vector<Node> tree;
+        std::vector<std::int32_t> line;
+    };
+
+    // Waits for searches and runs its share of each of them
+    void runThread(std::size_t worker);
+
+    // Plays out the search's share of worker until it is done or out of time
+    void runWorker(std::size_t worker);
+
+    // Plays a line down the tree and out to the playout depth, and adds its reward to the tree
+    // Returns false if the search ran out of time before the playout finished, or if every direction dies right away
+    bool playout(Worker& worker, Direction_t rootDirection);
+
+    bool outOfTime() const;
+
+    MctsConfig config;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    // Guards generation, busyThreads and shuttingDown
+    std::mutex lock;
+    std::condition_variable startSearch;
+    std::condition_variable threadsIdle;
+    std::uint64_t generation = 0;
+    std::size_t busyThreads = 0;
+    bool shuttingDown = false;
+
+    // The search in progress, only changed while every thread is idle
+    GameSnapshot searchRoot;
+    int searchIndex = 0;
+    std::chrono::steady_clock::time_point searchDeadline;
+    bool hasDeadline = false;
+    std::uint64_t searchSeed = 0;
+
+    // Set once the search has returned, so that threads stop at their next step
+    std::atomic<bool> stopping;
+
+    // Playouts and reward (in 1/65536ths) of each first direction over every thread,
+    // added to after every finished playout so that a search can return at any time
+    std::atomic<std::uint32_t> rootVisits[4];
+    std::atomic<std::uint64_t> rootReward[4];
+};
+
+}
+
+#endif
@@ -0,0 +1,316 @@
+
+#include "net.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring> // strerror, memcpy
+#include <string>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h> // TCP_NODELAY
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "display.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+const char unixPrefix[] = "unix:";
+
+// Bytes that beginMessage leaves for the size, which is written with padding so that it fits exactly
+const std::size_t sizeBytes = 4;
+
+
+
+bool isUnixAddress(const std::string& address)
+{
+    return address.compare(0, sizeof(unixPrefix) - 1, unixPrefix) == 0;
+}
+
+
+
+bool makeUnixAddress(const std::string& address, sockaddr_un& unixAddress, std::string& error)
+{
+    std::string path = getSocketPath(address);
+    if (path.empty() || path.size() >= sizeof(unixAddress.sun_path))
+    {
+        error = "bad socket path";
+        return false;
+    }
+
+    std::memset(&unixAddress, 0, sizeof(unixAddress));
+    unixAddress.sun_family = AF_UNIX;
+    std::memcpy(unixAddress.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+
+
+// Looks up the TCP address "HOST:PORT", returns nullptr and sets error if it couldn't
+addrinfo* lookUp(const std::string& address, bool listening, std::string& error)
+{
+    std::size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon + 1 == address.size())
+    {
+        error = "expected unix:PATH or HOST:PORT";
+        return nullptr;
+    }
+
+    std::string host = address.substr(0, colon);
+    std::string port = address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+    {
+        host = host.substr(1, host.size() - 2);
+    }
+    // An address without a host stays on this machine
+    if (host.empty())
+    {
+        host = "localhost";
+    }
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+
+    addrinfo* found = nullptr;
+    int result = getaddrinfo(host.c_str(), port.c_str(), &hints, &found);
+    if (result != 0)
+    {
+        error = gai_strerror(result);
+        return nullptr;
+    }
+
+    return found;
+}
+
+}
+
+
+
+void putNumber(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<std::uint8_t>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+
+
+bool getNumber(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value)
+{
+    value = 0;
+    const std::uint8_t* at = data;
+    for (int shift = 0; shift < 64 && at < end; shift += 7, ++at)
+    {
+        value |= static_cast<std::uint64_t>(*at & 0x7F) << shift;
+        if ((*at & 0x80) == 0)
+        {
+            data = at + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+bool getCoord(const std::uint8_t*& data, const std::uint8_t* end, coordType& coord)
+{
+    std::uint64_t value;
+    if (!getNumber(data, end, value) || value > 0x7FFFFFFF)
+    {
+        return false;
+    }
+
+    coord = static_cast<coordType>(value);
+    return true;
+}
+
+
+
+std::size_t beginMessage(std::vector<std::uint8_t>& out, ServerMessage_t type)
+{
+    std::size_t start = out.size();
+    out.push_back(static_cast<std::uint8_t>(type));
+    out.resize(out.size() + sizeBytes);
+    return start;
+}
+
+
+
+void endMessage(std::vector<std::uint8_t>& out, std::size_t start)
+{
+    std::size_t size = out.size() - start - 1 - sizeBytes;
+
+    // Every byte but the last has the top bit set, even the ones that are only padding
+    for (std::size_t i = 0; i < sizeBytes; ++i)
+    {
+        std::uint8_t bits = static_cast<std::uint8_t>((size >> (7 * i)) & 0x7F);
+        out[start + 1 + i] = (i + 1 < sizeBytes) ? (bits | 0x80) : bits;
+    }
+}
+
+
+
+bool parseMessage(const std::uint8_t* data, const std::uint8_t* end,
+                  std::uint8_t& type, const std::uint8_t*& payload, std::size_t& payloadSize, std::size_t& size)
+{
+    if (data >= end)
+    {
+        return false;
+    }
+
+    const std::uint8_t* at = data + 1;
+    std::uint64_t rest;
+    if (!getNumber(at, end, rest) || rest > static_cast<std::uint64_t>(end - at))
+    {
+        return false;
+    }
+
+    type = data[0];
+    payload = at;
+    payloadSize = static_cast<std::size_t>(rest);
+    size = static_cast<std::size_t>(at - data) + payloadSize;
+    return true;
+}
+
+
+
+std::string getSocketPath(const std::string& address)
+{
+    if (!isUnixAddress(address))
+    {
+        return std::string();
+    }
+
+    return address.substr(sizeof(unixPrefix) - 1);
+}
+
+
+
+bool listenSocket(const std::string& address, int& fd, std::string& error)
+{
+    fd = -1;
+
+    if (isUnixAddress(address))
+    {
+        sockaddr_un unixAddress;
+        if (!makeUnixAddress(address, unixAddress, error))
+        {
+            return false;
+        }
+
+        // Only a socket is replaced, never a file that happens to have the name
+        struct stat status;
+        if (stat(unixAddress.sun_path, &status) == 0 && S_ISSOCK(status.st_mode))
+        {
+            unlink(unixAddress.sun_path);
+        }
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && bind(fd, reinterpret_cast<sockaddr*>(&unixAddress), sizeof(unixAddress)) == 0
+            && listen(fd, SOMAXCONN) == 0)
+        {
+            return true;
+        }
+    }
+    else
+    {
+        addrinfo* found = lookUp(address, true, error);
+        if (found == nullptr)
+        {
+            return false;
+        }
+
+        fd = socket(found->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int reuse = 1;
+        bool listening = fd >= 0
+                         && setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == 0
+                         && bind(fd, found->ai_addr, found->ai_addrlen) == 0
+                         && listen(fd, SOMAXCONN) == 0;
+        int failure = errno;
+        freeaddrinfo(found);
+        if (listening)
+        {
+            return true;
+        }
+        errno = failure;
+    }
+
+    error = std::strerror(errno);
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return false;
+}
+
+
+
+bool connectSocket(const std::string& address, int& fd, std::string& error)
+{
+    fd = -1;
+
+    if (isUnixAddress(address))
+    {
+        sockaddr_un unixAddress;
+        if (!makeUnixAddress(address, unixAddress, error))
+        {
+            return false;
+        }
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&unixAddress), sizeof(unixAddress)) == 0)
+        {
+            return true;
+        }
+    }
+    else
+    {
+        addrinfo* found = lookUp(address, false, error);
+        if (found == nullptr)
+        {
+            return false;
+        }
+
+        // Turns are a byte each, and shouldn't wait to be sent together with the next one
+        fd = socket(found->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int noDelay = 1;
+        bool connected = fd >= 0
+                         && connect(fd, found->ai_addr, found->ai_addrlen) == 0
+                         && setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)) == 0;
+        int failure = errno;
+        freeaddrinfo(found);
+        if (connected)
+        {
+            return true;
+        }
+        errno = failure;
+    }
+
+    error = std::strerror(errno);
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,101 @@
+
+// net.h
+// Sockets and messages of multiplayer games
+//
+
+#ifndef SLICERSNAKE_NET_H
+#define SLICERSNAKE_NET_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "display.h" // coordType
+
+
+namespace ssnake
+{
+
+// Messages from the server are a type byte, the size of the rest, then the rest.
+// Numbers are written 7 bits at a time, low bits first, with the top bit set on every byte but the last.
+//   MSG_WELCOME   player, display size x, display size y (the size the server's display was created with)
+//   MSG_KEYFRAME  frame, microseconds since the frame before it, then the whole board as events (see display_delta.h)
+//   MSG_DELTA     frame, microseconds since the frame before it, then the events of the frame (see display_delta.h)
+//   MSG_PLAYER    1 if the player has a snake, its length, head x, head y, players in the game;
+//                 always the last message of a step
+enum ServerMessage_t
+{
+    MSG_WELCOME = 1, MSG_KEYFRAME, MSG_DELTA, MSG_PLAYER
+};
+
+
+
+// Messages from a client are single bytes: a DirectionalKey_t to turn, or one of these
+enum ClientMessage_t
+{
+    MSG_SPAWN = 0x10, MSG_QUIT = 0x11
+};
+
+
+
+// PreConditions:
+// PostConditions:
+//   value is appended to out as a number
+void putNumber(std::vector<std::uint8_t>& out, std::uint64_t value);
+
+// PreConditions:
+//   data is at most end
+// PostConditions:
+//   Returns true, sets value to the number at data and moves data past it,
+//   or returns false if the number doesn't end before end
+bool getNumber(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value);
+
+// PreConditions:
+//   data is at most end
+// PostConditions:
+//   Like getNumber, but also returns false if the number is too large for a coordinate
+bool getCoord(const std::uint8_t*& data, const std::uint8_t* end, coordType& coord);
+
+// PreConditions:
+// PostConditions:
+//   A message of type is started at the end of out, returns where it starts for endMessage
+std::size_t beginMessage(std::vector<std::uint8_t>& out, ServerMessage_t type);
+
+// PreConditions:
+//   start was returned by beginMessage on out, and the message is less than 256 MB
+// PostConditions:
+//   The size of the message that starts at start is filled in, so that it is complete
+void endMessage(std::vector<std::uint8_t>& out, std::size_t start);
+
+// PreConditions:
+// PostConditions:
+//   Returns true if a whole message starts at data, with type set to its type and payload and payloadSize to the rest
+//   of it, and size to the size of the whole message
+//   Returns false if there is not a whole message before end yet
+bool parseMessage(const std::uint8_t* data, const std::uint8_t* end,
+                  std::uint8_t& type, const std::uint8_t*& payload, std::size_t& payloadSize, std::size_t& size);
+
+// Addresses are "unix:PATH" for a Unix socket, or "HOST:PORT" for TCP, where HOST can be left out for localhost.
+
+// PreConditions:
+// PostConditions:
+//   Returns true and sets fd to a non-blocking socket listening on address,
+//   or returns false and sets error to why it couldn't
+//   A Unix socket that is left over from an earlier server is replaced
+bool listenSocket(const std::string& address, int& fd, std::string& error);
+
+// PreConditions:
+// PostConditions:
+//   Returns true and sets fd to a blocking socket connected to address,
+//   or returns false and sets error to why it couldn't
+bool connectSocket(const std::string& address, int& fd, std::string& error);
+
+// PreConditions:
+// PostConditions:
+//   Returns the path of the file of a Unix socket address, or an empty string for a TCP address
+std::string getSocketPath(const std::string& address);
+
+}
+
+#endif
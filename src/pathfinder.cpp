@@ -0,0 +1,265 @@
+
+#include "pathfinder.h"
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+#include "display.h"
+#include "snake.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// Neighbours are always looked at in Direction_t order, so searches are deterministic
+const Direction_t stepDirections[4] = {RIGHT, LEFT, UP, DOWN};
+
+}
+
+
+
+const std::uint32_t Pathfinder::wallMark;
+
+
+
+Pathfinder::Pathfinder(std::size_t searchLimit)
+{
+    assert(searchLimit > 0);
+
+    this->searchLimit = searchLimit;
+}
+
+
+
+bool Pathfinder::findDirection(const Board& board, const Vec2& head, Direction_t& direction)
+{
+    if (board.getSize_x() != size.x || board.getSize_y() != size.y)
+    {
+        resize(board);
+    }
+
+    // Start over with fresh marks before the counter reaches wallMark
+    ++searchMark;
+    if (searchMark == wallMark)
+    {
+        for (std::size_t i = 0; i < visitMark.size(); ++i)
+        {
+            if (visitMark[i] != wallMark)
+            {
+                visitMark[i] = 0;
+            }
+        }
+        for (std::size_t i = 0; i < seenCells.size(); ++i)
+        {
+            seenCells[i].mark = 0;
+        }
+        searchMark = 1;
+    }
+
+    if (sparse)
+    {
+        return findDirectionSparse(board, head, direction);
+    }
+
+    const std::vector<BoardCell>& cells = board.getCells();
+
+    // Cells next to an open cell are never outside of the board, since the border is closed
+    const std::ptrdiff_t stepOffsets[4] = {1, -1, -size.x, size.x};
+
+    std::uint32_t headIndex = static_cast<std::uint32_t>(head.y * size.x + head.x);
+    visitMark[headIndex] = searchMark;
+    queue.clear();
+
+    // Number of cells seen behind each first step, for when no food is in reach
+    std::size_t branchSize[4] = {0, 0, 0, 0};
+
+    // The first steps are seen like any other cell, except that they start their own branch
+    queue.push_back(headIndex);
+    for (std::size_t front = 0; front < queue.size() && queue.size() < searchLimit; ++front)
+    {
+        std::uint32_t cell = queue[front];
+
+        for (int d = 0; d < 4; ++d)
+        {
+            std::uint32_t next = static_cast<std::uint32_t>(cell + stepOffsets[d]);
+            if (visitMark[next] == searchMark || visitMark[next] == wallMark)
+            {
+                continue;
+            }
+
+            int owner = cells[next].owner;
+            if (owner != OWNER_EMPTY && owner != OWNER_FOOD)
+            {
+                continue;
+            }
+
+            std::uint8_t step = (front == 0) ? static_cast<std::uint8_t>(d) : firstStep[cell];
+            if (owner == OWNER_FOOD)
+            {
+                direction = stepDirections[step];
+                return true;
+            }
+
+            visitMark[next] = searchMark;
+            firstStep[next] = step;
+            ++branchSize[step];
+            queue.push_back(next);
+        }
+    }
+
+    // No food in reach, so head for the most room
+    return pickMostRoom(branchSize, direction);
+}
+
+
+
+bool Pathfinder::findDirectionSparse(const Board& board, const Vec2& head, Direction_t& direction)
+{
+    // Same search as findDirection, with positions instead of indexes and the border checked by position
+    const Vec2 steps[4] = {{1, 0}, {-1, 0}, {0, -1}, {0, 1}};
+
+    std::uint64_t headIndex = static_cast<std::uint64_t>(head.y) * size.x + head.x;
+    SeenCell& headSeen = findSeen(headIndex);
+    headSeen.index = headIndex;
+    headSeen.mark = searchMark;
+    sparseQueue.clear();
+
+    std::size_t branchSize[4] = {0, 0, 0, 0};
+
+    sparseQueue.push_back({head, 0});
+    for (std::size_t front = 0; front < sparseQueue.size() && sparseQueue.size() < searchLimit; ++front)
+    {
+        QueuedCell cell = sparseQueue[front];
+
+        for (int d = 0; d < 4; ++d)
+        {
+            Vec2 next = {cell.pos.x + steps[d].x, cell.pos.y + steps[d].y};
+            if (next.x <= 0 || next.y <= 0 || next.x >= size.x - 1 || next.y >= size.y - 1)
+            {
+                continue;
+            }
+
+            std::uint64_t nextIndex = static_cast<std::uint64_t>(next.y) * size.x + next.x;
+            SeenCell& seen = findSeen(nextIndex);
+            if (seen.mark == searchMark)
+            {
+                continue;
+            }
+
+            int owner = board.getCell(next).owner;
+            if (owner != OWNER_EMPTY && owner != OWNER_FOOD)
+            {
+                continue;
+            }
+
+            std::uint8_t step = (front == 0) ? static_cast<std::uint8_t>(d) : cell.firstStep;
+            if (owner == OWNER_FOOD)
+            {
+                direction = stepDirections[step];
+                return true;
+            }
+
+            seen.index = nextIndex;
+            seen.mark = searchMark;
+            ++branchSize[step];
+            sparseQueue.push_back({next, step});
+        }
+    }
+
+    return pickMostRoom(branchSize, direction);
+}
+
+
+
+Pathfinder::SeenCell& Pathfinder::findSeen(std::uint64_t index)
+{
+    // Fibonacci hashing, so that the cells of a row or a column don't crowd each other
+    std::size_t mask = seenCells.size() - 1;
+    std::size_t slot = static_cast<std::size_t>((index * 0x9E3779B97F4A7C15ull) >> seenShift);
+    while (seenCells[slot].mark == searchMark && seenCells[slot].index != index)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return seenCells[slot];
+}
+
+
+
+bool Pathfinder::pickMostRoom(const std::size_t branchSize[4], Direction_t& direction)
+{
+    int best = -1;
+    for (int d = 0; d < 4; ++d)
+    {
+        if (branchSize[d] == 0)
+        {
+            continue;
+        }
+        if (best < 0 || branchSize[d] > branchSize[best]
+            || (branchSize[d] == branchSize[best] && stepDirections[d] == direction))
+        {
+            best = d;
+        }
+    }
+
+    if (best < 0)
+    {
+        return false;
+    }
+
+    direction = stepDirections[best];
+    return true;
+}
+
+
+
+void Pathfinder::resize(const Board& board)
+{
+    size.x = board.getSize_x();
+    size.y = board.getSize_y();
+    sparse = board.isSparse();
+    searchMark = 0;
+
+    if (sparse)
+    {
+        visitMark.clear();
+        visitMark.shrink_to_fit();
+        firstStep.clear();
+        firstStep.shrink_to_fit();
+
+        // A search sees at most searchLimit cells and the up to 3 seen along with the last one
+        std::size_t capacity = 1;
+        seenShift = 64;
+        while (capacity < (searchLimit + 4) * 4)
+        {
+            capacity *= 2;
+            --seenShift;
+        }
+        seenCells.assign(capacity, SeenCell{0, 0});
+        return;
+    }
+
+    seenCells.clear();
+
+    std::size_t cellCount = static_cast<std::size_t>(size.x) * size.y;
+    visitMark.assign(cellCount, 0);
+    firstStep.assign(cellCount, 0);
+
+    for (coordType y = 0; y < size.y; ++y)
+    {
+        for (coordType x = 0; x < size.x; ++x)
+        {
+            if (x == 0 || y == 0 || x == size.x - 1 || y == size.y - 1)
+            {
+                visitMark[static_cast<std::size_t>(y) * size.x + x] = wallMark;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,102 @@
+
+// pathfinder.h
+// Breadth first search to food, for computer snakes
+//
+
+#ifndef SLICERSNAKE_PATHFINDER_H
+#define SLICERSNAKE_PATHFINDER_H
+
+
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+#include "display.h"
+#include "snake.h"
+
+
+namespace ssnake
+{
+
+// Finds the first step of a shortest path to the closest food, going around the border and every snake.
+// Each search looks at no more than searchLimit cells, so its cost doesn't grow with the board.
+// One pathfinder can be shared by every snake of a game, since searches don't keep anything.
+// On sparse boards the cells a search has seen are kept in a small hash table instead of a mark for every cell,
+// so the pathfinder takes no more memory than its search limit needs whatever the size of the board.
+class Pathfinder
+{
+
+public:
+
+    // PreConditions:
+    //   searchLimit is greater than 0
+    // PostConditions:
+    //   A pathfinder is created that looks at no more than searchLimit cells per search
+    explicit Pathfinder(std::size_t searchLimit = 1024);
+
+    // PreConditions:
+    //   head is inside of the border of board
+    // PostConditions:
+    //   If food is found within the search limit, direction is set to the first step towards the closest one.
+    //   Otherwise direction is set to the step with the most open cells behind it, keeping the current
+    //   direction on ties.
+    //   Returns false, leaving direction alone, if every step from head is blocked
+    bool findDirection(const Board& board, const Vec2& head, Direction_t& direction);
+
+
+private:
+
+    // A cell of a sparse board seen by the search with searchMark mark
+    struct SeenCell
+    {
+        std::uint64_t index;
+        std::uint32_t mark;
+    };
+
+    // A cell waiting to be looked at on a sparse board, and the direction of the first step on the way to it
+    struct QueuedCell
+    {
+        Vec2 pos;
+        std::uint8_t firstStep;
+    };
+
+    // Sets up the buffers for a board of the given size
+    void resize(const Board& board);
+
+    // findDirection for sparse boards, reading cells through the board's tiles
+    bool findDirectionSparse(const Board& board, const Vec2& head, Direction_t& direction);
+
+    // Returns the entry of index in seenCells, or the free entry it would go in if the search hasn't seen it
+    SeenCell& findSeen(std::uint64_t index);
+
+    // Sets direction to the first step with the most cells seen behind it, for when no food is in reach
+    // Returns false if no step had any
+    static bool pickMostRoom(const std::size_t branchSize[4], Direction_t& direction);
+
+    std::size_t searchLimit;
+
+    // Board size the buffers are set up for
+    Vec2 size = {0, 0};
+
+    // A cell was seen in the current search if its visitMark is searchMark, so nothing is cleared between searches.
+    // Border cells are empty on the board but are still walls, so they are marked with wallMark, which is never a searchMark.
+    static const std::uint32_t wallMark = static_cast<std::uint32_t>(-1);
+    std::vector<std::uint32_t> visitMark;
+    std::uint32_t searchMark = 0;
+
+    // Direction of the first step on the way to each seen cell
+    std::vector<std::uint8_t> firstStep;
+
+    // Indexes of the cells waiting to be looked at, in the order they were seen
+    std::vector<std::uint32_t> queue;
+
+    // Cells seen on a sparse board, open addressed with room for four times the search limit
+    bool sparse = false;
+    std::vector<SeenCell> seenCells;
+    int seenShift = 0;
+    std::vector<QueuedCell> sparseQueue;
+};
+
+}
+
+#endif
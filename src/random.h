@@ -0,0 +1,84 @@
+
+// random.h
+// Small seedable random number generator, one per game
+//
+
+#ifndef SLICERSNAKE_RANDOM_H
+#define SLICERSNAKE_RANDOM_H
+
+
+#include <cstdint>
+
+
+namespace ssnake
+{
+
+// xoshiro256** generator, seeded through splitmix64.
+// The state is a plain value, so games can be copied and replayed from the same seed.
+class Random
+{
+
+public:
+
+    explicit Random(std::uint64_t seedValue = 0)
+    {
+        seed(seedValue);
+    }
+
+    // PreConditions:
+    // PostConditions:
+    //   The generator is reset to the sequence given by seedValue
+    void seed(std::uint64_t seedValue)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            seedValue += 0x9E3779B97F4A7C15ull;
+            std::uint64_t z = seedValue;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            state[i] = z ^ (z >> 31);
+        }
+    }
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the next 64 random bits
+    std::uint64_t next()
+    {
+        std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+        std::uint64_t t = state[1] << 17;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+
+        return result;
+    }
+
+    // PreConditions:
+    //   bound is greater than 0
+    // PostConditions:
+    //   Returns a number in [0, bound)
+    std::uint32_t below(std::uint32_t bound)
+    {
+        // Multiply-shift maps the high bits onto the range without a division
+        return static_cast<std::uint32_t>(((next() >> 32) * bound) >> 32);
+    }
+
+
+private:
+
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t state[4];
+};
+
+}
+
+#endif
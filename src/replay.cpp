@@ -0,0 +1,341 @@
+
+#include "replay.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // memcmp
+#include <vector>
+
+#include "display.h"
+#include "display_headless.h"
+#include "game.h"
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+const char gameMagic[4] = {'S', 'S', 'R', 'G'};
+const std::uint8_t formatVersion = 3;
+
+
+
+// Numbers are written 7 bits at a time, low bits first, with the top bit set on every byte but the last
+void writeNumber(std::FILE* file, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        std::fputc(static_cast<int>((value & 0x7F) | 0x80), file);
+        value >>= 7;
+    }
+    std::fputc(static_cast<int>(value), file);
+}
+
+
+
+bool readNumber(std::FILE* file, std::uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int c = std::fgetc(file);
+        if (c == EOF)
+        {
+            return false;
+        }
+
+        value |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+// An action fits in a byte: the two directions take 3 bits each, then quit and autopilot
+std::uint8_t packAction(const PlayerAction& action)
+{
+    return static_cast<std::uint8_t>(action.direction
+                                     | (action.prevDirection << 3)
+                                     | (action.quit ? 0x40 : 0)
+                                     | (action.autopilot ? 0x80 : 0));
+}
+
+
+
+PlayerAction unpackAction(std::uint8_t packed)
+{
+    PlayerAction action;
+    action.direction = static_cast<DirectionalKey_t>(packed & 0x07);
+    action.prevDirection = static_cast<DirectionalKey_t>((packed >> 3) & 0x07);
+    action.quit = (packed & 0x40) != 0;
+    action.autopilot = (packed & 0x80) != 0;
+    return action;
+}
+
+}
+
+
+
+ReplayWriter::~ReplayWriter()
+{
+    if (file != nullptr)
+    {
+        std::fclose(file);
+    }
+}
+
+
+
+bool ReplayWriter::open(const char* path)
+{
+    if (file != nullptr)
+    {
+        std::fclose(file);
+    }
+
+    file = std::fopen(path, "wb");
+    gameOpen = false;
+
+    return file != nullptr;
+}
+
+
+
+void ReplayWriter::beginGame(const ReplayHeader& header)
+{
+    std::fwrite(gameMagic, 1, sizeof(gameMagic), file);
+    std::fputc(formatVersion, file);
+    std::fputc(header.gameType, file);
+    writeNumber(file, header.seed);
+    writeNumber(file, static_cast<std::uint64_t>(header.size_x));
+    writeNumber(file, static_cast<std::uint64_t>(header.size_y));
+    writeNumber(file, header.arenaSnakes);
+    std::fputc(header.aiMode, file);
+    writeNumber(file, header.mctsRollouts);
+
+    gameOpen = true;
+    runLength = 0;
+}
+
+
+
+void ReplayWriter::recordStep(const PlayerAction& action)
+{
+    // Held keys give the same action step after step, so most games are only a few runs
+    std::uint8_t packed = packAction(action);
+    if (runLength > 0 && packed != runAction)
+    {
+        flushRun();
+    }
+
+    runAction = packed;
+    ++runLength;
+}
+
+
+
+void ReplayWriter::endGame(const ReplayOutcome& outcome)
+{
+    flushRun();
+
+    // A run of length 0 marks the end of the steps
+    writeNumber(file, 0);
+    writeNumber(file, outcome.steps);
+    writeNumber(file, outcome.finalLength);
+    writeNumber(file, outcome.maxLength);
+    std::fputc(outcome.cause, file);
+
+    // Games are flushed whole, so a crash doesn't lose the games that were already over
+    std::fflush(file);
+
+    gameOpen = false;
+}
+
+
+
+bool ReplayWriter::inGame() const
+{
+    return gameOpen;
+}
+
+
+
+void ReplayWriter::flushRun()
+{
+    if (runLength == 0)
+    {
+        return;
+    }
+
+    writeNumber(file, runLength);
+    std::fputc(runAction, file);
+    runLength = 0;
+}
+
+
+
+ReplayReader::~ReplayReader()
+{
+    if (file != nullptr)
+    {
+        std::fclose(file);
+    }
+}
+
+
+
+bool ReplayReader::open(const char* path)
+{
+    if (file != nullptr)
+    {
+        std::fclose(file);
+    }
+
+    file = std::fopen(path, "rb");
+    error = false;
+    runLeft = 0;
+
+    return file != nullptr;
+}
+
+
+
+bool ReplayReader::nextGame(ReplayHeader& header)
+{
+    char magic[sizeof(gameMagic)];
+    std::size_t magicRead = std::fread(magic, 1, sizeof(magic), file);
+    if (magicRead == 0)
+    {
+        return false;
+    }
+
+    std::uint64_t seed, size_x, size_y, arenaSnakes, mctsRollouts;
+    int aiMode;
+    int version = std::fgetc(file);
+    int gameType = std::fgetc(file);
+    if (magicRead != sizeof(magic) || std::memcmp(magic, gameMagic, sizeof(magic)) != 0
+        || version != formatVersion || gameType < 0 || gameType >= GM_NONE
+        || !readNumber(file, seed) || !readNumber(file, size_x) || !readNumber(file, size_y)
+        || !readNumber(file, arenaSnakes)
+        || (aiMode = std::fgetc(file)) < AI_SIMPLE || aiMode > AI_MCTS
+        || !readNumber(file, mctsRollouts))
+    {
+        error = true;
+        return false;
+    }
+
+    header.gameType = static_cast<Game_t>(gameType);
+    header.seed = seed;
+    header.size_x = static_cast<coordType>(size_x);
+    header.size_y = static_cast<coordType>(size_y);
+    header.arenaSnakes = static_cast<std::uint32_t>(arenaSnakes);
+    header.aiMode = static_cast<AiMode_t>(aiMode);
+    header.mctsRollouts = static_cast<std::uint32_t>(mctsRollouts);
+
+    outcome = ReplayOutcome();
+    runLeft = 0;
+
+    return true;
+}
+
+
+
+bool ReplayReader::nextStep(PlayerAction& action)
+{
+    if (runLeft == 0)
+    {
+        std::uint64_t runLength;
+        if (!readNumber(file, runLength))
+        {
+            error = true;
+            return false;
+        }
+
+        if (runLength == 0)
+        {
+            std::uint64_t steps, finalLength, maxLength;
+            int cause;
+            if (!readNumber(file, steps) || !readNumber(file, finalLength) || !readNumber(file, maxLength)
+                || (cause = std::fgetc(file)) < DEATH_NONE || cause > DEATH_QUIT)
+            {
+                error = true;
+                return false;
+            }
+
+            outcome.steps = static_cast<unsigned long>(steps);
+            outcome.finalLength = static_cast<std::size_t>(finalLength);
+            outcome.maxLength = static_cast<std::size_t>(maxLength);
+            outcome.cause = static_cast<DeathCause_t>(cause);
+            return false;
+        }
+
+        int packed = std::fgetc(file);
+        if (packed == EOF)
+        {
+            error = true;
+            return false;
+        }
+
+        runAction = static_cast<std::uint8_t>(packed);
+        runLeft = static_cast<unsigned long>(runLength);
+    }
+
+    action = unpackAction(runAction);
+    --runLeft;
+
+    return true;
+}
+
+
+
+const ReplayOutcome& ReplayReader::getOutcome() const
+{
+    return outcome;
+}
+
+
+
+bool ReplayReader::failed() const
+{
+    return error;
+}
+
+
+
+ReplayOutcome playReplay(ReplayReader& reader, const ReplayHeader& header)
+{
+    // A headless display is one chunk wider and three taller than its board
+    HeadlessDisplay display(header.size_x + 1, header.size_y + 3);
+    SnakeGame game(&display);
+    game.setArenaSnakeCount(header.arenaSnakes);
+    game.setAiMode(header.aiMode);
+    if (header.mctsRollouts > 0)
+    {
+        MctsConfig mctsConfig;
+        mctsConfig.rollouts = header.mctsRollouts;
+        game.setMctsConfig(mctsConfig);
+    }
+    game.newGame(header.gameType, header.seed);
+
+    std::vector<PlayerAction> actions(1);
+    while (reader.nextStep(actions[0]))
+    {
+        game.step(actions);
+    }
+
+    ReplayOutcome outcome;
+    outcome.steps = game.getStepCount();
+    outcome.finalLength = game.getPlayerLength();
+    outcome.maxLength = game.getMaxLength();
+    outcome.cause = game.getDeathCause();
+    return outcome;
+}
+
+}
@@ -0,0 +1,178 @@
+
+// replay.h
+// Records games as their seed and player input, and plays them back headless
+//
+
+#ifndef SLICERSNAKE_REPLAY_H
+#define SLICERSNAKE_REPLAY_H
+
+
+#include <cstdint>
+#include <cstdio>
+
+#include "display.h"
+#include "game.h"
+
+
+namespace ssnake
+{
+
+// Everything needed to set up the same game again
+struct ReplayHeader
+{
+    Game_t gameType = GM_NONE;
+    std::uint64_t seed = 0;
+
+    // Size of the board (not of the display)
+    coordType size_x = 0;
+    coordType size_y = 0;
+
+    // Computer snakes asked for in arena games
+    std::uint32_t arenaSnakes = 0;
+
+    AiMode_t aiMode = AI_SIMPLE;
+
+    // Playouts per move of AI_MCTS, 0 if it searched against the clock, which doesn't play back the same
+    std::uint32_t mctsRollouts = 0;
+};
+
+
+
+// How a recorded game ended, so that playback can tell if it still plays out the same
+struct ReplayOutcome
+{
+    unsigned long steps = 0;
+    std::size_t finalLength = 0;
+    std::size_t maxLength = 0;
+
+    // DEATH_NONE if the game was stopped before it was over
+    DeathCause_t cause = DEATH_NONE;
+};
+
+
+
+// Writes games to a replay file as they are played.
+// A file holds any number of games back to back. Each game is a header, the player's action
+// of every step stored as runs of identical actions, and the outcome.
+// Games are written as they go, so only the run in progress is kept in memory.
+class ReplayWriter
+{
+
+public:
+
+    ReplayWriter() {};
+    ~ReplayWriter();
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    // PreConditions:
+    // PostConditions:
+    //   The file at path is created (or replaced) for writing games to
+    //   Returns false if it couldn't be opened
+    bool open(const char* path);
+
+    // PreConditions:
+    //   The writer is open, and the previous game was ended
+    // PostConditions:
+    //   A new game with the given header is started in the file
+    void beginGame(const ReplayHeader& header);
+
+    // PreConditions:
+    //   A game was begun
+    // PostConditions:
+    //   action is recorded as the player's action for the next step
+    void recordStep(const PlayerAction& action);
+
+    // PreConditions:
+    //   A game was begun
+    // PostConditions:
+    //   The game is finished with outcome, and written out
+    void endGame(const ReplayOutcome& outcome);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true between beginGame and endGame
+    bool inGame() const;
+
+
+private:
+
+    // Writes out the run of identical actions in progress
+    void flushRun();
+
+    std::FILE* file = nullptr;
+    bool gameOpen = false;
+
+    std::uint8_t runAction = 0;
+    unsigned long runLength = 0;
+};
+
+
+
+// Reads the games of a replay file written by ReplayWriter, in order
+class ReplayReader
+{
+
+public:
+
+    ReplayReader() {};
+    ~ReplayReader();
+
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+    // PreConditions:
+    // PostConditions:
+    //   The file at path is opened for reading games from
+    //   Returns false if it couldn't be opened
+    bool open(const char* path);
+
+    // PreConditions:
+    //   The reader is open, and every action of the previous game was read
+    // PostConditions:
+    //   Returns true and sets header to the next game's header, or returns false if there are no more games
+    bool nextGame(ReplayHeader& header);
+
+    // PreConditions:
+    //   nextGame returned true
+    // PostConditions:
+    //   Returns true and sets action to the player's action for the next step,
+    //   or returns false once the game has no more steps
+    bool nextStep(PlayerAction& action);
+
+    // PreConditions:
+    //   nextStep returned false
+    // PostConditions:
+    //   Returns the recorded outcome of the game
+    const ReplayOutcome& getOutcome() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if the file was cut short or isn't a replay file
+    bool failed() const;
+
+
+private:
+
+    std::FILE* file = nullptr;
+    bool error = false;
+
+    std::uint8_t runAction = 0;
+    unsigned long runLeft = 0;
+
+    ReplayOutcome outcome;
+};
+
+
+
+// PreConditions:
+//   reader has just returned header from nextGame
+// PostConditions:
+//   The game is played again through SnakeGame::step with a headless display, as fast as possible
+//   Returns how the game ended this time
+ReplayOutcome playReplay(ReplayReader& reader, const ReplayHeader& header);
+
+}
+
+#endif
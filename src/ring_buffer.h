@@ -0,0 +1,133 @@
+
+// ring_buffer.h
+// Growable contiguous double ended queue, for snake bodies
+//
+
+#ifndef SLICERSNAKE_RING_BUFFER_H
+#define SLICERSNAKE_RING_BUFFER_H
+
+
+#include <cstdlib> // size_t
+#include <cassert>
+#include <vector>
+
+
+namespace ssnake
+{
+
+// Elements are pushed at the back and removed from the front.
+// Storage is a power of two sized array that is only reallocated when it is full,
+// so moving a snake never allocates once its body has reached its longest length.
+template <typename T>
+class RingBuffer
+{
+
+public:
+
+    RingBuffer() : data(minCapacity) {};
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of elements in the buffer
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if the buffer contains no elements
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    // PreConditions:
+    //   i is less than size()
+    // PostConditions:
+    //   Returns the element i places after the front
+    T& operator[](std::size_t i)
+    {
+        assert(i < count);
+        return data[(first + i) & (data.size() - 1)];
+    }
+
+    const T& operator[](std::size_t i) const
+    {
+        assert(i < count);
+        return data[(first + i) & (data.size() - 1)];
+    }
+
+    // PreConditions:
+    //   The buffer is not empty
+    // PostConditions:
+    //   Returns the first or last element
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[count - 1]; }
+    const T& back() const { return (*this)[count - 1]; }
+
+    // PreConditions:
+    // PostConditions:
+    //   value is added after the last element, growing the storage if it is full
+    void push_back(const T& value)
+    {
+        if (count == data.size())
+        {
+            grow();
+        }
+
+        data[(first + count) & (data.size() - 1)] = value;
+        ++count;
+    }
+
+    // PreConditions:
+    //   n is not larger than size()
+    // PostConditions:
+    //   The first n elements are removed
+    void pop_front(std::size_t n = 1)
+    {
+        assert(n <= count);
+
+        first = (first + n) & (data.size() - 1);
+        count -= n;
+    }
+
+    // PreConditions:
+    // PostConditions:
+    //   All elements are removed, storage is kept
+    void clear()
+    {
+        first = 0;
+        count = 0;
+    }
+
+
+private:
+
+    static const std::size_t minCapacity = 16;
+
+    // Doubles the storage, moving the elements to the start of it
+    void grow()
+    {
+        std::vector<T> larger(data.size() * 2);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            larger[i] = (*this)[i];
+        }
+
+        data.swap(larger);
+        first = 0;
+    }
+
+    // Size is always a power of two, so indexes wrap with a mask
+    std::vector<T> data;
+
+    // Index in data of the front element
+    std::size_t first = 0;
+    std::size_t count = 0;
+};
+
+}
+
+#endif
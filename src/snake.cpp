@@ -1,430 +1,656 @@
-
-#include "snake.h"
-
-#include <list>
-#include <cstdlib> // rand
-#include <cassert>
-
-#include "display.h"
-
-
-namespace ssnake
-{
-
-Snake::Snake(Display* displayHandle,
-             const SnakeTextureList& textureList,
-             const Vec2& startingPos,
-             const size_t startingLength)
-{
-    display = displayHandle;
-
-    Vec2 win = {display->getSize_x(), display->getSize_y()};
-
-    snakeTextures = textureList;
-
-    // starting directions depend on starting postions
-    // so don't immediately face a wall
-    if (startingPos.x < (win.x / 2))
-    {
-        direction = RIGHT;
-    }
-    else
-    {
-        direction = LEFT;
-    }
-
-    // For now, truncate requested length if length doesn't fit
-    if (static_cast<size_t>(startingPos.x) < startingLength)
-    {
-        length = startingPos.x;
-    }
-    else
-    {
-        length = startingLength;
-    }
-
-    // initialize positions
-    int directionModifier = 1;
-    if (direction == RIGHT)
-    {
-        directionModifier = -1;
-    }
-    for (int i = length - 1; i >= 0; --i)
-    {
-        Vec2 coord;
-        coord.x = startingPos.x + directionModifier*i;
-        coord.y = startingPos.y;
-        if (coord.x > 0 && coord.x < win.x && coord.y > 0 && coord.y < win.y)
-        {
-            pos.push_back(coord);
-        }
-    }
-}
-
-
-
-void Snake::ai_getDirection(const std::list<Vec2>& foodList)
-{
-    if (pos.empty())
-    {
-        return;
-    }
-
-    Vec2 coord = pos.back();
-    Vec2 win = {display->getSize_x(), display->getSize_y()};
-
-    Direction_t ai_dir = direction;
-    Direction_t newDir = ai_dir;
-
-    int xOffset = win.x - coord.x;
-    int yOffset = win.y - coord.y;
-
-    // prevent hitting wall
-    if (coord.x < 4 || coord.y < 4 || xOffset < 4 || yOffset < 4)
-    {
-        if (ai_dir != LEFT && coord.x < 4)
-        {
-            newDir = RIGHT;
-        }
-        else if (ai_dir != RIGHT && xOffset < 4)
-        {
-            newDir = LEFT;
-        }
-        if (ai_dir != UP && coord.y < 4)
-        {
-            newDir = DOWN;
-        }
-        else if (ai_dir != DOWN && yOffset < 4)
-        {
-            newDir = UP;
-        }
-        // if can't go backwards have to do multi-step turn around
-        if ((ai_dir == LEFT && coord.x < 4) || (ai_dir == RIGHT && xOffset < 4))
-        {
-            if ((rand() % 2) == 1 && coord.y > 4)
-            {
-                newDir = UP;
-            }
-            else if (yOffset > 4)
-            {
-                newDir = DOWN;
-            }
-            else
-            {
-                newDir = UP;
-            }
-        }
-        if ((ai_dir == UP && coord.y < 4) || (ai_dir == DOWN && yOffset < 4))
-        {
-            if ((rand() % 2) == 1 && coord.x > 4)
-            {
-                newDir = RIGHT;
-            }
-            else if (xOffset > 4)
-            {
-                newDir = LEFT;
-            }
-            else
-            {
-                newDir = RIGHT;
-            }
-        }
-    } // end if (coord.x < 4 || coord.y < 4 || xOffset < 4 || yOffset < 4)
-    else // not near wall, so evasive maneuvers not required, do something else
-    {
-        // random movement every so often
-        if (coord.x > 3 && coord.y > 3 && xOffset > 3 && yOffset > 3)
-        {
-            int randn = rand() % 16;
-            if (ai_dir == DOWN || ai_dir == UP)
-            {
-                if (randn == 1)
-                {
-                    newDir = LEFT;
-                }
-                else if (randn == 2)
-                {
-                    newDir = RIGHT;
-                }
-            }
-            else
-            {
-                if (randn == 1)
-                {
-                    newDir = UP;
-                }
-                else if (randn == 2)
-                {
-                    newDir = DOWN;
-                }
-            }
-        }
-
-        // Only go for food if close to it and not near a wall
-        for (std::list<Vec2>::const_iterator food = foodList.cbegin(); food != foodList.cend(); ++food)
-        {
-            if (ai_dir != LEFT && (food->x - coord.x) <= 3 && food->x > coord.x && food->x <= (win.x-4))
-            {
-                newDir = RIGHT;
-                break;
-            }
-            else if (ai_dir != RIGHT && (coord.x - food->x) <= 3 && coord.x > food->x && food->x >= 4)
-            {
-                newDir = LEFT;
-                break;
-            }
-            else if (ai_dir != DOWN && (coord.y - food->y) <= 3 && coord.y > food->y && food->y >= 4)
-            {
-                newDir = UP;
-                break;
-            }
-            else if (ai_dir != UP && (food->y - coord.y) <= 3 && food->y > coord.y && food->y <= (win.y-4))
-            {
-                newDir = DOWN;
-                break;
-            }
-        }
-    }
-
-    direction = newDir;
-
-    return;
-}
-
-
-
-bool Snake::checkCollision()
-{
-    // head collision with other snake will leave snake empty from checkslice
-    if (pos.empty())
-    {
-        return true;
-    }
-
-    Vec2 win = {display->getSize_x(), display->getSize_y()};
-
-    Vec2 head = pos.back();
-
-    // wall collision
-    if (head.x >= (win.x - 1) || head.x <= 0 || head.y >= (win.y - 1) || head.y <= 0)
-    {
-        display->drawTexture(TEXTURE_COLLISION, head);
-
-        return true;
-    }
-
-
-    // self collision
-    // If checkSlice with itself happens first, then any collision segment will be removed
-    if (pos.size() > 4)
-    {
-        // It isn't possible to self-hit segments just before the head
-        int checkLength = pos.size() - 4;
-        std::list<Vec2>::const_iterator it = pos.cbegin();
-        for (int i = 0; i < checkLength; ++i, ++it)
-        {
-            if (head.x == it->x && head.y == it->y)
-            {
-                return true;
-            }
-        }
-    }
-
-    return false;
-}
-
-
-
-bool Snake::checkFood(const Vec2& food)
-{
-    if (pos.empty())
-    {
-        return false;
-    }
-
-    Vec2 snakeHead = pos.back();
-
-    if (snakeHead.y != food.y || snakeHead.x != food.x)
-    {
-        return false;
-    }
-
-    ++length;
-
-    return true;
-}
-
-
-
-bool Snake::checkTouch(const Vec2& checkedPos) const
-{
-    if (pos.empty())
-    {
-        return false;
-    }
-
-    for (std::list<Vec2>::const_iterator it = pos.cbegin(); it != pos.cend(); ++it)
-    {
-        if (checkedPos.x == it->x && checkedPos.y == it->y)
-        {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-
-
-size_t Snake::checkSlice(std::list<Snake>& snakeList)
-{
-    if (pos.empty())
-    {
-        return 0;
-    }
-
-    size_t totalCount = 0;
-
-    Vec2 ss_coord = pos.back();
-
-    for (std::list<Snake>::iterator slicedIter = snakeList.begin(); slicedIter != snakeList.end(); ++slicedIter)
-    {
-        if (slicedIter->pos.empty())
-        {
-            continue;
-        }
-
-        Vec2 sd_coord;
-
-        int checkSize = slicedIter->pos.size();
-
-        // Decrease collision-checksize by 1 as work-around to make snake not collide with it's own head
-        // It can't actually hit the three segments behind head, so subtracting 3 more allows skipping checking those
-        if (this == &(*slicedIter))
-        {
-            checkSize -= 4;
-            if (checkSize < 0)
-            {
-                checkSize = 0;
-            }
-        }
-
-        std::list<Vec2>::iterator it = slicedIter->pos.begin();
-        std::list<Vec2>::iterator cut;
-        for (int i = 1; i <= checkSize; ++i)
-        {
-            sd_coord = *it++;
-
-            if (ss_coord.x == sd_coord.x && ss_coord.y == sd_coord.y)
-            {
-                cut = it;
-                totalCount += i;
-
-                assert(static_cast<int>(slicedIter->length) >= i);
-                slicedIter->length -= i;
-
-                if (slicedIter->length != 0)
-                {
-                    for (it = slicedIter->pos.begin(); it != cut; ++it)
-                    {
-                        display->drawTexture(TEXTURE_BACKGROUND, *it);
-                    }
-                }
-                slicedIter->pos.erase(slicedIter->pos.begin(), cut);
-
-                break;
-            }
-        }
-    }
-
-    return totalCount;
-}
-
-
-
-Direction_t Snake::getDirection() const
-{
-    return direction;
-}
-
-
-
-size_t Snake::getLength() const
-{
-    return length;
-}
-
-
-
-void Snake::move()
-{
-    if (pos.empty())
-    {
-        return;
-    }
-
-    Vec2 coord = pos.back();
-
-    switch (direction)
-    {
-        case (LEFT) :
-            --coord.x;
-            break;
-        case (RIGHT) :
-            ++coord.x;
-            break;
-        case (UP) :
-            --coord.y;
-            break;
-        case (DOWN) :
-            ++coord.y;
-            break;
-    }
-
-    display->moveSnakeHead(pos.back(), coord, snakeTextures);
-    if (pos.size() > 1)
-    {
-        std::list<Vec2>::iterator start = ++pos.begin();
-        std::list<Vec2>::iterator stop = --pos.end();
-        for (std::list<Vec2>::iterator it = start; it != stop;)
-        {
-            display->moveSnakeBody(*it, *(++it), snakeTextures);
-        }
-        if (length <= pos.size())
-        {
-            display->moveSnakeTail(pos.front(), *(start), snakeTextures);
-        }
-    }
-    else
-    {
-        display->drawTexture(TEXTURE_BACKGROUND, pos.back());
-    }
-
-    // remove at tail but not if length increased
-    if (length <= pos.size())
-    {
-        pos.pop_front();
-    }
-
-    pos.push_back(coord);
-
-    return;
-}
-
-
-
-void Snake::setDirection(Direction_t newDirection)
-{
-    if ( ( (newDirection == LEFT && direction != RIGHT) ||
-           (newDirection == RIGHT && direction != LEFT) ||
-           (newDirection == UP && direction != DOWN) ||
-           (newDirection == DOWN && direction != UP)
-         ) ||
-         (length == 1)
-       )
-    {
-        direction = newDirection;
-    }
-}
-
-}
+
+#include "snake.h"
+
+#include <vector>
+#include <cassert>
+
+#include "board.h"
+#include "display.h"
+#include "food_field.h"
+#include "pathfinder.h"
+#include "random.h"
+#include "ring_buffer.h"
+
+
+namespace ssnake
+{
+
+Snake::Snake(Display* displayHandle,
+             Board* boardHandle,
+             const SnakeTextureList& textureList,
+             const Vec2& startingPos,
+             const size_t startingLength)
+{
+    display = displayHandle;
+    board = boardHandle;
+
+    id = board->addSnake(this);
+
+    Vec2 win = {board->getSize_x(), board->getSize_y()};
+
+    snakeTextures = textureList;
+
+    // starting directions depend on starting postions
+    // so don't immediately face a wall
+    if (startingPos.x < (win.x / 2))
+    {
+        direction = RIGHT;
+    }
+    else
+    {
+        direction = LEFT;
+    }
+
+    // For now, truncate requested length if length doesn't fit
+    if (static_cast<size_t>(startingPos.x) < startingLength)
+    {
+        length = startingPos.x;
+    }
+    else
+    {
+        length = startingLength;
+    }
+
+    // initialize positions
+    int directionModifier = 1;
+    if (direction == RIGHT)
+    {
+        directionModifier = -1;
+    }
+    for (int i = length - 1; i >= 0; --i)
+    {
+        Vec2 coord;
+        coord.x = startingPos.x + directionModifier*i;
+        coord.y = startingPos.y;
+        if (coord.x > 0 && coord.x < win.x && coord.y > 0 && coord.y < win.y)
+        {
+            board->setSnake(coord, id, tailSegment + pos.size());
+            pos.push_back(coord);
+        }
+    }
+}
+
+
+
+Snake::Snake(Display* displayHandle,
+             Board* boardHandle,
+             const SnakeTextureList& textureList,
+             const std::vector<Vec2>& body,
+             Direction_t startingDirection)
+{
+    display = displayHandle;
+    board = boardHandle;
+
+    id = board->addSnake(this);
+
+    snakeTextures = textureList;
+    direction = startingDirection;
+    length = body.size();
+
+    for (size_t i = 0; i < body.size(); ++i)
+    {
+        board->setSnake(body[i], id, tailSegment + pos.size());
+        pos.push_back(body[i]);
+    }
+}
+
+
+
+Snake::Snake(Display* displayHandle,
+             Board* boardHandle,
+             const SnakeState& state,
+             const std::vector<Vec2>& bodies)
+{
+    display = displayHandle;
+    board = boardHandle;
+
+    loadState(state, bodies);
+}
+
+
+
+Snake::~Snake()
+{
+    for (size_t i = 0; i < pos.size(); ++i)
+    {
+        board->clearSnake(pos[i], id, tailSegment + i);
+    }
+
+    board->removeSnake(id);
+}
+
+
+
+void Snake::ai_getDirection(const std::vector<Vec2>& foodList, Random& rng)
+{
+    if (pos.empty())
+    {
+        return;
+    }
+
+    Vec2 coord = pos.back();
+    Vec2 win = {board->getSize_x(), board->getSize_y()};
+
+    Direction_t ai_dir = direction;
+    Direction_t newDir = ai_dir;
+
+    int xOffset = win.x - coord.x;
+    int yOffset = win.y - coord.y;
+
+    // prevent hitting wall
+    if (coord.x < 4 || coord.y < 4 || xOffset < 4 || yOffset < 4)
+    {
+        if (ai_dir != LEFT && coord.x < 4)
+        {
+            newDir = RIGHT;
+        }
+        else if (ai_dir != RIGHT && xOffset < 4)
+        {
+            newDir = LEFT;
+        }
+        if (ai_dir != UP && coord.y < 4)
+        {
+            newDir = DOWN;
+        }
+        else if (ai_dir != DOWN && yOffset < 4)
+        {
+            newDir = UP;
+        }
+        // if can't go backwards have to do multi-step turn around
+        if ((ai_dir == LEFT && coord.x < 4) || (ai_dir == RIGHT && xOffset < 4))
+        {
+            if (rng.below(2) == 1 && coord.y > 4)
+            {
+                newDir = UP;
+            }
+            else if (yOffset > 4)
+            {
+                newDir = DOWN;
+            }
+            else
+            {
+                newDir = UP;
+            }
+        }
+        if ((ai_dir == UP && coord.y < 4) || (ai_dir == DOWN && yOffset < 4))
+        {
+            if (rng.below(2) == 1 && coord.x > 4)
+            {
+                newDir = RIGHT;
+            }
+            else if (xOffset > 4)
+            {
+                newDir = LEFT;
+            }
+            else
+            {
+                newDir = RIGHT;
+            }
+        }
+    } // end if (coord.x < 4 || coord.y < 4 || xOffset < 4 || yOffset < 4)
+    else // not near wall, so evasive maneuvers not required, do something else
+    {
+        // random movement every so often
+        if (coord.x > 3 && coord.y > 3 && xOffset > 3 && yOffset > 3)
+        {
+            int randn = rng.below(16);
+            if (ai_dir == DOWN || ai_dir == UP)
+            {
+                if (randn == 1)
+                {
+                    newDir = LEFT;
+                }
+                else if (randn == 2)
+                {
+                    newDir = RIGHT;
+                }
+            }
+            else
+            {
+                if (randn == 1)
+                {
+                    newDir = UP;
+                }
+                else if (randn == 2)
+                {
+                    newDir = DOWN;
+                }
+            }
+        }
+
+        // Only go for food if close to it and not near a wall
+        for (std::vector<Vec2>::const_iterator food = foodList.cbegin(); food != foodList.cend(); ++food)
+        {
+            if (ai_dir != LEFT && (food->x - coord.x) <= 3 && food->x > coord.x && food->x <= (win.x-4))
+            {
+                newDir = RIGHT;
+                break;
+            }
+            else if (ai_dir != RIGHT && (coord.x - food->x) <= 3 && coord.x > food->x && food->x >= 4)
+            {
+                newDir = LEFT;
+                break;
+            }
+            else if (ai_dir != DOWN && (coord.y - food->y) <= 3 && coord.y > food->y && food->y >= 4)
+            {
+                newDir = UP;
+                break;
+            }
+            else if (ai_dir != UP && (food->y - coord.y) <= 3 && food->y > coord.y && food->y <= (win.y-4))
+            {
+                newDir = DOWN;
+                break;
+            }
+        }
+    }
+
+    direction = newDir;
+
+    return;
+}
+
+
+
+void Snake::ai_findPath(Pathfinder& pathfinder)
+{
+    if (pos.empty())
+    {
+        return;
+    }
+
+    Direction_t newDir = direction;
+    if (pathfinder.findDirection(*board, pos.back(), newDir))
+    {
+        setDirection(ai_avoidTrap(newDir));
+    }
+}
+
+
+
+void Snake::ai_followField(const FoodField& field)
+{
+    if (pos.empty())
+    {
+        return;
+    }
+
+    const Direction_t directions[4] = {RIGHT, LEFT, UP, DOWN};
+    const Vec2 offsets[4] = {{1, 0}, {-1, 0}, {0, -1}, {0, 1}};
+
+    Vec2 head = pos.back();
+    Direction_t newDir = direction;
+    std::uint32_t bestDistance = FoodField::unreachable;
+    bool found = false;
+    for (int d = 0; d < 4; ++d)
+    {
+        Vec2 next = {head.x + offsets[d].x, head.y + offsets[d].y};
+
+        // The field leaves out snakes, so they are avoided here
+        std::uint32_t nextDistance = field.getDistance(next);
+        if (nextDistance == FoodField::unreachable || board->getCell(next).owner >= 0)
+        {
+            continue;
+        }
+
+        if (!found || nextDistance < bestDistance || (nextDistance == bestDistance && directions[d] == direction))
+        {
+            newDir = directions[d];
+            bestDistance = nextDistance;
+            found = true;
+        }
+    }
+
+    setDirection(found ? ai_avoidTrap(newDir) : newDir);
+}
+
+
+
+Direction_t Snake::ai_avoidTrap(Direction_t chosen) const
+{
+    Vec2 head = pos.back();
+    if (head.x <= 0 || head.y <= 0 || head.x >= board->getSize_x() - 1 || head.y >= board->getSize_y() - 1)
+    {
+        return chosen;
+    }
+
+    const Vec2 offsets[4] = {{1, 0}, {-1, 0}, {0, -1}, {0, 1}};
+    unsigned int openSteps = board->getOpenSteps(head);
+
+    // The tail moves out of the way as fast as the head moves in, so the body needs as many cells as it is long
+    std::size_t enough = length;
+    std::size_t room[4] = {0, 0, 0, 0};
+    if (openSteps & (1u << chosen))
+    {
+        room[chosen] = board->countReachable({head.x + offsets[chosen].x, head.y + offsets[chosen].y}, enough);
+        if (room[chosen] >= enough)
+        {
+            return chosen;
+        }
+    }
+
+    Direction_t best = chosen;
+    for (int d = 0; d < 4; ++d)
+    {
+        if (d == chosen || !(openSteps & (1u << d)))
+        {
+            continue;
+        }
+
+        room[d] = board->countReachable({head.x + offsets[d].x, head.y + offsets[d].y}, enough);
+        if (room[d] > room[best])
+        {
+            best = static_cast<Direction_t>(d);
+        }
+    }
+
+    return best;
+}
+
+
+
+Collision_t Snake::checkCollision()
+{
+    // head collision with other snake will leave snake empty from checkslice
+    if (pos.empty())
+    {
+        return COLLISION_EATEN;
+    }
+
+    Vec2 win = {board->getSize_x(), board->getSize_y()};
+
+    Vec2 head = pos.back();
+
+    // wall collision
+    if (head.x >= (win.x - 1) || head.x <= 0 || head.y >= (win.y - 1) || head.y <= 0)
+    {
+        display->drawTexture(TEXTURE_COLLISION, head);
+
+        return COLLISION_WALL;
+    }
+
+
+    // self collision
+    // If checkSlice with itself happens first, then any collision segment will be removed
+    // It isn't possible to self-hit segments just before the head
+    unsigned int headSegment = tailSegment + pos.size() - 1;
+    if (headHit.owner == id && headSegment - headHit.segment >= 4)
+    {
+        return COLLISION_SELF;
+    }
+
+    return COLLISION_NONE;
+}
+
+
+
+bool Snake::checkFood(const Vec2& food)
+{
+    if (pos.empty())
+    {
+        return false;
+    }
+
+    Vec2 snakeHead = pos.back();
+
+    if (snakeHead.y != food.y || snakeHead.x != food.x)
+    {
+        return false;
+    }
+
+    ++length;
+
+    return true;
+}
+
+
+
+bool Snake::checkFood(unsigned int& foodIndex)
+{
+    if (pos.empty() || headHit.owner != OWNER_FOOD)
+    {
+        return false;
+    }
+
+    foodIndex = headHit.segment;
+    headHit.owner = OWNER_EMPTY;
+
+    ++length;
+
+    return true;
+}
+
+
+
+bool Snake::checkTouch(const Vec2& checkedPos) const
+{
+    if (pos.empty() || !board->contains(checkedPos))
+    {
+        return false;
+    }
+
+    return board->getCell(checkedPos).owner == id;
+}
+
+
+
+size_t Snake::checkSlice()
+{
+    if (pos.empty())
+    {
+        return 0;
+    }
+
+    BoardCell hit = headHit;
+    if (hit.owner < 0)
+    {
+        return 0;
+    }
+    headHit.owner = OWNER_EMPTY;
+
+    Snake* sliced = board->getSnake(hit.owner);
+    if (sliced == nullptr || sliced->pos.empty())
+    {
+        return 0;
+    }
+
+    // Position of the hit segment counting from the tail, starting at 1
+    size_t cutCount = hit.segment - sliced->tailSegment + 1;
+    if (cutCount > sliced->pos.size())
+    {
+        return 0;
+    }
+
+    // It can't actually hit the three segments behind its own head, or the head itself
+    if (sliced == this && cutCount + 4 > pos.size())
+    {
+        return 0;
+    }
+
+    assert(sliced->length >= cutCount);
+    sliced->length -= cutCount;
+
+    for (size_t i = 0; i < cutCount; ++i)
+    {
+        if (sliced->length != 0)
+        {
+            display->drawTexture(TEXTURE_BACKGROUND, sliced->pos[i]);
+        }
+        board->clearSnake(sliced->pos[i], sliced->id, sliced->tailSegment + i);
+    }
+    sliced->pos.pop_front(cutCount);
+    sliced->tailSegment += cutCount;
+
+    return cutCount;
+}
+
+
+
+void Snake::clearDisplay() const
+{
+    for (size_t i = 0; i < pos.size(); ++i)
+    {
+        if (board->contains(pos[i]) && board->getCell(pos[i]).owner == id)
+        {
+            display->drawTexture(TEXTURE_BACKGROUND, pos[i]);
+        }
+    }
+}
+
+
+
+Direction_t Snake::getDirection() const
+{
+    return direction;
+}
+
+
+
+size_t Snake::getLength() const
+{
+    return length;
+}
+
+
+
+Vec2 Snake::getHeadPosition() const
+{
+    return pos.back();
+}
+
+
+
+int Snake::getId() const
+{
+    return id;
+}
+
+
+
+bool Snake::isEaten() const
+{
+    return pos.empty();
+}
+
+
+
+void Snake::loadState(const SnakeState& state, const std::vector<Vec2>& bodies)
+{
+    assert(state.bodyBegin + state.bodySize <= bodies.size());
+
+    id = state.id;
+    direction = state.direction;
+    length = state.length;
+    tailSegment = state.tailSegment;
+    headHit = state.headHit;
+    snakeTextures = state.textures;
+
+    pos.clear();
+    for (std::uint32_t i = 0; i < state.bodySize; ++i)
+    {
+        pos.push_back(bodies[state.bodyBegin + i]);
+    }
+
+    board->attachSnake(id, this);
+}
+
+
+
+void Snake::move()
+{
+    if (pos.empty())
+    {
+        return;
+    }
+
+    Vec2 coord = pos.back();
+
+    switch (direction)
+    {
+        case (LEFT) :
+            --coord.x;
+            break;
+        case (RIGHT) :
+            ++coord.x;
+            break;
+        case (UP) :
+            --coord.y;
+            break;
+        case (DOWN) :
+            ++coord.y;
+            break;
+    }
+
+    // Body segments keep their place and texture, so only the ends are drawn, whatever the length of the snake
+    display->moveSnakeHead(pos.back(), coord, snakeTextures);
+    if (pos.size() > 1)
+    {
+        if (length <= pos.size())
+        {
+            display->moveSnakeTail(pos.front(), pos[1], snakeTextures);
+        }
+    }
+    else
+    {
+        display->drawTexture(TEXTURE_BACKGROUND, pos.back());
+    }
+
+    // remove at tail but not if length increased
+    if (length <= pos.size())
+    {
+        board->clearSnake(pos.front(), id, tailSegment);
+        pos.pop_front();
+        ++tailSegment;
+    }
+
+    // The head hits whatever is left after the tail moved out of the way
+    if (board->contains(coord))
+    {
+        headHit = board->getCell(coord);
+        board->setSnake(coord, id, tailSegment + pos.size());
+    }
+    else
+    {
+        headHit.owner = OWNER_EMPTY;
+    }
+
+    pos.push_back(coord);
+
+    return;
+}
+
+
+
+void Snake::saveState(SnakeState& state, std::vector<Vec2>& bodies) const
+{
+    state.id = id;
+    state.direction = direction;
+    state.length = static_cast<std::uint32_t>(length);
+    state.tailSegment = tailSegment;
+    state.headHit = headHit;
+    state.textures = snakeTextures;
+
+    state.bodyBegin = static_cast<std::uint32_t>(bodies.size());
+    state.bodySize = static_cast<std::uint32_t>(pos.size());
+    for (size_t i = 0; i < pos.size(); ++i)
+    {
+        bodies.push_back(pos[i]);
+    }
+}
+
+
+
+void Snake::setDirection(Direction_t newDirection)
+{
+    if ( ( (newDirection == LEFT && direction != RIGHT) ||
+           (newDirection == RIGHT && direction != LEFT) ||
+           (newDirection == UP && direction != DOWN) ||
+           (newDirection == DOWN && direction != UP)
+         ) ||
+         (length == 1)
+       )
+    {
+        direction = newDirection;
+    }
+}
+
+}
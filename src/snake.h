@@ -1,110 +1,252 @@
-
-// snake.h
-// Snakes
-
-#ifndef SLICERSNAKE_SNAKE_H
-#define SLICERSNAKE_SNAKE_H
-
-
-#include <list>
-
-#include "display.h"
-
-
-namespace ssnake
-{
-
-enum Direction_t
-{
-    RIGHT, LEFT, UP, DOWN
-};
-
-
-
-class Snake
-{
-
-public:
-
-    // PreConditions:
-    //   displayHandle points to an active display
-    //   startingPos contains a clear position within the boundaries of the display
-    //   startingLength is small enough to fit within the display given the startingPos
-    // PostConditions:
-    //   A new snake is created at the specified position with the given length and textures
-    Snake(Display* displayHandle,
-          const SnakeTextureList& textureList,
-          const Vec2& startingPos = {2, 2},
-          const size_t startingLength = 3);
-
-    // PreConditions:
-    //   The snake has a handle to an active display
-    //   foodList contains the positions of all food that could be used in the algorithm
-    // PostConditions:
-    //   The snake's direction will be set so that it will avoid collision with a wall and grab nearby food
-    void ai_getDirection(const std::list<Vec2>& foodList);
-
-    // PreConditions:
-    //   The snake has a handle to an active display
-    // PostConditions:
-    //   Returns true if the snake had a lethal collision, false if not
-    //   If the collision was with a wall, the display is instructed to draw a collision texture
-    // Does not support maps, only collision with edge of display area for now (I am leaving AI extremely simple for now)
-    bool checkCollision();
-
-    // Check to see if snake head has hit the food's coordinates. If so, the snake gets longer.
-    // PreConditions:
-    // PostConditions:
-    //   True is returned and the snake gets longer if it's head overlaps with food's position
-    bool checkFood(const Vec2& food);
-
-    // PreConditions:
-    // PostConditions:
-    //   Returns true if any part of the snake overlaps with checkedPos, false otherwise
-    bool checkTouch(const Vec2& checkedPos) const;
-
-    // PreConditions:
-    //   snakeList is populated with all snakes to be checked, including this one
-    // PostConditions:
-    //   If the snake's head has collided with any snake, the hit snake loses all pieces between the tail and collision inclusive
-    //   The total amount of lost snake pieces is returned
-    size_t checkSlice(std::list<Snake>& snakeList);
-
-    // PreConditions:
-    // PostConditions:
-    //   The current direction of the snake is returned
-    Direction_t getDirection() const;
-
-    // PreConditions:
-    // PostConditions:
-    //   If newDirection is not opposite of the current direction, or the snake is length 1, its direction becomes newDirection
-    void setDirection(Direction_t newDirection);
-
-    // PreConditions:
-    // PostConditions:
-    //   The current length of the snake is returned
-    size_t getLength() const;
-
-    // PreConditions:
-    //   The snake has a handle to an active display
-    // PostConditions:
-    //   The snake's position is updated to move in the direction of its direction property
-    //   The display is instructed to reflect the position change
-    void move();
-
-
-protected:
-
-    Display* display;
-
-    Direction_t direction;
-
-    size_t length;
-    std::list<Vec2> pos;
-
-    SnakeTextureList snakeTextures;
-};
-
-}
-
-#endif
+
+// snake.h
+// Snakes
+
+#ifndef SLICERSNAKE_SNAKE_H
+#define SLICERSNAKE_SNAKE_H
+
+
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+#include "display.h"
+#include "random.h"
+#include "ring_buffer.h"
+
+
+namespace ssnake
+{
+
+class FoodField;
+class Pathfinder;
+
+
+
+enum Direction_t
+{
+    RIGHT, LEFT, UP, DOWN
+};
+
+
+
+// Lethal collisions, COLLISION_NONE is false when used as a condition
+enum Collision_t
+{
+    COLLISION_NONE = 0, COLLISION_WALL, COLLISION_SELF, COLLISION_EATEN
+};
+
+
+
+// Flat copy of a snake, see Snake::saveState.
+// The body positions are kept in a separate list shared by all snakes of a game.
+struct SnakeState
+{
+    int id;
+    Direction_t direction;
+    std::uint32_t length;
+    std::uint32_t tailSegment;
+    BoardCell headHit;
+    SnakeTextureList textures;
+
+    // The body is bodies[bodyBegin] to bodies[bodyBegin + bodySize - 1], from tail to head
+    std::uint32_t bodyBegin;
+    std::uint32_t bodySize;
+};
+
+
+
+class Snake
+{
+
+public:
+
+    // PreConditions:
+    //   displayHandle points to an active display
+    //   boardHandle points to the board of the game the snake is in, and the board outlives the snake
+    //   startingPos contains a clear position within the boundaries of the display
+    //   startingLength is small enough to fit within the display given the startingPos
+    // PostConditions:
+    //   A new snake is created at the specified position with the given length and textures
+    //   The snake is registered with the board, and occupies the cells of its body
+    Snake(Display* displayHandle,
+          Board* boardHandle,
+          const SnakeTextureList& textureList,
+          const Vec2& startingPos = {2, 2},
+          const size_t startingLength = 3);
+
+    // PreConditions:
+    //   displayHandle and boardHandle are the same as for the other constructor
+    //   body holds adjacent clear positions inside of the border, ordered from tail to head
+    //   startingDirection does not point from the head back into the body
+    // PostConditions:
+    //   A new snake is created with exactly the given body, heading in startingDirection
+    Snake(Display* displayHandle,
+          Board* boardHandle,
+          const SnakeTextureList& textureList,
+          const std::vector<Vec2>& body,
+          Direction_t startingDirection);
+
+    // PreConditions:
+    //   displayHandle and boardHandle are the same as for the other constructors
+    //   The board was restored with the state saved together with state and bodies
+    // PostConditions:
+    //   The snake is the same as the one state was saved from, and is attached to the board
+    //   Neither the board cells nor the display are changed
+    Snake(Display* displayHandle,
+          Board* boardHandle,
+          const SnakeState& state,
+          const std::vector<Vec2>& bodies);
+
+    // Snakes are registered with the board by address, so they can't be copied
+    Snake(const Snake&) = delete;
+    Snake& operator=(const Snake&) = delete;
+
+    // PreConditions:
+    // PostConditions:
+    //   The snake's cells are cleared from the board and it is unregistered
+    ~Snake();
+
+    // PreConditions:
+    //   The snake has a handle to an active display
+    //   foodList contains the positions of all food that could be used in the algorithm
+    //   rng is the random number generator of the game the snake is in
+    // PostConditions:
+    //   The snake's direction will be set so that it will avoid collision with a wall and grab nearby food
+    void ai_getDirection(const std::vector<Vec2>& foodList, Random& rng);
+
+    // PreConditions:
+    //   pathfinder is not being used by another thread
+    // PostConditions:
+    //   The snake's direction will be set to follow the shortest path to the closest food around every snake,
+    //   or towards the most open space if no food is close enough, unless that would trap the snake
+    void ai_findPath(Pathfinder& pathfinder);
+
+    // PreConditions:
+    //   field is up to date with the snake's board
+    // PostConditions:
+    //   The snake's direction will be set to the free neighbouring cell that is closest to food,
+    //   keeping its direction on ties, unless that would trap the snake
+    void ai_followField(const FoodField& field);
+
+    // PreConditions:
+    //   The snake has a handle to an active display
+    // PostConditions:
+    //   Returns the kind of lethal collision the snake had, or COLLISION_NONE if it didn't have one
+    //   If the collision was with a wall, the display is instructed to draw a collision texture
+    // Self collision is what the head ran into on the last move, unless checkSlice already handled it
+    // Does not support maps, only collision with edge of display area for now (I am leaving AI extremely simple for now)
+    Collision_t checkCollision();
+
+    // Check to see if snake head has hit the food's coordinates. If so, the snake gets longer.
+    // PreConditions:
+    // PostConditions:
+    //   True is returned and the snake gets longer if it's head overlaps with food's position
+    bool checkFood(const Vec2& food);
+
+    // Check to see if the snake's head moved onto food during its last move. If so, the snake gets longer.
+    // PreConditions:
+    // PostConditions:
+    //   True is returned, foodIndex is set to the food's index on the board, and the snake gets longer
+    //   if the snake's head moved onto food during its last move
+    //   Only reports the food once
+    bool checkFood(unsigned int& foodIndex);
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if any part of the snake overlaps with checkedPos, false otherwise
+    bool checkTouch(const Vec2& checkedPos) const;
+
+    // PreConditions:
+    //   The snake's board has all snakes that can be sliced registered, including this one
+    // PostConditions:
+    //   If the snake's head has collided with any snake, the hit snake loses all pieces between the tail and collision inclusive
+    //   The total amount of lost snake pieces is returned
+    size_t checkSlice();
+
+    // PreConditions:
+    //   The snake has a handle to an active display
+    // PostConditions:
+    //   Background is drawn over every part of the display that still shows the snake
+    void clearDisplay() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   The current direction of the snake is returned
+    Direction_t getDirection() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   If newDirection is not opposite of the current direction, or the snake is length 1, its direction becomes newDirection
+    void setDirection(Direction_t newDirection);
+
+    // PreConditions:
+    // PostConditions:
+    //   The current length of the snake is returned
+    size_t getLength() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   The position of the snake's head is returned
+    Vec2 getHeadPosition() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   The owner id of the snake's cells on the board is returned, unique among the snakes of the board
+    int getId() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns true if another snake sliced off all of the snake, then it has no head anymore
+    bool isEaten() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   state holds a copy of the snake, with its body added to the end of bodies
+    void saveState(SnakeState& state, std::vector<Vec2>& bodies) const;
+
+    // PreConditions:
+    //   The board was restored with the state saved together with state and bodies
+    // PostConditions:
+    //   The snake is the same as the one state was saved from, and is attached to the board
+    //   Neither the board cells nor the display are changed
+    void loadState(const SnakeState& state, const std::vector<Vec2>& bodies);
+
+    // PreConditions:
+    //   The snake has a handle to an active display
+    // PostConditions:
+    //   The snake's position is updated to move in the direction of its direction property
+    //   The display is instructed to reflect the position change
+    void move();
+
+
+protected:
+
+    // Returns chosen if the snake's body fits in the open area it would move into,
+    // otherwise the step into the largest open area (chosen if every step is blocked)
+    Direction_t ai_avoidTrap(Direction_t chosen) const;
+
+    Display* display;
+    Board* board;
+
+    // Owner id of the snake's cells on the board
+    int id;
+
+    Direction_t direction;
+
+    size_t length;
+    // Body positions from tail (front) to head (back)
+    RingBuffer<Vec2> pos;
+
+    // Board segment number of pos.front(), the segments after it are numbered consecutively
+    unsigned int tailSegment = 0;
+
+    // What was in the cell the head moved into on the last move
+    BoardCell headHit = {OWNER_EMPTY, 0};
+
+    SnakeTextureList snakeTextures;
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+
+#include "tick_pacer.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+std::chrono::steady_clock::duration toDuration(double seconds)
+{
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+}
+
+
+
+TickPacer::TickPacer(double minPeriod, double spinTime)
+{
+    assert(minPeriod > 0.0 && spinTime >= 0.0);
+
+    this->minPeriod = toDuration(minPeriod);
+    this->spinTime = toDuration(spinTime);
+
+    restart();
+}
+
+
+
+const TickStats& TickPacer::getStats() const
+{
+    return stats;
+}
+
+
+
+std::uint64_t TickPacer::getLastLateness() const
+{
+    return lastLateness;
+}
+
+
+
+std::chrono::steady_clock::time_point TickPacer::getWakeTime() const
+{
+    return deadline - spinTime;
+}
+
+
+
+void TickPacer::restart()
+{
+    deadline = std::chrono::steady_clock::now();
+}
+
+
+
+std::chrono::steady_clock::time_point TickPacer::schedule(double period)
+{
+    std::chrono::steady_clock::duration periodTime = toDuration(period);
+    if (periodTime < minPeriod)
+    {
+        periodTime = minPeriod;
+    }
+
+    deadline += periodTime;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (deadline < now)
+    {
+        ++stats.overruns;
+        deadline = now;
+    }
+
+    return deadline;
+}
+
+
+
+std::chrono::steady_clock::time_point TickPacer::startTick()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    while (now < deadline)
+    {
+        now = std::chrono::steady_clock::now();
+    }
+
+    lastLateness = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline).count());
+    ++stats.ticks;
+    stats.totalLateness += lastLateness;
+    if (lastLateness > stats.maxLateness)
+    {
+        stats.maxLateness = lastLateness;
+    }
+
+    return now;
+}
+
+}
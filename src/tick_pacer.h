@@ -0,0 +1,97 @@
+
+// tick_pacer.h
+// Paces the steps of the game loop against absolute deadlines
+//
+
+#ifndef SLICERSNAKE_TICK_PACER_H
+#define SLICERSNAKE_TICK_PACER_H
+
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace ssnake
+{
+
+// How well ticks kept to their schedule
+struct TickStats
+{
+    std::uint64_t ticks = 0;
+    // Ticks that were already due when they were scheduled, because the tick before them ran too long
+    std::uint64_t overruns = 0;
+    // How long after their deadline ticks started, in nanoseconds
+    std::uint64_t totalLateness = 0;
+    std::uint64_t maxLateness = 0;
+};
+
+
+
+// Schedules each tick one period after the deadline of the tick before it, rather than after the time
+// it actually started, so that waking up late doesn't push back every tick after it.
+// The period can change every tick, and is never shorter than the minimum period.
+// Waiting is left to the caller (so that it can read input while it waits), which waits until the wake
+// time and then calls startTick, which spins out the rest of the way to the deadline.
+class TickPacer
+{
+
+public:
+
+    // PreConditions:
+    //   minPeriod is larger than 0, spinTime is 0 or larger (both in seconds)
+    // PostConditions:
+    //   A pacer is created that ticks no faster than every minPeriod seconds, and spins for the last spinTime seconds before each tick
+    TickPacer() : TickPacer(0.02, 0.0) {};
+    TickPacer(double minPeriod, double spinTime);
+
+    // PreConditions:
+    // PostConditions:
+    //   The next tick is scheduled from now, like at the start of a game or after a pause
+    void restart();
+
+    // PreConditions:
+    //   restart was called
+    // PostConditions:
+    //   Returns the deadline of the next tick, period seconds (or the minimum period) after the last one
+    //   If that deadline already passed, it is counted as an overrun and the tick is due right away instead,
+    //   so that late ticks don't all run at once to catch up
+    std::chrono::steady_clock::time_point schedule(double period);
+
+    // PreConditions:
+    //   schedule was called
+    // PostConditions:
+    //   Returns the time to wait until before calling startTick
+    std::chrono::steady_clock::time_point getWakeTime() const;
+
+    // PreConditions:
+    //   schedule was called
+    // PostConditions:
+    //   Spins until the deadline if it hasn't passed, then counts the tick and how late it started
+    //   Returns the time the tick started
+    std::chrono::steady_clock::time_point startTick();
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns how late the last tick started in nanoseconds, 0 if there were no ticks
+    std::uint64_t getLastLateness() const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns how the ticks since the pacer was created kept to their schedule
+    const TickStats& getStats() const;
+
+
+private:
+
+    std::chrono::steady_clock::duration minPeriod;
+    std::chrono::steady_clock::duration spinTime;
+
+    std::chrono::steady_clock::time_point deadline;
+
+    std::uint64_t lastLateness = 0;
+    TickStats stats;
+};
+
+}
+
+#endif
@@ -0,0 +1,257 @@
+
+#include "tick_profiler.h"
+
+#ifdef SSNAKE_PROFILE
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+
+namespace ssnake
+{
+
+namespace
+{
+
+// Indexed by TickPhase_t, short enough for the game message line
+const char* phaseNames[PHASE_COUNT] = {"input", "ai", "move", "slice", "collide", "food", "render", "other", "tick", "latency", "jitter"};
+
+
+
+// Writes ns with a unit that keeps it to 3 digits or so
+void formatTime(std::uint64_t ns, char* text, std::size_t size)
+{
+    if (ns < 1000)
+    {
+        std::snprintf(text, size, "%uns", static_cast<unsigned int>(ns));
+    }
+    else if (ns < 1000000)
+    {
+        std::snprintf(text, size, "%.1fus", ns / 1e3);
+    }
+    else
+    {
+        std::snprintf(text, size, "%.1fms", ns / 1e6);
+    }
+}
+
+}
+
+
+
+const int TickProfiler::exactBuckets;
+const int TickProfiler::bucketsPerDoubling;
+const int TickProfiler::bucketCount;
+
+
+
+TickProfiler::TickProfiler()
+{
+    for (int phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        tickTimes[phase] = 0;
+        samples[phase] = 0;
+        totalTimes[phase] = 0;
+        maxTimes[phase] = 0;
+        for (int bucket = 0; bucket < bucketCount; ++bucket)
+        {
+            counts[phase][bucket] = 0;
+        }
+    }
+
+    mark();
+}
+
+
+
+void TickProfiler::addTime(TickPhase_t phase, std::uint64_t ns)
+{
+    assert(phase > PHASE_TICK && phase < PHASE_COUNT);
+
+    record(phase, ns);
+}
+
+
+
+int TickProfiler::bucketIndex(std::uint64_t ns)
+{
+    if (ns < static_cast<std::uint64_t>(exactBuckets))
+    {
+        return static_cast<int>(ns);
+    }
+
+    int topBit = 63;
+    while ((ns >> topBit) == 0)
+    {
+        --topBit;
+    }
+
+    // The 3 bits under the top bit pick the bucket within the doubling
+    int bucket = exactBuckets + (topBit - 4) * bucketsPerDoubling + static_cast<int>((ns >> (topBit - 3)) & 7);
+    return (bucket < bucketCount) ? bucket : bucketCount - 1;
+}
+
+
+
+std::uint64_t TickProfiler::bucketStart(int bucket)
+{
+    if (bucket < exactBuckets)
+    {
+        return static_cast<std::uint64_t>(bucket);
+    }
+
+    int topBit = (bucket - exactBuckets) / bucketsPerDoubling + 4;
+    std::uint64_t fraction = static_cast<std::uint64_t>((bucket - exactBuckets) % bucketsPerDoubling);
+    return (8 + fraction) << (topBit - 3);
+}
+
+
+
+void TickProfiler::dump(std::FILE* file) const
+{
+    std::fprintf(file, "ticks: %llu\n", static_cast<unsigned long long>(ticks));
+    if (ticks == 0)
+    {
+        return;
+    }
+
+    std::fprintf(file, "%-8s %10s %10s %10s %10s %10s\n", "phase", "mean", "p50", "p90", "p99", "max");
+    for (int phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        if (samples[phase] == 0)
+        {
+            continue;
+        }
+
+        TickPhase_t tickPhase = static_cast<TickPhase_t>(phase);
+        std::fprintf(file, "%-8s %10llu %10llu %10llu %10llu %10llu ns\n", phaseNames[phase],
+                     static_cast<unsigned long long>(totalTimes[phase] / samples[phase]),
+                     static_cast<unsigned long long>(getPercentile(tickPhase, 0.5)),
+                     static_cast<unsigned long long>(getPercentile(tickPhase, 0.9)),
+                     static_cast<unsigned long long>(getPercentile(tickPhase, 0.99)),
+                     static_cast<unsigned long long>(maxTimes[phase]));
+    }
+
+    for (int phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        if (samples[phase] == 0)
+        {
+            continue;
+        }
+
+        std::fprintf(file, "\n%s histogram (ns, count):\n", phaseNames[phase]);
+        for (int bucket = 0; bucket < bucketCount; ++bucket)
+        {
+            if (counts[phase][bucket] == 0)
+            {
+                continue;
+            }
+            std::fprintf(file, "  %12llu %12llu\n",
+                         static_cast<unsigned long long>(bucketStart(bucket)),
+                         static_cast<unsigned long long>(counts[phase][bucket]));
+        }
+    }
+}
+
+
+
+void TickProfiler::endTick()
+{
+    std::uint64_t tickTime = 0;
+    for (int phase = 0; phase < PHASE_TICK; ++phase)
+    {
+        tickTime += tickTimes[phase];
+    }
+    tickTimes[PHASE_TICK] = tickTime;
+
+    for (int phase = 0; phase <= PHASE_TICK; ++phase)
+    {
+        record(static_cast<TickPhase_t>(phase), tickTimes[phase]);
+        tickTimes[phase] = 0;
+    }
+
+    ++ticks;
+}
+
+
+
+void TickProfiler::formatSummary(TickPhase_t phase, char* text, std::size_t size) const
+{
+    char p50[16];
+    char p99[16];
+    formatTime(getPercentile(phase, 0.5), p50, sizeof(p50));
+    formatTime(getPercentile(phase, 0.99), p99, sizeof(p99));
+
+    std::snprintf(text, size, "%s %s/%s", phaseNames[phase], p50, p99);
+}
+
+
+
+std::uint64_t TickProfiler::getPercentile(TickPhase_t phase, double fraction) const
+{
+    if (samples[phase] == 0)
+    {
+        return 0;
+    }
+
+    // Times that are at or under the percentile, at least one
+    std::uint64_t rank = static_cast<std::uint64_t>(fraction * samples[phase]);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    std::uint64_t seen = 0;
+    for (int bucket = 0; bucket < bucketCount; ++bucket)
+    {
+        seen += counts[phase][bucket];
+        if (seen >= rank)
+        {
+            return bucketStart(bucket);
+        }
+    }
+
+    return bucketStart(bucketCount - 1);
+}
+
+
+
+std::uint64_t TickProfiler::getTickCount() const
+{
+    return ticks;
+}
+
+
+
+void TickProfiler::lap(TickPhase_t phase)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    tickTimes[phase] += static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastLap).count());
+    lastLap = now;
+}
+
+
+
+void TickProfiler::record(TickPhase_t phase, std::uint64_t ns)
+{
+    ++samples[phase];
+    ++counts[phase][bucketIndex(ns)];
+    totalTimes[phase] += ns;
+    if (ns > maxTimes[phase])
+    {
+        maxTimes[phase] = ns;
+    }
+}
+
+
+
+void TickProfiler::mark()
+{
+    lastLap = std::chrono::steady_clock::now();
+}
+
+}
+
+#endif
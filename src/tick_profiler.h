@@ -0,0 +1,131 @@
+
+// tick_profiler.h
+// Time spent in each phase of the game loop, only built with SSNAKE_PROFILE defined
+//
+
+#ifndef SLICERSNAKE_TICK_PROFILER_H
+#define SLICERSNAKE_TICK_PROFILER_H
+
+
+#ifdef SSNAKE_PROFILE
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+
+namespace ssnake
+{
+
+// Parts of a tick, PHASE_TICK is the whole tick and is not timed on its own.
+// PHASE_LATENCY is how long keys were waiting to be used by a tick, only for ticks that had any,
+// and PHASE_JITTER is how late ticks started after their deadline.
+enum TickPhase_t
+{
+    PHASE_INPUT, PHASE_AI, PHASE_MOVE, PHASE_SLICE, PHASE_COLLISION, PHASE_FOOD, PHASE_RENDER, PHASE_OTHER,
+    PHASE_TICK, PHASE_LATENCY, PHASE_JITTER, PHASE_COUNT
+};
+
+
+
+// Histograms of how long each phase took per tick.
+// Time is measured in laps: every lap charges the time since the previous one to a phase, so a tick
+// costs one clock read per phase change, and the phases always add up to the whole tick.
+// A phase that happens several times in a tick (once for every snake) is added up over the tick.
+class TickProfiler
+{
+
+public:
+
+    TickProfiler();
+
+    // PreConditions:
+    // PostConditions:
+    //   A new lap is started without charging the time since the last one, like after a pause
+    void mark();
+
+    // PreConditions:
+    // PostConditions:
+    //   The time since the last lap (or mark) is added to phase in the current tick
+    void lap(TickPhase_t phase);
+
+    // PreConditions:
+    // PostConditions:
+    //   The times of the current tick are added to the histograms, and a new tick is started
+    void endTick();
+
+    // PreConditions:
+    //   phase is PHASE_LATENCY or PHASE_JITTER
+    // PostConditions:
+    //   ns is added to the histogram of phase
+    void addTime(TickPhase_t phase, std::uint64_t ns);
+
+    // PreConditions:
+    //   fraction is in [0, 1]
+    // PostConditions:
+    //   Returns the time in nanoseconds that fraction of the times of phase were at or under,
+    //   rounded down to its histogram bucket, or 0 if there were none
+    std::uint64_t getPercentile(TickPhase_t phase, double fraction) const;
+
+    // PreConditions:
+    // PostConditions:
+    //   Returns the number of ticks that were ended
+    std::uint64_t getTickCount() const;
+
+    // PreConditions:
+    //   size is at least 1
+    // PostConditions:
+    //   text holds a short "name p50/p99" line for phase, cut to size - 1 characters
+    void formatSummary(TickPhase_t phase, char* text, std::size_t size) const;
+
+    // PreConditions:
+    //   file is open for writing
+    // PostConditions:
+    //   The percentiles and every non-empty histogram bucket of every phase are written to file
+    void dump(std::FILE* file) const;
+
+
+private:
+
+    // Times under 16 ns get a bucket each, then every doubling is split into 8 buckets (12.5% wide), up to 2^40 ns
+    static const int exactBuckets = 16;
+    static const int bucketsPerDoubling = 8;
+    static const int bucketCount = exactBuckets + (40 - 4) * bucketsPerDoubling;
+
+    static int bucketIndex(std::uint64_t ns);
+    static std::uint64_t bucketStart(int bucket);
+
+    void record(TickPhase_t phase, std::uint64_t ns);
+
+    std::chrono::steady_clock::time_point lastLap;
+
+    std::uint64_t tickTimes[PHASE_COUNT];
+
+    std::uint64_t ticks = 0;
+    std::uint64_t samples[PHASE_COUNT];
+    std::uint64_t counts[PHASE_COUNT][bucketCount];
+    std::uint64_t totalTimes[PHASE_COUNT];
+    std::uint64_t maxTimes[PHASE_COUNT];
+};
+
+}
+
+
+// Statements that profile the game loop, and compile to nothing without SSNAKE_PROFILE.
+// profiler may be nullptr, then nothing is timed
+#define SSNAKE_PROFILE_MARK(profiler) \
+    do { if ((profiler) != nullptr) { (profiler)->mark(); } } while (false)
+#define SSNAKE_PROFILE_LAP(profiler, phase) \
+    do { if ((profiler) != nullptr) { (profiler)->lap(phase); } } while (false)
+#define SSNAKE_PROFILE_END_TICK(profiler) \
+    do { if ((profiler) != nullptr) { (profiler)->endTick(); } } while (false)
+
+#else
+
+#define SSNAKE_PROFILE_MARK(profiler) do { } while (false)
+#define SSNAKE_PROFILE_LAP(profiler, phase) do { } while (false)
+#define SSNAKE_PROFILE_END_TICK(profiler) do { } while (false)
+
+#endif
+
+#endif